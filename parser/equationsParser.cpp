@@ -3,45 +3,344 @@
 #include <string>
 #include <iostream>
 #include <cmath>
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include <vector>
 
+#include "mpAllocCounter.h"
+#include "mpMemoryResource.h"
+
 using namespace std;
 using namespace mup;
 
 EQUATIONS_PARSER_START
 
+namespace {
+
+/**
+ * @brief Measures the phases of a calculation one after another into a CalcStats struct
+ *
+ * The phase running when a calculation fails is closed by the next phase, formatting
+ * the error message. Stop closes the last phase and counts the allocations.
+ */
+class PhaseTimer {
+public:
+  typedef std::chrono::steady_clock clock_type;
+
+  PhaseTimer(CalcStats &stats)
+    : m_stats(stats)
+    , m_pPhase(&stats.ConstructNs)
+    , m_allocStart(GetThreadAllocCount())
+    , m_tStart(clock_type::now())
+  {
+    m_stats = CalcStats();
+  }
+
+  void Next(unsigned long long *pPhase) {
+    clock_type::time_point t = clock_type::now();
+    if (m_pPhase)
+      *m_pPhase += (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(t - m_tStart).count();
+
+    m_pPhase = pPhase;
+    m_tStart = t;
+  }
+
+  void Stop() {
+    Next(0);
+
+    AllocCount alloc = GetThreadAllocCount();
+    m_stats.Allocations = alloc.Count - m_allocStart.Count;
+    m_stats.AllocatedBytes = alloc.Bytes - m_allocStart.Bytes;
+  }
+
+private:
+  CalcStats &m_stats;
+  unsigned long long *m_pPhase;
+  AllocCount m_allocStart;
+  clock_type::time_point m_tStart;
+};
+
+std::atomic<bool> g_calcArena(false);
+
+/**
+ * @brief Allocates the tokens of a calculation from an arena of the calling thread
+ *
+ * The arena is released in one operation when the outermost calculation of the thread
+ * ends. Calculations nested in it, like the ones of the calculate function, allocate
+ * from the same arena. The scope must be created before the parser and destroyed after it.
+ */
+class CalcArenaScope {
+public:
+  CalcArenaScope()
+    : m_bActive(s_depth == 0 && g_calcArena.load(std::memory_order_relaxed))
+    , m_pPrev(0)
+  {
+    if (m_bActive)
+      m_pPrev = SetThreadMemoryResource(&GetArena());
+
+    ++s_depth;
+  }
+
+  ~CalcArenaScope() {
+    --s_depth;
+    if (m_bActive) {
+      SetThreadMemoryResource(m_pPrev);
+      GetArena().Release();
+    }
+  }
+
+private:
+  CalcArenaScope(const CalcArenaScope &ref);
+  CalcArenaScope& operator=(const CalcArenaScope &ref);
+
+  static MonotonicBufferResource& GetArena() {
+    static thread_local MonotonicBufferResource arena(16384);
+    return arena;
+  }
+
+  static thread_local unsigned s_depth;  ///< Number of calculations running in the thread
+
+  bool m_bActive;
+  MemoryResource *m_pPrev;
+};
+
+thread_local unsigned CalcArenaScope::s_depth = 0;
+
+/**
+ * @brief Tokenizes and compiles the expression of a parser, timing both phases
+ *
+ * Errors found while tokenizing are left to the compilation, which reports the first
+ * error in the order of the expression like an evaluation without these phases.
+ */
+void CompileTimed(ParserX &parser, PhaseTimer &timer, CalcStats &stats) {
+  timer.Next(&stats.TokenizeNs);
+  try
+  {
+    parser.GetExprVar();
+  }
+  catch(ParserError &)
+  {}
+
+  timer.Next(&stats.CompileNs);
+  parser.Compile();
+}
+
+/**
+ * @brief Bounded ring buffer of the calculations slower than a threshold
+ *
+ * Only every n-th calculation of each thread is checked against the threshold, so that
+ * the cost of dumping slow formulas stays bounded when many of them are slow.
+ */
+class SlowFormulaLog {
+public:
+  SlowFormulaLog()
+    : m_thresholdNs(0)
+    , m_sampleEvery(1)
+    , m_mtx()
+    , m_entries()
+    , m_next(0)
+    , m_size(0)
+  {}
+
+  void Configure(unsigned long long thresholdNs, unsigned sampleEvery, std::size_t capacity) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_entries.assign(capacity, SlowFormula());
+    m_next = 0;
+    m_size = 0;
+    m_sampleEvery = (sampleEvery) ? sampleEvery : 1;
+    m_thresholdNs = thresholdNs;
+  }
+
+  unsigned long long GetThreshold() const {
+    return m_thresholdNs.load(std::memory_order_relaxed);
+  }
+
+  bool IsSampled() const {
+    static thread_local unsigned calls = 0;
+    return GetThreshold() != 0 && ++calls % m_sampleEvery.load(std::memory_order_relaxed) == 0;
+  }
+
+  void Add(const SlowFormula &entry) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if (m_entries.empty())
+      return;
+
+    m_entries[m_next] = entry;
+    m_next = (m_next + 1) % m_entries.size();
+    if (m_size < m_entries.size())
+      ++m_size;
+  }
+
+  vector<SlowFormula> Drain() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+
+    // Oldest entry first
+    vector<SlowFormula> entries;
+    for (std::size_t i = 0; i < m_size; ++i)
+      entries.push_back(m_entries[(m_next + m_entries.size() - m_size + i) % m_entries.size()]);
+
+    m_size = 0;
+    return entries;
+  }
+
+private:
+  std::atomic<unsigned long long> m_thresholdNs;  ///< Zero if the log is disabled
+  std::atomic<unsigned> m_sampleEvery;
+  std::mutex m_mtx;
+  vector<SlowFormula> m_entries;
+  std::size_t m_next;                             ///< Index of the slot written next
+  std::size_t m_size;                             ///< Number of entries held
+};
+
+SlowFormulaLog& GetSlowFormulaLog() {
+  static SlowFormulaLog log;
+  return log;
+}
+
+/**
+ * @brief Adds a calculation to the slow formula log if it is sampled and slower than the threshold
+ */
+void LogIfSlow(const ParserX &parser, const string &input, const CalcStats &stats) {
+  SlowFormulaLog &log = GetSlowFormulaLog();
+  if (!log.IsSampled())
+    return;
+
+  unsigned long long totalNs = stats.ConstructNs + stats.TokenizeNs + stats.CompileNs + stats.EvalNs + stats.FormatNs;
+  if (totalNs < log.GetThreshold())
+    return;
+
+  SlowFormula entry;
+  entry.Expr = input;
+  entry.Stats = stats;
+
+  stringstream_type ss;
+  parser.DumpRPN(ss);
+  entry.RPN = ss.str();
+
+  try
+  {
+    const var_maptype &vars = parser.GetExprVar();
+    for (var_maptype::const_iterator it = vars.begin(); it != vars.end(); ++it)
+      entry.VarTypes[it->first] = it->second->AsIValue()->GetType();
+  }
+  catch(ParserError &)
+  {}
+
+  log.Add(entry);
+}
+
+} // anonymous namespace
+
+/**
+ * @brief Starts capturing calculations slower than a threshold, discarding all captured so far
+ * @param thresholdNs The minimal duration of a calculation captured in nanoseconds
+ * @param sampleEvery Only every n-th calculation of each thread is checked against the threshold
+ * @param capacity The number of calculations kept, the oldest is replaced when the log is full
+ */
+void EnableSlowFormulaLog(unsigned long long thresholdNs, unsigned sampleEvery, std::size_t capacity) {
+  GetSlowFormulaLog().Configure((thresholdNs) ? thresholdNs : 1, sampleEvery, capacity);
+}
+
+/**
+ * @brief Stops capturing slow calculations and discards all captured so far
+ */
+void DisableSlowFormulaLog() {
+  GetSlowFormulaLog().Configure(0, 1, 0);
+}
+
+/**
+ * @brief Returns the slow calculations captured since the last call, oldest first
+ */
+vector<SlowFormula> DrainSlowFormulas() {
+  return GetSlowFormulaLog().Drain();
+}
+
+/**
+ * @brief Allocates the tokens of each calculation from an arena released when it ends
+ * @param enable True to use a monotonic arena per thread, false to use the memory resource
+ * installed by mup::SetThreadMemoryResource
+ */
+void EnableCalcArena(bool enable) {
+  g_calcArena.store(enable, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns true if calculations allocate their tokens from an arena
+ */
+bool IsCalcArenaEnabled() {
+  return g_calcArena.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Creates empty statistics
+ */
+CalcStats::CalcStats()
+  : ConstructNs(0)
+  , TokenizeNs(0)
+  , CompileNs(0)
+  , EvalNs(0)
+  , FormatNs(0)
+  , Allocations(0)
+  , AllocatedBytes(0)
+{}
+
 /**
  * @brief Evaluates an input string as a mathematical expression and returns the result
  * @param input The string to be evaluated as a mathematical expression
  */
 string Calc(string input) {
+  CalcStats stats;
+  return Calc(input, stats);
+}
+
+/**
+ * @brief Evaluates an input string as a mathematical expression and returns the result
+ * @param input The string to be evaluated as a mathematical expression
+ * @param stats Receives the time spent in each phase and the heap allocations made
+ */
+string Calc(string input, CalcStats &stats) {
+  CalcArenaScope arena;
+  PhaseTimer timer(stats);
   ParserX parser(pckALL_NON_COMPLEX);
+  parser.EnableSharedValueCache(true);
 
   Value ans;
   parser.DefineVar(_T("ans"), Variable(&ans));
 
+  string_type result;
   try
   {
     parser.SetExpr(input);
+    CompileTimed(parser, timer, stats);
+
+    timer.Next(&stats.EvalNs);
     ans = parser.Eval();
 
-    return ans.AsString();
+    timer.Next(&stats.FormatNs);
+    result = ans.AsString();
   }
   catch(ParserError &e)
   {
+    timer.Next(&stats.FormatNs);
     if (e.GetPos() != -1) {
-      string_type error = "Error: ";
-      error.append(e.GetMsg());
-      return error;
+      result = "Error: ";
+      result.append(e.GetMsg());
+    }
+    else {
+      result = ans.AsString();
     }
   }
   catch(std::runtime_error & ex)
   {
-    string_type error = "Error: Runtime error - ";
-    error.append(ex.what());
-    return error;
+    timer.Next(&stats.FormatNs);
+    result = "Error: Runtime error - ";
+    result.append(ex.what());
   }
-  return ans.AsString();
+
+  timer.Stop();
+  LogIfSlow(parser, input, stats);
+  return result;
 }
 
 /**
@@ -85,7 +384,21 @@ void ReplaceAll(std::string& source, const std::string& from, const std::string&
  * }
  */
 string CalcJson(string input) {
+  CalcStats stats;
+  return CalcJson(input, stats);
+}
+
+/**
+ * @brief Evaluates an input string as a mathematical expression and returns the result as a JSON
+ * @param input The string to be evaluated as a mathematical expression
+ * @param stats Receives the time spent in each phase and the heap allocations made
+ * @return The result of the evaluation as a JSON string, see CalcJson(string)
+ */
+string CalcJson(string input, CalcStats &stats) {
+  CalcArenaScope arena;
+  PhaseTimer timer(stats);
   ParserX parser(pckALL_NON_COMPLEX);
+  parser.EnableSharedValueCache(true);
 
   Value ans;
   parser.DefineVar(_T("ans"), Variable(&ans));
@@ -97,17 +410,23 @@ string CalcJson(string input) {
   try
   {
     parser.SetExpr(input);
+    CompileTimed(parser, timer, stats);
+
+    timer.Next(&stats.EvalNs);
     ans = parser.Eval();
 
+    timer.Next(&stats.FormatNs);
     std::string ansString = ans.AsString();
 
     ReplaceAll(ansString, "\"", "\\\"");
 
     ss << _T("\"val\": \"") << ansString << _T("\"");
-    ss << _T(",\"type\": \"") << ans.GetType() << _T("\"");
+    // Dates are written as text, the type stays the one of former versions
+    ss << _T(",\"type\": \"") << (ans.IsDate() ? _T('s') : ans.GetType()) << _T("\"");
   }
   catch(ParserError &e)
   {
+    timer.Next(&stats.FormatNs);
     if (e.GetPos() != -1) {
       string_type error = e.GetMsg();
       ss << _T("\"error\": \"") << error << _T("\"");
@@ -115,6 +434,7 @@ string CalcJson(string input) {
   }
   catch(std::runtime_error & ex)
   {
+    timer.Next(&stats.FormatNs);
     string_type error = "Error: Runtime error - ";
     error.append(ex.what());
     ss << _T("\"error\": \"") << error << _T("\"");
@@ -122,7 +442,10 @@ string CalcJson(string input) {
 
   ss << _T("}");
 
-  return ss.str();
+  string result = ss.str();
+  timer.Stop();
+  LogIfSlow(parser, input, stats);
+  return result;
 }
 
 /**
@@ -2,6 +2,8 @@
 #define EQUATIONS_PARSER_H
 
 #include <string>
+#include <map>
+#include <vector>
 //--- Parser framework -----------------------------------------------------
 #include "mpParser.h"
 #include "mpDefines.h"
@@ -11,9 +13,46 @@
 
 EQUATIONS_PARSER_START
 
+/**
+ * @brief Time spent in the phases of a calculation and the heap allocations it made
+ *
+ * Times are in nanoseconds. Allocations are counted only if the library was built with
+ * MUP_COUNT_ALLOCATIONS or the program records them by calling mup::RecordAllocation.
+ */
+struct CalcStats
+{
+  CalcStats();
+
+  unsigned long long ConstructNs;     ///< Construction of the parser
+  unsigned long long TokenizeNs;      ///< Breaking the expression up into tokens
+  unsigned long long CompileNs;       ///< Translating the tokens into reverse polish notation
+  unsigned long long EvalNs;          ///< Evaluation of the expression
+  unsigned long long FormatNs;        ///< Formatting of the result or the error message
+  unsigned long long Allocations;     ///< Number of heap allocations
+  unsigned long long AllocatedBytes;  ///< Number of bytes requested by the heap allocations
+};
+
+/**
+ * @brief A calculation that took longer than the threshold of the slow formula log
+ */
+struct SlowFormula
+{
+  std::string Expr;                      ///< The expression calculated
+  std::string RPN;                       ///< Its reverse polish notation as written by RPN::AsciiDump
+  CalcStats Stats;                       ///< Time spent in each phase
+  std::map<std::string, char> VarTypes;  ///< Type code of each variable used by the expression
+};
+
 void ReplaceAll(std::string& source, const std::string& from, const std::string& to);
+void EnableSlowFormulaLog(unsigned long long thresholdNs, unsigned sampleEvery = 1, std::size_t capacity = 64);
+void DisableSlowFormulaLog();
+std::vector<SlowFormula> DrainSlowFormulas();
+void EnableCalcArena(bool enable);
+bool IsCalcArenaEnabled();
 std::string Calc(std::string input);
+std::string Calc(std::string input, CalcStats &stats);
 std::string CalcJson(std::string input);
+std::string CalcJson(std::string input, CalcStats &stats);
 void CalcArray(std::vector<std::string> in, std::vector<std::string> &out);
 
 EQUATIONS_PARSER_END
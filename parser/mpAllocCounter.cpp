@@ -0,0 +1,107 @@
+/** \file
+    \brief Implementation of the counters of heap allocations made by each thread.
+
+<pre>
+               __________                                 ____  ___
+    _____  __ _\______   \_____ _______  ______ __________\   \/  /
+   /     \|  |  \     ___/\__  \\_  __ \/  ___// __ \_  __ \     / 
+  |  Y Y  \  |  /    |     / __ \|  | \/\___ \\  ___/|  | \/     \ 
+  |__|_|  /____/|____|    (____  /__|  /____  >\___  >__| /___/\  \
+        \/                     \/           \/     \/           \_/
+                                       Copyright (C) 2016, Ingo Berg
+                                       All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without 
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice, 
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright notice, 
+     this list of conditions and the following disclaimer in the documentation 
+     and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. 
+  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT 
+  NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+  POSSIBILITY OF SUCH DAMAGE.
+  </pre>
+*/
+
+
+#include "mpAllocCounter.h"
+
+//--- Standard includes ----------------------------------------------------
+#include <cstdlib>
+#include <new>
+
+
+MUP_NAMESPACE_START
+
+  namespace
+  {
+    // A trivial thread local type needs no construction, operator new may be
+    // called before any other initialization of the thread.
+    thread_local unsigned long long t_nAllocCount = 0;
+    thread_local unsigned long long t_nAllocBytes = 0;
+  }
+
+  //------------------------------------------------------------------------------
+  AllocCount::AllocCount()
+    :Count(0)
+    ,Bytes(0)
+  {}
+
+  //------------------------------------------------------------------------------
+  void RecordAllocation(std::size_t nBytes)
+  {
+    ++t_nAllocCount;
+    t_nAllocBytes += nBytes;
+  }
+
+  //------------------------------------------------------------------------------
+  AllocCount GetThreadAllocCount()
+  {
+    AllocCount count;
+    count.Count = t_nAllocCount;
+    count.Bytes = t_nAllocBytes;
+    return count;
+  }
+
+MUP_NAMESPACE_END
+
+#if defined(MUP_COUNT_ALLOCATIONS)
+
+//------------------------------------------------------------------------------
+//
+// Replacement of the global allocation functions counting all allocations.
+// The array and nothrow forms call these by default.
+//
+//------------------------------------------------------------------------------
+
+void* operator new(std::size_t nSize)
+{
+  mup::RecordAllocation(nSize);
+  void *p = std::malloc(nSize ? nSize : 1);
+  if (!p)
+    throw std::bad_alloc();
+
+  return p;
+}
+
+void operator delete(void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+#endif // MUP_COUNT_ALLOCATIONS
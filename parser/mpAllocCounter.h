@@ -0,0 +1,73 @@
+/** \file
+    \brief Definition of the counters of heap allocations made by each thread.
+
+<pre>
+               __________                                 ____  ___
+    _____  __ _\______   \_____ _______  ______ __________\   \/  /
+   /     \|  |  \     ___/\__  \\_  __ \/  ___// __ \_  __ \     / 
+  |  Y Y  \  |  /    |     / __ \|  | \/\___ \\  ___/|  | \/     \ 
+  |__|_|  /____/|____|    (____  /__|  /____  >\___  >__| /___/\  \
+        \/                     \/           \/     \/           \_/
+                                       Copyright (C) 2016, Ingo Berg
+                                       All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without 
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice, 
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright notice, 
+     this list of conditions and the following disclaimer in the documentation 
+     and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. 
+  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT 
+  NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+  POSSIBILITY OF SUCH DAMAGE.
+  </pre>
+*/
+
+
+#ifndef MUP_ALLOC_COUNTER_H
+#define MUP_ALLOC_COUNTER_H
+
+#include <cstddef>
+
+#include "mpDefines.h"
+
+
+MUP_NAMESPACE_START
+
+  //------------------------------------------------------------------------------
+  /** \brief Number and size of the heap allocations of a thread. */
+  struct AllocCount
+  {
+    AllocCount();
+
+    unsigned long long Count;  ///< Number of allocations
+    unsigned long long Bytes;  ///< Number of bytes requested by all allocations
+  };
+
+  /** \brief Adds an allocation to the counters of the calling thread.
+
+    Called by the replacement of the global operator new the library defines
+    if MUP_COUNT_ALLOCATIONS is set. Programs replacing operator new on their
+    own may call it instead.
+  */
+  void RecordAllocation(std::size_t nBytes);
+
+  /** \brief Returns the allocations of the calling thread since it started. 
+  
+    The counters stay zero unless allocations are recorded by RecordAllocation.
+  */
+  AllocCount GetThreadAllocCount();
+
+MUP_NAMESPACE_END
+
+#endif
@@ -0,0 +1,303 @@
+/** \file
+    \brief Implementation of the calendar arithmetic used by date values.
+
+<pre>
+               __________                                 ____  ___
+    _____  __ _\______   \_____ _______  ______ __________\   \/  /
+   /     \|  |  \     ___/\__  \\_  __ \/  ___// __ \_  __ \     / 
+  |  Y Y  \  |  /    |     / __ \|  | \/\___ \\  ___/|  | \/     \ 
+  |__|_|  /____/|____|    (____  /__|  /____  >\___  >__| /___/\  \
+        \/                     \/           \/     \/           \_/
+                                       Copyright (C) 2016, Ingo Berg
+                                       All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without 
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice, 
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright notice, 
+     this list of conditions and the following disclaimer in the documentation 
+     and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. 
+  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT 
+  NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+  POSSIBILITY OF SUCH DAMAGE.
+  </pre>
+*/
+
+
+#include "mpDate.h"
+
+//--- Standard includes ----------------------------------------------------
+#include <cmath>
+
+
+MUP_NAMESPACE_START
+
+namespace
+{
+  /** \brief Rata die of 1970-01-01. */
+  const int_type EPOCH_RATA_DIE = 719163;
+
+  //------------------------------------------------------------------------------
+  /** \brief Read a number of one up to nMax digits.
+      \return true if at least one digit was read.
+  */
+  bool ReadNumber(const char_type *&p, int nMax, int &val)
+  {
+    val = 0;
+    int n = 0;
+    for (; n < nMax && *p >= '0' && *p <= '9'; ++n, ++p)
+      val = val * 10 + (*p - '0');
+
+    return n > 0;
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Append a number with at least nMin digits, padded with zeros. */
+  void AppendNumber(string_type &s, int val, int nMin = 2)
+  {
+    if (val < 0)
+    {
+      s += '-';
+      val = -val;
+    }
+
+    string_type sVal = std::to_string(val);
+    if ((int)sVal.size() < nMin)
+      s.append(nMin - sVal.size(), '0');
+
+    s += sVal;
+  }
+} // anonymous namespace
+
+  //------------------------------------------------------------------------------
+  /** \brief Returns the number of days since 0000-12-31.
+      \sa https://en.wikipedia.org/wiki/Rata_Die
+  */
+  int rata_die(int y, int m, int d)
+  {
+    if (m < 3)
+      y--, m += 12;
+    return 365*y + y/4 - y/100 + y/400 + (153*m - 457)/5 + d - 306;
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Returns the number of days since 1970-01-01. */
+  int_type DaysFromCivil(int y, int m, int d)
+  {
+    return rata_die(y, m, d) - EPOCH_RATA_DIE;
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Returns the calendar date of a number of days since 1970-01-01. 
+      \sa http://howardhinnant.github.io/date_algorithms.html
+  */
+  void CivilFromDays(int_type nDays, int &y, int &m, int &d)
+  {
+    int_type z = nDays + 719468,
+             era = ((z >= 0) ? z : z - 146096) / 146097,
+             doe = z - era * 146097,
+             yoe = (doe - doe/1460 + doe/36524 - doe/146096) / 365,
+             doy = doe - (365*yoe + yoe/4 - yoe/100),
+             mp  = (5*doy + 2) / 153;
+
+    d = (int)(doy - (153*mp + 2)/5 + 1);
+    m = (int)((mp < 10) ? mp + 3 : mp - 9);
+    y = (int)(yoe + era * 400 + ((m <= 2) ? 1 : 0));
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Returns the number of days since 1970-01-01 of the day a date or 
+             date time falls on.
+  */
+  int_type DaysOfDate(const date_type &date)
+  {
+    return (date.IsTime) ? (int_type)std::floor(date.Val / SECONDS_PER_DAY) : (int_type)date.Val;
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Returns the number of seconds since 1970-01-01T00:00 of a date or
+             date time. Dates start at midnight.
+  */
+  float_type SecondsOfDate(const date_type &date)
+  {
+    return (date.IsTime) ? date.Val : date.Val * SECONDS_PER_DAY;
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Returns the day of the week, 0 for sunday. */
+  int WeekdayFromDays(int_type nDays)
+  {
+    // 1970-01-01 was a thursday
+    return (int)((nDays % 7 + 11) % 7);
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Read a date in the format "yyyy-mm-dd" or a date time in the format
+             "yyyy-mm-ddTHH:MM" or "yyyy-mm-ddTHH:MM:SS".
+      \param sDate The string to read.
+      \param date [out] The date read.
+      \return false if sDate is not a date or date time.
+
+    Like strptime this does not check the number of days of the month, 
+    "2019-02-30" reads as "2019-03-02".
+  */
+  bool ParseDate(const string_type &sDate, date_type &date)
+  {
+    const char_type *p = sDate.c_str();
+    int y, m, d;
+
+    // The year has exactly four digits
+    if (!ReadNumber(p, 4, y) || p != sDate.c_str() + 4 || *p++ != '-' ||
+        !ReadNumber(p, 2, m) || *p++ != '-' ||
+        !ReadNumber(p, 2, d) || m < 1 || m > 12 || d < 1 || d > 31)
+      return false;
+
+    int_type nDays = DaysFromCivil(y, m, d);
+    if (*p == 0)
+    {
+      date = date_type((float_type)nDays, false);
+      return true;
+    }
+
+    int h, min, sec = 0;
+    if (*p++ != 'T' ||
+        !ReadNumber(p, 2, h) || *p++ != ':' ||
+        !ReadNumber(p, 2, min) || h > 23 || min > 59)
+      return false;
+
+    // The seconds are optional
+    if (*p == ':' && (!ReadNumber(++p, 2, sec) || sec > 59))
+      return false;
+
+    if (*p != 0)
+      return false;
+
+    date = date_type((float_type)nDays * SECONDS_PER_DAY + h * 3600 + min * 60 + sec, true);
+    return true;
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Returns a date as "yyyy-mm-dd" or a date time as "yyyy-mm-ddTHH:MM".
+
+    The seconds of a date time are appended as ":SS" unless they are zero.
+  */
+  string_type FormatDate(const date_type &date)
+  {
+    int_type nDays = DaysOfDate(date);
+
+    int y, m, d;
+    CivilFromDays(nDays, y, m, d);
+
+    string_type s;
+    AppendNumber(s, y, 4);
+    s += '-';
+    AppendNumber(s, m);
+    s += '-';
+    AppendNumber(s, d);
+
+    if (date.IsTime)
+    {
+      int nSec = (int)(date.Val - (float_type)nDays * SECONDS_PER_DAY);
+      s += 'T';
+      AppendNumber(s, nSec / 3600);
+      s += ':';
+      AppendNumber(s, nSec / 60 % 60);
+
+      if (nSec % 60)
+      {
+        s += ':';
+        AppendNumber(s, nSec % 60);
+      }
+    }
+
+    return s;
+  }
+
+  //------------------------------------------------------------------------------
+  //
+  //  Kernels for batches of dates
+  //
+  //  The loops have no calls that can not be inlined and no branches other than
+  //  selections, so the compiler is free to vectorize them. The date functions
+  //  use them for single values as well, which keeps one implementation.
+  //
+  //------------------------------------------------------------------------------
+
+  /** \brief Computes the days since 1970-01-01 of a batch of dates and date times. */
+  void DaysOfDates(const date_type *pDate, int_type *pDays, int nSize)
+  {
+    for (int i = 0; i < nSize; ++i)
+      pDays[i] = DaysOfDate(pDate[i]);
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Computes the seconds since 1970-01-01T00:00 of a batch of dates and 
+             date times.
+  */
+  void SecondsOfDates(const date_type *pDate, float_type *pSec, int nSize)
+  {
+    for (int i = 0; i < nSize; ++i)
+      pSec[i] = SecondsOfDate(pDate[i]);
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Computes the number of days between two batches of days, regardless 
+             of their order. 
+  */
+  void DaysDiff(const int_type *pDays1, const int_type *pDays2, int_type *pOut, int nSize)
+  {
+    for (int i = 0; i < nSize; ++i)
+    {
+      int_type nDiff = pDays1[i] - pDays2[i];
+      pOut[i] = (nDiff < 0) ? -nDiff : nDiff;
+    }
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Computes the hours from one batch of seconds to another, rounded to
+             two decimals.
+  */
+  void HoursDiff(const float_type *pSec1, const float_type *pSec2, float_type *pOut, int nSize)
+  {
+    for (int i = 0; i < nSize; ++i)
+      pOut[i] = std::round((pSec2[i] - pSec1[i]) / 3600 * 100) / 100;
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Computes the days of the week of a batch of days, 0 for sunday. */
+  void Weekdays(const int_type *pDays, int_type *pOut, int nSize)
+  {
+    for (int i = 0; i < nSize; ++i)
+      pOut[i] = WeekdayFromDays(pDays[i]);
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Computes the weeks of the year of a batch of days.
+
+    Weeks start on sunday, the week containing the first thursday of the year is
+    week 1. Days before it are counted as week 53 of the previous year.
+  */
+  void WeeksOfYear(const int_type *pDays, int_type *pOut, int nSize)
+  {
+    for (int i = 0; i < nSize; ++i)
+    {
+      int y, m, d;
+      CivilFromDays(pDays[i], y, m, d);
+
+      int_type nDayOfYear = pDays[i] - DaysFromCivil(y, 1, 1) + 1,
+               nWeek = (nDayOfYear - WeekdayFromDays(pDays[i]) + 10) / 7;
+      pOut[i] = (nWeek == 0) ? 53 : nWeek;
+    }
+  }
+
+MUP_NAMESPACE_END
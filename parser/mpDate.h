@@ -0,0 +1,68 @@
+/** \file
+    \brief Definition of the calendar arithmetic used by date values.
+
+<pre>
+               __________                                 ____  ___
+    _____  __ _\______   \_____ _______  ______ __________\   \/  /
+   /     \|  |  \     ___/\__  \\_  __ \/  ___// __ \_  __ \     / 
+  |  Y Y  \  |  /    |     / __ \|  | \/\___ \\  ___/|  | \/     \ 
+  |__|_|  /____/|____|    (____  /__|  /____  >\___  >__| /___/\  \
+        \/                     \/           \/     \/           \_/
+                                       Copyright (C) 2016, Ingo Berg
+                                       All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without 
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice, 
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright notice, 
+     this list of conditions and the following disclaimer in the documentation 
+     and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. 
+  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT 
+  NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+  POSSIBILITY OF SUCH DAMAGE.
+  </pre>
+*/
+
+#ifndef MUP_DATE_H
+#define MUP_DATE_H
+
+#include "mpTypes.h"
+
+
+MUP_NAMESPACE_START
+
+  /** \brief Number of seconds of a day. */
+  const int SECONDS_PER_DAY = 24 * 60 * 60;
+
+  int rata_die(int y, int m, int d);
+
+  int_type DaysFromCivil(int y, int m, int d);
+  void CivilFromDays(int_type nDays, int &y, int &m, int &d);
+  int_type DaysOfDate(const date_type &date);
+  float_type SecondsOfDate(const date_type &date);
+  int WeekdayFromDays(int_type nDays);
+
+  bool ParseDate(const string_type &sDate, date_type &date);
+  string_type FormatDate(const date_type &date);
+
+  // Kernels working on batches of dates stored in contiguous arrays
+  void DaysOfDates(const date_type *pDate, int_type *pDays, int nSize);
+  void SecondsOfDates(const date_type *pDate, float_type *pSec, int nSize);
+  void DaysDiff(const int_type *pDays1, const int_type *pDays2, int_type *pOut, int nSize);
+  void HoursDiff(const float_type *pSec1, const float_type *pSec2, float_type *pOut, int nSize);
+  void Weekdays(const int_type *pDays, int_type *pOut, int nSize);
+  void WeeksOfYear(const int_type *pDays, int_type *pOut, int nSize);
+
+MUP_NAMESPACE_END
+
+#endif
@@ -75,6 +75,21 @@
 /** \brief Integer type used by the parser. */
 #define MUP_INT_TYPE int
 
+/** \brief Minimum number of elements for zeros() and eye() to create sparse matrices. */
+#define MUP_SPARSE_MIN_SIZE 1024
+
+/** \brief A sparse matrix becomes dense once more than one in MUP_SPARSE_MAX_FILL elements is stored. */
+#define MUP_SPARSE_MAX_FILL 4
+
+/** \brief Maximum number of unused values a value cache grows to hold. */
+#define MUP_VALUE_CACHE_MAX_SIZE 1024
+
+/** \brief Maximum number of characters a value keeps room for once its string is cleared. */
+#define MUP_VALUE_MAX_STRING_CAPACITY 1024
+
+/** \brief Maximum number of elements a value keeps room for once its matrix is cleared. */
+#define MUP_VALUE_MAX_MATRIX_CAPACITY 64
+
 /**
   A macro to specifically indicate when something is unused
 */
@@ -31,6 +31,7 @@
 #include "mpError.h"
 #include "mpIToken.h"
 #include "mpParserMessageProvider.h"
+#include "mpTrace.h"
 
 
 MUP_NAMESPACE_START
@@ -131,7 +132,9 @@ ParserError::ParserError(const string_type &sMsg)
     :m_Err()
     , m_sMsg(sMsg)
     , m_ErrMsg(ParserErrorMsg::Instance())
-{}
+{
+    MUP_TRACE2(error, (int)m_Err.Errc, m_sMsg.c_str());
+}
 
 //------------------------------------------------------------------------------
 ParserError::ParserError(const ErrorContext &a_Err)
@@ -140,6 +143,7 @@ ParserError::ParserError(const ErrorContext &a_Err)
     , m_ErrMsg(ParserErrorMsg::Instance())
 {
     m_sMsg = m_ErrMsg.GetErrorMsg(a_Err.Errc);
+    MUP_TRACE2(error, (int)m_Err.Errc, m_sMsg.c_str());
 }
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,597 @@
+/** \file
+    \brief Implementation of the locale independent number formatting.
+
+<pre>
+               __________                                 ____  ___
+    _____  __ _\______   \_____ _______  ______ __________\   \/  /
+   /     \|  |  \     ___/\__  \\_  __ \/  ___// __ \_  __ \     / 
+  |  Y Y  \  |  /    |     / __ \|  | \/\___ \\  ___/|  | \/     \ 
+  |__|_|  /____/|____|    (____  /__|  /____  >\___  >__| /___/\  \
+        \/                     \/           \/     \/           \_/
+                                       Copyright (C) 2016, Ingo Berg
+                                       All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without 
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice, 
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright notice, 
+     this list of conditions and the following disclaimer in the documentation 
+     and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. 
+  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT 
+  NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+  POSSIBILITY OF SUCH DAMAGE.
+  </pre>
+*/
+
+
+#include "mpFormat.h"
+
+//--- Standard includes ----------------------------------------------------
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+
+MUP_NAMESPACE_START
+
+namespace
+{
+  //------------------------------------------------------------------------------
+  /** \brief Unsigned integer of fixed size. 
+  
+    Large enough for the exact arithmetic on double values needed for 
+    computing their decimal digits. No heap memory is used.
+  */
+  class BigInt
+  {
+  public:
+
+    BigInt()
+      :m_nLen(0)
+    {}
+
+    BigInt(const BigInt &ref)
+      :m_nLen(ref.m_nLen)
+    {
+      std::memcpy(m_w, ref.m_w, m_nLen * sizeof(m_w[0]));
+    }
+
+    BigInt& operator=(const BigInt &ref)
+    {
+      m_nLen = ref.m_nLen;
+      std::memcpy(m_w, ref.m_w, m_nLen * sizeof(m_w[0]));
+      return *this;
+    }
+
+    void Set(std::uint64_t v)
+    {
+      m_nLen = 0;
+      while (v)
+      {
+        m_w[m_nLen++] = (std::uint32_t)v;
+        v >>= 32;
+      }
+    }
+
+    bool IsZero() const
+    {
+      return m_nLen == 0;
+    }
+
+    void ShiftLeft(int n)
+    {
+      if (m_nLen == 0 || n == 0)
+        return;
+
+      int nWords = n / 32,
+          nBits = n % 32;
+      if (nBits)
+      {
+        m_w[m_nLen + nWords] = m_w[m_nLen - 1] >> (32 - nBits);
+        for (int i = m_nLen - 1; i > 0; --i)
+          m_w[i + nWords] = (m_w[i] << nBits) | (m_w[i - 1] >> (32 - nBits));
+        m_w[nWords] = m_w[0] << nBits;
+        m_nLen += nWords + 1;
+      }
+      else
+      {
+        for (int i = m_nLen - 1; i >= 0; --i)
+          m_w[i + nWords] = m_w[i];
+        m_nLen += nWords;
+      }
+
+      for (int i = 0; i < nWords; ++i)
+        m_w[i] = 0;
+
+      Trim();
+    }
+
+    void Mul(std::uint32_t m)
+    {
+      std::uint64_t carry = 0;
+      for (int i = 0; i < m_nLen; ++i)
+      {
+        carry += (std::uint64_t)m_w[i] * m;
+        m_w[i] = (std::uint32_t)carry;
+        carry >>= 32;
+      }
+
+      if (carry)
+        m_w[m_nLen++] = (std::uint32_t)carry;
+    }
+
+    void MulPow10(int n)
+    {
+      static const std::uint32_t c_Pow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+      for (; n >= 9; n -= 9)
+        Mul(1000000000);
+      Mul(c_Pow10[n]);
+    }
+
+    void Add(const BigInt &b)
+    {
+      std::uint64_t carry = 0;
+      int n = (m_nLen > b.m_nLen) ? m_nLen : b.m_nLen;
+      for (int i = 0; i < n; ++i)
+      {
+        carry += (std::uint64_t)((i < m_nLen) ? m_w[i] : 0) + ((i < b.m_nLen) ? b.m_w[i] : 0);
+        m_w[i] = (std::uint32_t)carry;
+        carry >>= 32;
+      }
+
+      m_nLen = n;
+      if (carry)
+        m_w[m_nLen++] = (std::uint32_t)carry;
+    }
+
+    /** \brief Subtract b, this must not be smaller than b. */
+    void Sub(const BigInt &b)
+    {
+      std::int64_t borrow = 0;
+      for (int i = 0; i < m_nLen; ++i)
+      {
+        borrow += (std::int64_t)m_w[i] - ((i < b.m_nLen) ? b.m_w[i] : 0);
+        m_w[i] = (std::uint32_t)borrow;
+        borrow = (borrow < 0) ? -1 : 0;
+      }
+
+      Trim();
+    }
+
+    /** \brief Divide by b and keep the remainder, the quotient must be smaller than 11. */
+    int DivRem(const BigInt &b)
+    {
+      if (m_nLen < b.m_nLen)
+        return 0;
+
+      // Estimate the quotient from the leading words, the estimate is never too large
+      std::uint64_t top = m_w[m_nLen - 1];
+      if (m_nLen > b.m_nLen)
+        top = (top << 32) | m_w[m_nLen - 2];
+
+      int q = (int)(top / ((std::uint64_t)b.m_w[b.m_nLen - 1] + 1));
+      if (q)
+        SubMul(b, q);
+
+      while (Compare(*this, b) >= 0)
+      {
+        Sub(b);
+        ++q;
+      }
+
+      return q;
+    }
+
+    static int Compare(const BigInt &a, const BigInt &b)
+    {
+      if (a.m_nLen != b.m_nLen)
+        return (a.m_nLen < b.m_nLen) ? -1 : 1;
+
+      for (int i = a.m_nLen - 1; i >= 0; --i)
+      {
+        if (a.m_w[i] != b.m_w[i])
+          return (a.m_w[i] < b.m_w[i]) ? -1 : 1;
+      }
+
+      return 0;
+    }
+
+    /** \brief Compare the sum a+b to c. */
+    static int CompareSum(const BigInt &a, const BigInt &b, const BigInt &c)
+    {
+      BigInt sum(a);
+      sum.Add(b);
+      return Compare(sum, c);
+    }
+
+  private:
+
+    /** \brief Subtract b*q, this must not be smaller than b*q. */
+    void SubMul(const BigInt &b, int q)
+    {
+      std::uint64_t carry = 0;
+      std::int64_t borrow = 0;
+      for (int i = 0; i < m_nLen; ++i)
+      {
+        carry += (std::uint64_t)((i < b.m_nLen) ? b.m_w[i] : 0) * (std::uint32_t)q;
+        borrow += (std::int64_t)m_w[i] - (std::uint32_t)carry;
+        carry >>= 32;
+        m_w[i] = (std::uint32_t)borrow;
+        borrow = (borrow < 0) ? -1 : 0;
+      }
+
+      Trim();
+    }
+
+    void Trim()
+    {
+      while (m_nLen > 0 && m_w[m_nLen - 1] == 0)
+        --m_nLen;
+    }
+
+    // 2^1074 * 10^17 is the largest intermediate value, 40 words leave some room
+    enum { MAX_WORDS = 40 };
+
+    std::uint32_t m_w[MAX_WORDS];
+    int m_nLen;
+  };
+
+  //------------------------------------------------------------------------------
+  /** \brief Set r/s to the value of the mantissa f times 2^e. */
+  void InitFraction(std::uint64_t f, int e, BigInt &r, BigInt &s)
+  {
+    r.Set(f);
+    s.Set(1);
+    if (e >= 0)
+      r.ShiftLeft(e);
+    else
+      s.ShiftLeft(-e);
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Estimate the decimal exponent k with 10^(k-1) <= f*2^e < 10^k.
+  
+    The estimate is either exact or one too small.
+  */
+  int EstimateExponent(std::uint64_t f, int e)
+  {
+    int nBits = 0;
+    while (f >> nBits)
+      ++nBits;
+
+    return (int)std::ceil((nBits + e - 1) * 0.30102999566398114 - 1e-10);
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Compute the shortest digits reading back to f*2^e.
+      \return The number of digits.
+  
+    This is the free format algorithm of Steele & White in the version of 
+    Burger & Dybvig. A digit string is accepted as soon as it lies within the 
+    half way points to the neighbouring doubles.
+  */
+  int ShortestDigits(std::uint64_t f, int e, bool bLowerGapSmaller, char *digits, int &nExp)
+  {
+    // r/s is the value, mp/s and mm/s are the distances to the half way points
+    // of the upper and lower neighbour. Everything is scaled by two to keep 
+    // these distances integer.
+    BigInt r, s, mp, mm;
+    InitFraction(f, e, r, s);
+    r.ShiftLeft(bLowerGapSmaller ? 2 : 1);
+    s.ShiftLeft(bLowerGapSmaller ? 2 : 1);
+    mm.Set(1);
+    if (e > 0)
+      mm.ShiftLeft(e);
+    mp = mm;
+    if (bLowerGapSmaller)
+      mp.ShiftLeft(1);
+
+    bool bEven = (f & 1) == 0;
+    int k = EstimateExponent(f, e);
+    if (k >= 0)
+    {
+      s.MulPow10(k);
+    }
+    else
+    {
+      r.MulPow10(-k);
+      mp.MulPow10(-k);
+      mm.MulPow10(-k);
+    }
+
+    // fix the estimate of the exponent
+    int c = BigInt::CompareSum(r, mp, s);
+    if (bEven ? c >= 0 : c > 0)
+    {
+      s.Mul(10);
+      ++k;
+    }
+
+    int n = 0;
+    for (;;)
+    {
+      r.Mul(10);
+      mp.Mul(10);
+      mm.Mul(10);
+      int d = r.DivRem(s);
+
+      c = BigInt::Compare(r, mm);
+      bool bLow = bEven ? c <= 0 : c < 0;
+      c = BigInt::CompareSum(r, mp, s);
+      bool bHigh = bEven ? c >= 0 : c > 0;
+
+      if (!bLow && !bHigh)
+      {
+        digits[n++] = (char)('0' + d);
+        continue;
+      }
+
+      if (bLow && bHigh)
+      {
+        BigInt r2(r);
+        r2.ShiftLeft(1);
+        if (BigInt::Compare(r2, s) >= 0)
+          ++d;
+      }
+      else if (bHigh)
+      {
+        ++d;
+      }
+
+      digits[n++] = (char)('0' + d);
+      break;
+    }
+
+    // A final digit of ten is carried into the preceding ones
+    for (int i = n - 1; i > 0 && digits[i] > '9'; --i)
+    {
+      digits[i] = '0';
+      ++digits[i - 1];
+    }
+
+    if (digits[0] > '9')
+    {
+      digits[0] = '1';
+      n = 1;
+      ++k;
+    }
+
+    nExp = k - 1;
+    return n;
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Compute the first nPrec digits of f*2^e, correctly rounded.
+      \return The number of digits.
+  
+    Ties are rounded to even like the C library does.
+  */
+  int PrecisionDigits(std::uint64_t f, int e, int nPrec, char *digits, int &nExp)
+  {
+    BigInt r, s;
+    InitFraction(f, e, r, s);
+
+    int k = EstimateExponent(f, e);
+    if (k >= 0)
+      s.MulPow10(k);
+    else
+      r.MulPow10(-k);
+
+    if (BigInt::Compare(r, s) >= 0)
+    {
+      s.Mul(10);
+      ++k;
+    }
+
+    for (int i = 0; i < nPrec; ++i)
+    {
+      r.Mul(10);
+      digits[i] = (char)('0' + r.DivRem(s));
+    }
+
+    r.ShiftLeft(1);
+    int c = BigInt::Compare(r, s);
+    if (c > 0 || (c == 0 && ((digits[nPrec - 1] - '0') & 1)))
+    {
+      int i = nPrec - 1;
+      while (i >= 0 && digits[i] == '9')
+        digits[i--] = '0';
+
+      if (i >= 0)
+      {
+        ++digits[i];
+      }
+      else
+      {
+        digits[0] = '1';
+        ++k;
+      }
+    }
+
+    nExp = k - 1;
+    return nPrec;
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Write the digits d[0].d[1]d[2]... * 10^nExp the way printf("%g") does.
+
+    Trailing zeros are dropped. Fixed notation is used for exponents from -4
+    up to 14, the scientific notation otherwise.
+  */
+  int Layout(bool bNeg, const char *digits, int n, int nExp, char_type *buf)
+  {
+    while (n > 1 && digits[n - 1] == '0')
+      --n;
+
+    char_type *p = buf;
+    if (bNeg)
+      *p++ = '-';
+
+    if (nExp >= -4 && nExp < 15)
+    {
+      if (nExp < 0)
+      {
+        *p++ = '0';
+        *p++ = '.';
+        for (int i = -1; i > nExp; --i)
+          *p++ = '0';
+        for (int i = 0; i < n; ++i)
+          *p++ = digits[i];
+      }
+      else
+      {
+        for (int i = 0; i <= nExp; ++i)
+          *p++ = (i < n) ? digits[i] : '0';
+
+        if (n > nExp + 1)
+        {
+          *p++ = '.';
+          for (int i = nExp + 1; i < n; ++i)
+            *p++ = digits[i];
+        }
+      }
+    }
+    else
+    {
+      *p++ = digits[0];
+      if (n > 1)
+      {
+        *p++ = '.';
+        for (int i = 1; i < n; ++i)
+          *p++ = digits[i];
+      }
+
+      *p++ = 'e';
+      *p++ = (nExp < 0) ? '-' : '+';
+      int nAbsExp = (nExp < 0) ? -nExp : nExp;
+      if (nAbsExp >= 100)
+        *p++ = (char_type)('0' + nAbsExp / 100);
+      *p++ = (char_type)('0' + nAbsExp / 10 % 10);
+      *p++ = (char_type)('0' + nAbsExp % 10);
+    }
+
+    *p = 0;
+    return (int)(p - buf);
+  }
+
+  //------------------------------------------------------------------------------
+  int WriteStr(const char *sz, char_type *buf)
+  {
+    int n = 0;
+    for (; sz[n]; ++n)
+      buf[n] = sz[n];
+    buf[n] = 0;
+    return n;
+  }
+} // anonymous namespace
+
+  //------------------------------------------------------------------------------
+  /** \brief Write an integer to a buffer without using the locale.
+      \param val The value to write.
+      \param buf A buffer of at least FORMAT_BUF_SIZE characters.
+      \return The number of characters written, not counting the terminating zero.
+  */
+  int FormatInt(int_type val, char_type *buf)
+  {
+    char digits[FORMAT_BUF_SIZE];
+    unsigned long long v = (val < 0) ? 0ULL - (unsigned long long)val : (unsigned long long)val;
+
+    int n = 0;
+    do
+    {
+      digits[n++] = (char)('0' + v % 10);
+      v /= 10;
+    } while (v);
+
+    char_type *p = buf;
+    if (val < 0)
+      *p++ = '-';
+
+    while (n)
+      *p++ = digits[--n];
+
+    *p = 0;
+    return (int)(p - buf);
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Write a floating point value to a buffer without using the locale.
+      \param val The value to write.
+      \param buf A buffer of at least FORMAT_BUF_SIZE characters.
+      \param eMode fmSHORTEST for the shortest string reading back to val, fmCOMPAT
+             for the output of std::ostream with a precision of 15 digits.
+      \return The number of characters written, not counting the terminating zero.
+
+    Both modes use the same layout as printf("%.15g"). They differ in the digits
+    only, so values with no more than 15 significant digits look the same.
+  */
+  int FormatFloat(float_type val, char_type *buf, EFormatMode eMode)
+  {
+    bool bNeg = std::signbit(val);
+    if (std::isnan(val))
+      return WriteStr(bNeg ? "-nan" : "nan", buf);
+
+    if (std::isinf(val))
+      return WriteStr(bNeg ? "-inf" : "inf", buf);
+
+    if (val == 0)
+      return WriteStr(bNeg ? "-0" : "0", buf);
+
+    char digits[FORMAT_BUF_SIZE];
+    int n = 0, nExp = 0;
+    float_type a = std::fabs(val);
+
+    if (a < 1e15 && a == std::floor(a))
+    {
+      // Integral values are exact, no rounding needed
+      std::uint64_t v = (std::uint64_t)a;
+      char rev[FORMAT_BUF_SIZE];
+      while (v)
+      {
+        rev[n++] = (char)('0' + v % 10);
+        v /= 10;
+      }
+
+      for (int i = 0; i < n; ++i)
+        digits[i] = rev[n - 1 - i];
+      nExp = n - 1;
+    }
+    else
+    {
+      std::uint64_t bits;
+      std::memcpy(&bits, &a, sizeof(bits));
+      int nBiasedExp = (int)(bits >> 52);
+      std::uint64_t f = bits & ((1ULL << 52) - 1);
+      int e;
+      if (nBiasedExp == 0)
+      {
+        e = -1074;  // denormal number
+      }
+      else
+      {
+        f |= 1ULL << 52;
+        e = nBiasedExp - 1075;
+      }
+
+      // At powers of two the gap to the lower neighbour is only half as large
+      bool bLowerGapSmaller = (f == (1ULL << 52)) && nBiasedExp > 1;
+      if (eMode == fmCOMPAT)
+        n = PrecisionDigits(f, e, 15, digits, nExp);
+      else
+        n = ShortestDigits(f, e, bLowerGapSmaller, digits, nExp);
+    }
+
+    return Layout(bNeg, digits, n, nExp, buf);
+  }
+
+MUP_NAMESPACE_END
@@ -0,0 +1,393 @@
+/** \file
+    \brief Implementation of a set of formulas depending on each others results.
+
+<pre>
+               __________                                 ____  ___
+    _____  __ _\______   \_____ _______  ______ __________\   \/  /
+   /     \|  |  \     ___/\__  \\_  __ \/  ___// __ \_  __ \     / 
+  |  Y Y  \  |  /    |     / __ \|  | \/\___ \\  ___/|  | \/     \ 
+  |__|_|  /____/|____|    (____  /__|  /____  >\___  >__| /___/\  \
+        \/                     \/           \/     \/           \_/
+                                       Copyright (C) 2016, Ingo Berg
+                                       All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without 
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice, 
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright notice, 
+     this list of conditions and the following disclaimer in the documentation 
+     and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. 
+  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT 
+  NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+  POSSIBILITY OF SUCH DAMAGE.
+  </pre>
+*/
+
+#include "mpFormulaGraph.h"
+
+//--- Standard includes ----------------------------------------------------
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+//--- muParserX framework --------------------------------------------------
+#include "mpError.h"
+#include "mpVariable.h"
+
+
+MUP_NAMESPACE_START
+
+  //------------------------------------------------------------------------------
+  FormulaGraph::Node::Node(const string_type &sName)
+    :m_sName(sName)
+    ,m_sExpr()
+    ,m_pParser()
+    ,m_val()
+    ,m_Inputs()
+    ,m_vDependents()
+    ,m_nLevel(0)
+    ,m_bDirty(false)
+  {}
+
+  //------------------------------------------------------------------------------
+  /** \brief Create an empty formula graph.
+      \param ePackages The packages added to the parsers of the formulas
+  */
+  FormulaGraph::FormulaGraph(unsigned ePackages)
+    :m_ePackages(ePackages)
+    ,m_vNodes()
+    ,m_NodeIdx()
+    ,m_vOrder()
+    ,m_bRebuild(false)
+  {
+    // Formulas are evaluated concurrently, the message provider must exist
+    // before the first error is thrown.
+    ParserErrorMsg::Instance();
+  }
+
+  //------------------------------------------------------------------------------
+  FormulaGraph::~FormulaGraph()
+  {}
+
+  //------------------------------------------------------------------------------
+  /** \brief Add an input to the graph.
+      \param sName The name used by formulas for referring to the input
+      \param val The initial value of the input
+      \throw ParserError if an input or formula of this name already exists
+  */
+  void FormulaGraph::DefineInput(const string_type &sName, const Value &val)
+  {
+    if (m_NodeIdx.find(sName) != m_NodeIdx.end())
+      throw ParserError(ErrorContext(ecVARIABLE_DEFINED, 0, sName));
+
+    std::unique_ptr<Node> pNode(new Node(sName));
+    pNode->m_val = val;
+
+    m_NodeIdx[sName] = (int)m_vNodes.size();
+    m_vNodes.push_back(std::move(pNode));
+    m_bRebuild = true;
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Add a formula to the graph or replace the expression of a formula.
+      \param sName The name used by other formulas for referring to the result
+      \param sExpr The expression of the formula
+      \throw ParserError if an input of this name already exists
+
+    The expression is checked when the graph is updated the next time.
+  */
+  void FormulaGraph::DefineFormula(const string_type &sName, const string_type &sExpr)
+  {
+    std::map<string_type, int>::const_iterator item = m_NodeIdx.find(sName);
+    if (item == m_NodeIdx.end())
+    {
+      m_NodeIdx[sName] = (int)m_vNodes.size();
+      m_vNodes.push_back(std::unique_ptr<Node>(new Node(sName)));
+    }
+    else if (m_vNodes[item->second]->m_pParser.get() == nullptr)
+    {
+      throw ParserError(ErrorContext(ecVARIABLE_DEFINED, 0, sName));
+    }
+
+    Node &node = GetNode(sName);
+    node.m_sExpr = sExpr;
+    node.m_pParser.reset(new ParserX(m_ePackages));
+    node.m_Inputs.clear();
+    m_bRebuild = true;
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Change the value of an input.
+
+    Formulas using the input are marked for being evaluated by the next call
+    to Update. Nothing is marked if the value did not change.
+  */
+  void FormulaGraph::SetInput(const string_type &sName, const Value &val)
+  {
+    Node &node = GetNode(sName);
+    if (node.m_pParser.get() != nullptr)
+      throw ParserError(ErrorContext(ecNOT_AN_INPUT, -1, sName));
+
+    bool bChanged = node.m_val.GetType() != val.GetType() || !(node.m_val == val);
+    node.m_val = val;
+
+    if (bChanged)
+      MarkDependents(node);
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Evaluate all formulas whose inputs changed.
+      \param nThreads Maximum number of threads used per dependency level,
+                      0 uses one thread per hardware thread.
+      \return The number of formulas evaluated.
+      \throw ParserError The error of the first formula that failed.
+
+    Formulas depending on a failed formula are not evaluated. They stay marked
+    together with the failed formula and are evaluated by the next update.
+    All other formulas are updated even if an error occurs.
+  */
+  int FormulaGraph::Update(int nThreads)
+  {
+    if (m_bRebuild)
+      Rebuild();
+
+    if (nThreads <= 0)
+      nThreads = std::max(1, (int)std::thread::hardware_concurrency());
+
+    std::vector<int> vLevel;
+    std::vector<bool> vBlocked(m_vNodes.size(), false);
+    std::unique_ptr<ParserError> pError;
+    int nEval = 0;
+
+    for (std::size_t i = 0; i < m_vOrder.size(); )
+    {
+      // Collect the formulas of the next level, these don't depend on each other
+      int nLevel = m_vNodes[m_vOrder[i]]->m_nLevel;
+      vLevel.clear();
+      for (; i < m_vOrder.size() && m_vNodes[m_vOrder[i]]->m_nLevel == nLevel; ++i)
+      {
+        int idx = m_vOrder[i];
+        if (!m_vNodes[idx]->m_bDirty)
+          continue;
+
+        if (vBlocked[idx])
+        {
+          for (std::size_t k = 0; k < m_vNodes[idx]->m_vDependents.size(); ++k)
+            vBlocked[m_vNodes[idx]->m_vDependents[k]] = true;
+        }
+        else
+          vLevel.push_back(idx);
+      }
+
+      if (vLevel.empty())
+        continue;
+
+      // Reading a value may modify it, i.e. when its string is shared as a slice. 
+      // Each formula reads copies of its inputs made before the workers start.
+      for (std::size_t k = 0; k < vLevel.size(); ++k)
+      {
+        std::map<int, Value> &inputs = m_vNodes[vLevel[k]]->m_Inputs;
+        for (std::map<int, Value>::iterator item = inputs.begin(); item != inputs.end(); ++item)
+          item->second = m_vNodes[item->first]->m_val;
+      }
+
+      std::vector<Value> vResult(vLevel.size());
+      std::vector<std::unique_ptr<ParserError> > vError(vLevel.size());
+      std::atomic<std::size_t> nNext(0);
+
+      // Each formula has a parser and copies of its inputs of its own
+      auto worker = [&]()
+      {
+        for (std::size_t k = nNext++; k < vLevel.size(); k = nNext++)
+        {
+          try
+          {
+            vResult[k] = m_vNodes[vLevel[k]]->m_pParser->Eval();
+          }
+          catch (ParserError &exc)
+          {
+            vError[k].reset(new ParserError(exc));
+          }
+          catch (std::exception &exc)
+          {
+            vError[k].reset(new ParserError(exc.what()));
+          }
+        }
+      };
+
+      std::vector<std::thread> vThread;
+      for (int k = 1; k < std::min(nThreads, (int)vLevel.size()); ++k)
+        vThread.push_back(std::thread(worker));
+
+      worker();
+
+      for (std::size_t k = 0; k < vThread.size(); ++k)
+        vThread[k].join();
+
+      for (std::size_t k = 0; k < vLevel.size(); ++k)
+      {
+        Node &node = *m_vNodes[vLevel[k]];
+        if (vError[k].get() != nullptr)
+        {
+          if (pError.get() == nullptr)
+            pError = std::move(vError[k]);
+
+          MarkDependents(node);
+          for (std::size_t j = 0; j < node.m_vDependents.size(); ++j)
+            vBlocked[node.m_vDependents[j]] = true;
+
+          continue;
+        }
+
+        bool bChanged = node.m_val.GetType() != vResult[k].GetType() || !(node.m_val == vResult[k]);
+        node.m_val = vResult[k];
+        node.m_bDirty = false;
+        ++nEval;
+
+        if (bChanged)
+          MarkDependents(node);
+      }
+    }
+
+    if (pError.get() != nullptr)
+      throw *pError;
+
+    return nEval;
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Returns the value of an input or the last result of a formula. */
+  const IValue& FormulaGraph::GetValue(const string_type &sName) const
+  {
+    return GetNode(sName).m_val;
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Returns true if the result of a formula is outdated. */
+  bool FormulaGraph::IsDirty(const string_type &sName) const
+  {
+    const Node &node = GetNode(sName);
+    return node.m_pParser.get() != nullptr && (m_bRebuild || node.m_bDirty);
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Returns the names of the formulas in the order of evaluation used
+             by the last update.
+  */
+  std::vector<string_type> FormulaGraph::GetOrder() const
+  {
+    std::vector<string_type> vName;
+    for (std::size_t i = 0; i < m_vOrder.size(); ++i)
+      vName.push_back(m_vNodes[m_vOrder[i]]->m_sName);
+
+    return vName;
+  }
+
+  //------------------------------------------------------------------------------
+  FormulaGraph::Node& FormulaGraph::GetNode(const string_type &sName) const
+  {
+    std::map<string_type, int>::const_iterator item = m_NodeIdx.find(sName);
+    if (item == m_NodeIdx.end())
+      throw ParserError(ErrorContext(ecUNDEFINED_NAME, -1, sName));
+
+    return *m_vNodes[item->second];
+  }
+
+  //------------------------------------------------------------------------------
+  void FormulaGraph::MarkDependents(const Node &node)
+  {
+    for (std::size_t i = 0; i < node.m_vDependents.size(); ++i)
+      m_vNodes[node.m_vDependents[i]]->m_bDirty = true;
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Determine the dependencies of all formulas and their order.
+      \throw ParserError in case of syntax errors or circular dependencies
+
+    Names used by a formula that are neither inputs nor formulas are left
+    undefined, evaluating the formula will report them.
+  */
+  void FormulaGraph::Rebuild()
+  {
+    std::vector<int> vNumDeps(m_vNodes.size(), 0);
+    for (std::size_t i = 0; i < m_vNodes.size(); ++i)
+    {
+      m_vNodes[i]->m_vDependents.clear();
+      m_vNodes[i]->m_nLevel = 0;
+    }
+
+    for (std::size_t i = 0; i < m_vNodes.size(); ++i)
+    {
+      Node &node = *m_vNodes[i];
+      if (node.m_pParser.get() == nullptr)
+        continue;
+
+      node.m_bDirty = true;
+      node.m_nLevel = 1;
+      node.m_pParser->SetExpr(node.m_sExpr);
+
+      // Take a copy, defining variables changes the map
+      var_maptype vars = node.m_pParser->GetExprVar();
+      for (var_maptype::const_iterator item = vars.begin(); item != vars.end(); ++item)
+      {
+        std::map<string_type, int>::const_iterator dep = m_NodeIdx.find(item->first);
+        if (dep == m_NodeIdx.end())
+          continue;
+
+        // Entries of the map keep their address, the variable stays bound to it
+        Node &depNode = *m_vNodes[dep->second];
+        Value &input = node.m_Inputs[dep->second];
+        if (!node.m_pParser->IsVarDefined(item->first))
+          node.m_pParser->DefineVar(item->first, Variable(&input));
+
+        depNode.m_vDependents.push_back((int)i);
+        if (depNode.m_pParser.get() != nullptr)
+          ++vNumDeps[i];
+      }
+    }
+
+    // Topological sort, formulas without formula dependencies come first
+    m_vOrder.clear();
+    for (std::size_t i = 0; i < m_vNodes.size(); ++i)
+    {
+      if (m_vNodes[i]->m_pParser.get() != nullptr && vNumDeps[i] == 0)
+        m_vOrder.push_back((int)i);
+    }
+
+    for (std::size_t i = 0; i < m_vOrder.size(); ++i)
+    {
+      const Node &node = *m_vNodes[m_vOrder[i]];
+      for (std::size_t k = 0; k < node.m_vDependents.size(); ++k)
+      {
+        int idx = node.m_vDependents[k];
+        m_vNodes[idx]->m_nLevel = std::max(m_vNodes[idx]->m_nLevel, node.m_nLevel + 1);
+        if (--vNumDeps[idx] == 0)
+          m_vOrder.push_back(idx);
+      }
+    }
+
+    for (std::size_t i = 0; i < m_vNodes.size(); ++i)
+    {
+      if (vNumDeps[i] > 0)
+        throw ParserError(ErrorContext(ecCIRCULAR_DEPENDENCY, -1, m_vNodes[i]->m_sName));
+    }
+
+    std::stable_sort(m_vOrder.begin(), m_vOrder.end(), [this](int a, int b)
+    {
+      return m_vNodes[a]->m_nLevel < m_vNodes[b]->m_nLevel;
+    });
+
+    m_bRebuild = false;
+  }
+
+MUP_NAMESPACE_END
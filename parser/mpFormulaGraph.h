@@ -0,0 +1,115 @@
+/** \file
+    \brief Definition of a set of formulas depending on each others results.
+
+<pre>
+               __________                                 ____  ___
+    _____  __ _\______   \_____ _______  ______ __________\   \/  /
+   /     \|  |  \     ___/\__  \\_  __ \/  ___// __ \_  __ \     / 
+  |  Y Y  \  |  /    |     / __ \|  | \/\___ \\  ___/|  | \/     \ 
+  |__|_|  /____/|____|    (____  /__|  /____  >\___  >__| /___/\  \
+        \/                     \/           \/     \/           \_/
+                                       Copyright (C) 2016, Ingo Berg
+                                       All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without 
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice, 
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright notice, 
+     this list of conditions and the following disclaimer in the documentation 
+     and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. 
+  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT 
+  NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+  POSSIBILITY OF SUCH DAMAGE.
+  </pre>
+*/
+
+
+#ifndef MUP_FORMULA_GRAPH_H
+#define MUP_FORMULA_GRAPH_H
+
+//--- Standard includes ----------------------------------------------------
+#include <map>
+#include <memory>
+#include <vector>
+
+//--- muParserX framework --------------------------------------------------
+#include "mpParser.h"
+#include "mpValue.h"
+
+MUP_NAMESPACE_START
+
+  /** \brief A set of named formulas whose results feed each other.
+
+    Each formula is evaluated by a parser of its own. A formula may refer to
+    inputs and to the results of other formulas by their names. The graph
+    finds these dependencies from the variables used in the expressions and
+    evaluates the formulas in topological order.
+
+    After an input changed only the formulas depending on it are evaluated
+    again. A formula whose result did not change does not trigger the
+    formulas depending on it. Formulas of the same dependency level are
+    evaluated in parallel, so callbacks used by them must be reentrant. The 
+    values a formula reads are copied before each evaluation, formulas 
+    evaluated in parallel share no values.
+  */
+  class FormulaGraph
+  {
+  public:
+
+    FormulaGraph(unsigned ePackages = pckALL_NON_COMPLEX);
+   ~FormulaGraph();
+
+    void DefineInput(const string_type &sName, const Value &val);
+    void DefineFormula(const string_type &sName, const string_type &sExpr);
+    void SetInput(const string_type &sName, const Value &val);
+
+    int Update(int nThreads = 0);
+
+    const IValue& GetValue(const string_type &sName) const;
+    bool IsDirty(const string_type &sName) const;
+    std::vector<string_type> GetOrder() const;
+
+  private:
+
+    /** \brief An input or a formula of the graph. */
+    struct Node
+    {
+      Node(const string_type &sName);
+
+      string_type m_sName;
+      string_type m_sExpr;                ///< The expression, empty for inputs
+      std::unique_ptr<ParserX> m_pParser; ///< The parser of a formula, nullptr for inputs
+      Value m_val;                        ///< The input value or the result of the formula
+      std::map<int, Value> m_Inputs;      ///< Copies of the values a formula reads, by node index
+      std::vector<int> m_vDependents;     ///< Indices of the formulas using this node
+      int m_nLevel;                       ///< Length of the longest path from an input
+      bool m_bDirty;                      ///< true if the formula must be evaluated again
+    };
+
+    FormulaGraph(const FormulaGraph &ref);
+    FormulaGraph& operator=(const FormulaGraph &ref);
+
+    Node& GetNode(const string_type &sName) const;
+    void MarkDependents(const Node &node);
+    void Rebuild();
+
+    unsigned m_ePackages;
+    std::vector<std::unique_ptr<Node> > m_vNodes;
+    std::map<string_type, int> m_NodeIdx;
+    std::vector<int> m_vOrder;            ///< Formula indices in order of evaluation
+    bool m_bRebuild;                      ///< true if the dependencies must be determined again
+  }; // class FormulaGraph
+
+MUP_NAMESPACE_END
+
+#endif
@@ -34,8 +34,11 @@
 */
 #include "mpFuncCommon.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <string>
+#include <vector>
 #include <iostream>
 #include <ctime>
 #include <regex>
@@ -43,8 +46,8 @@
 
 #include "mpValue.h"
 #include "mpParserBase.h"
-
-#define ONE_DAY (24 * 60 * 60)
+#include "mpDate.h"
+#include "mpReduce.h"
 
 MUP_NAMESPACE_START
 
@@ -77,6 +80,170 @@ MUP_NAMESPACE_START
     return new FunParserID(*this);
   }
 
+  // Returns a scalar argument of the reduction functions, which must be a number
+  float_type number_of (const IValue &val, int arg) {
+    switch (val.GetType()) {
+    case 'f':
+    case 'i': return val.GetFloat();
+    default:
+      {
+        ErrorContext err;
+        err.Errc = ecTYPE_CONFLICT_FUN;
+        err.Arg = arg;
+        err.Type1 = val.GetType();
+        err.Type2 = 'f';
+        throw ParserError(err);
+      }
+    }
+  }
+
+  // Appends a numeric argument of the reduction functions to numbers. Arrays add all of
+  // their elements row by row.
+  void get_numbers (const IValue &val, int arg, std::vector<float_type> &numbers) {
+    if (val.IsMatrix()) {
+      const matrix_type &m = val.GetArray();
+      for (int i = 0; i < m.GetRows(); ++i) {
+        for (int j = 0; j < m.GetCols(); ++j) {
+          get_numbers(m.At(i, j), arg, numbers);
+        }
+      }
+
+      return;
+    }
+
+    numbers.push_back(number_of(val, arg));
+  }
+
+  // Passes a numeric argument of sum, min, max and avg to reduce. Scalars are passed on
+  // directly, only the elements of arrays are collected in a buffer first.
+  template<typename TReduce>
+  void reduce_numbers (const IValue &val, int arg, TReduce &reduce) {
+    if (!val.IsMatrix()) {
+      reduce(number_of(val, arg));
+      return;
+    }
+
+    std::vector<float_type> numbers;
+    get_numbers(val, arg, numbers);
+    reduce(numbers.data(), (int)numbers.size());
+  }
+
+  // Sums up the arguments of sum and avg, compensated if the parser asks for it
+  struct sum_reduce {
+    explicit sum_reduce (const ParserXBase *parser)
+      : compensated(parser && parser->IsCompensatedSumEnabled()), sum(0), comp(0), count(0) {}
+
+    void operator() (float_type val) {
+      operator()(&val, 1);
+    }
+
+    void operator() (const float_type *vals, int n) {
+      if (compensated) {
+        CompensatedSumOf(vals, n, sum, comp);
+      } else {
+        sum = SumOf(vals, n, sum);
+      }
+
+      count += n;
+    }
+
+    float_type result () const {
+      return sum + comp;
+    }
+
+    bool compensated;
+    float_type sum, comp;
+    int count;
+  };
+
+  // Finds the minimum of the arguments of min
+  struct min_reduce {
+    float_type val;
+
+    void operator() (float_type v) {
+      val = std::min(val, v);
+    }
+
+    void operator() (const float_type *vals, int n) {
+      val = MinOf(vals, n, val);
+    }
+  };
+
+  // Finds the maximum of the arguments of max
+  struct max_reduce {
+    float_type val;
+
+    void operator() (float_type v) {
+      val = std::max(val, v);
+    }
+
+    void operator() (const float_type *vals, int n) {
+      val = MaxOf(vals, n, val);
+    }
+  };
+
+  // Returns numbers stored row by row as a matrix of the given size, a single number
+  // is returned as scalar
+  void set_numbers (ptr_val_type &ret, const std::vector<float_type> &numbers, int rows, int cols) {
+    if (rows * cols == 1) {
+      *ret = numbers[0];
+      return;
+    }
+
+    matrix_type res(rows, cols, 0.0);
+    for (int i = 0; i < rows; ++i) {
+      for (int j = 0; j < cols; ++j) {
+        res.At(i, j) = numbers[i * cols + j];
+      }
+    }
+
+    *ret = res;
+  }
+
+  // Returns the value at the fractional position pos of the sorted numbers, interpolating
+  // linearly between neighbours. Selects instead of sorting, so numbers is reordered.
+  float_type select_rank (std::vector<float_type> &numbers, float_type pos) {
+    std::size_t k = (std::size_t)pos;
+    std::nth_element(numbers.begin(), numbers.begin() + k, numbers.end());
+
+    float_type lower = numbers[k],
+               frac = pos - k;
+    if (frac == 0 || k + 1 >= numbers.size()) {
+      return lower;
+    }
+
+    // Everything behind the k-th element is larger or equal
+    float_type upper = *std::min_element(numbers.begin() + k + 1, numbers.end());
+    return lower + frac * (upper - lower);
+  }
+
+  // Splits a criterion of count_if like ">=5" into its operator and value
+  void split_criterion (const string_type &crit, string_type &op, string_type &val) {
+    static const char_type *ops[] = { _T("<="), _T(">="), _T("<>"), _T("<"), _T(">"), _T("=") };
+
+    for (const char_type *o : ops) {
+      string_type sOp(o);
+      if (crit.compare(0, sOp.length(), sOp) == 0) {
+        op = sOp;
+        val = crit.substr(sOp.length());
+        return;
+      }
+    }
+
+    op = _T("=");
+    val = crit;
+  }
+
+  template<typename T>
+  bool compare (const string_type &op, const T &a, const T &b) {
+    if (op == _T("<"))  return a < b;
+    if (op == _T("<=")) return a <= b;
+    if (op == _T(">"))  return a > b;
+    if (op == _T(">=")) return a >= b;
+    if (op == _T("<>")) return a != b;
+    return a == b;
+  }
+
   //------------------------------------------------------------------------------
   //
   // Max Function
@@ -92,35 +259,21 @@ MUP_NAMESPACE_START
     if (a_iArgc < 1)
         throw ParserError(ErrorContext(ecTOO_FEW_PARAMS, GetExprPos(), GetIdent()));
 
-    float_type max(-1e30), val(0);
+    max_reduce max = { -1e30 };
     for (int i=0; i<a_iArgc; ++i)
     {
-      switch(a_pArg[i]->GetType())
-      {
-      case 'f':
-      case 'i': val = a_pArg[i]->GetFloat(); break;
-      case 'n': break; // ignore not in list entries (missing parameter)
-      case 'c':
-      default:
-        {
-          ErrorContext err;
-          err.Errc = ecTYPE_CONFLICT_FUN;
-          err.Arg = i+1;
-          err.Type1 = a_pArg[i]->GetType();
-          err.Type2 = 'f';
-          throw ParserError(err);
-        }
-      }
-      max = std::max(max, val);
+      // ignore not in list entries (missing parameter)
+      if (a_pArg[i]->GetType() != 'n')
+        reduce_numbers(*a_pArg[i], i+1, max);
     }
 
-    *ret = max;
+    *ret = max.val;
   }
 
   //------------------------------------------------------------------------------
   const char_type* FunMax::GetDesc() const
   {
-    return _T("max(x,y,...,z) - Returns the maximum value from all of its function arguments.");
+    return _T("max(x,y,...,z) - Returns the maximum value from all of its function arguments and array elements.");
   }
 
   //------------------------------------------------------------------------------
@@ -148,34 +301,17 @@ MUP_NAMESPACE_START
     if (a_iArgc < 1)
         throw ParserError(ErrorContext(ecTOO_FEW_PARAMS, GetExprPos(), GetIdent()));
 
-    float_type min(1e30), val(min);
-
+    min_reduce min = { 1e30 };
     for (int i=0; i<a_iArgc; ++i)
-    {
-      switch(a_pArg[i]->GetType())
-      {
-      case 'f':
-      case 'i': val = a_pArg[i]->GetFloat();   break;
-      default:
-        {
-          ErrorContext err;
-          err.Errc = ecTYPE_CONFLICT_FUN;
-          err.Arg = i+1;
-          err.Type1 = a_pArg[i]->GetType();
-          err.Type2 = 'f';
-          throw ParserError(err);
-        }
-      }
-      min = std::min(min, val);
-    }
+      reduce_numbers(*a_pArg[i], i+1, min);
 
-    *ret = min;
+    *ret = min.val;
   }
 
   //------------------------------------------------------------------------------
   const char_type* FunMin::GetDesc() const
   {
-    return _T("min(x,y,...,z) - Returns the minimum value from all of its function arguments.");
+    return _T("min(x,y,...,z) - Returns the minimum value from all of its function arguments and array elements.");
   }
 
   //------------------------------------------------------------------------------
@@ -195,7 +331,7 @@ MUP_NAMESPACE_START
   {}
 
   //------------------------------------------------------------------------------
-  /** \brief Returns the minimum value of all values.
+  /** \brief Returns the sum of all values.
       \param a_pArg Pointer to an array of Values
       \param a_iArgc Number of values stored in a_pArg
   */
@@ -204,33 +340,17 @@ MUP_NAMESPACE_START
     if (a_iArgc < 1)
         throw ParserError(ErrorContext(ecTOO_FEW_PARAMS, GetExprPos(), GetIdent()));
 
-    float_type sum(0);
-
+    sum_reduce sum(GetParent());
     for (int i=0; i<a_iArgc; ++i)
-    {
-      switch(a_pArg[i]->GetType())
-      {
-      case 'f':
-      case 'i': sum += a_pArg[i]->GetFloat();   break;
-      default:
-        {
-          ErrorContext err;
-          err.Errc = ecTYPE_CONFLICT_FUN;
-          err.Arg = i+1;
-          err.Type1 = a_pArg[i]->GetType();
-          err.Type2 = 'f';
-          throw ParserError(err);
-        }
-      }
-    }
+      reduce_numbers(*a_pArg[i], i+1, sum);
 
-    *ret = sum;
+    *ret = sum.result();
   }
 
   //------------------------------------------------------------------------------
   const char_type* FunSum::GetDesc() const
   {
-    return _T("sum(x,y,...,z) - Returns the sum of all arguments.");
+    return _T("sum(x,y,...,z) - Returns the sum of all arguments and array elements.");
   }
 
   //------------------------------------------------------------------------------
@@ -259,41 +379,307 @@ MUP_NAMESPACE_START
     if (a_iArgc < 1)
         throw ParserError(ErrorContext(ecTOO_FEW_PARAMS, GetExprPos(), GetIdent()));
 
-    float_type avg(0);
+    sum_reduce sum(GetParent());
+    for (int i=0; i<a_iArgc; ++i)
+      reduce_numbers(*a_pArg[i], i+1, sum);
+
+    *ret = sum.result() / sum.count;
+  }
+
+  //------------------------------------------------------------------------------
+  const char_type* FunAvg::GetDesc() const
+  {
+    return _T("avg(x,y,...,z) - Returns the average of all arguments and array elements.");
+  }
+
+  //------------------------------------------------------------------------------
+  IToken* FunAvg::Clone() const
+  {
+    return new FunAvg(*this);
+  }
+
+  //------------------------------------------------------------------------------
+  //
+  // class FunMedian
+  //
+  //------------------------------------------------------------------------------
+
+  FunMedian::FunMedian()
+    :ICallback(cmFUNC, _T("median"), -1)
+  {}
 
+  //------------------------------------------------------------------------------
+  /** \brief Returns the median of all values.
+      \param a_pArg Pointer to an array of Values
+      \param a_iArgc Number of values stored in a_pArg
+  */
+  void FunMedian::Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int a_iArgc)
+  {
+    if (a_iArgc < 1)
+        throw ParserError(ErrorContext(ecTOO_FEW_PARAMS, GetExprPos(), GetIdent()));
+
+    std::vector<float_type> numbers;
     for (int i=0; i<a_iArgc; ++i)
+      get_numbers(*a_pArg[i], i+1, numbers);
+
+    if (numbers.empty())
+      throw ParserError(ErrorContext(ecINVALID_PARAMETER, GetExprPos(), GetIdent(), 'm', 'f', 1));
+
+    *ret = select_rank(numbers, (numbers.size() - 1) / 2.0);
+  }
+
+  //------------------------------------------------------------------------------
+  const char_type* FunMedian::GetDesc() const
+  {
+    return _T("median(x,y,...,z) - Returns the median of all arguments and array elements.");
+  }
+
+  //------------------------------------------------------------------------------
+  IToken* FunMedian::Clone() const
+  {
+    return new FunMedian(*this);
+  }
+
+  //------------------------------------------------------------------------------
+  //
+  // class FunPercentile
+  //
+  //------------------------------------------------------------------------------
+
+  FunPercentile::FunPercentile()
+    :ICallback(cmFUNC, _T("percentile"), 2)
+  {}
+
+  //------------------------------------------------------------------------------
+  /** \brief Returns the k-th percentile of an array, k being in the range 0..1.
+
+    Values between two elements are interpolated linearly.
+  */
+  void FunPercentile::Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int a_iArgc)
+  {
+    assert(a_iArgc==2);
+    _unused(a_iArgc);
+
+    std::vector<float_type> numbers;
+    get_numbers(*a_pArg[0], 1, numbers);
+
+    if (numbers.empty())
+      throw ParserError(ErrorContext(ecINVALID_PARAMETER, GetExprPos(), GetIdent(), 'm', 'f', 1));
+
+    if (!a_pArg[1]->IsNonComplexScalar())
+      throw ParserError(ErrorContext(ecTYPE_CONFLICT_FUN, GetExprPos(), GetIdent(), a_pArg[1]->GetType(), 'f', 2));
+
+    float_type k = a_pArg[1]->GetFloat();
+    if (k < 0 || k > 1)
+      throw ParserError(ErrorContext(ecINVALID_PARAMETER, GetExprPos(), GetIdent(), 'f', 'f', 2));
+
+    *ret = select_rank(numbers, k * (numbers.size() - 1));
+  }
+
+  //------------------------------------------------------------------------------
+  const char_type* FunPercentile::GetDesc() const
+  {
+    return _T("percentile(a, k) - Returns the k-th percentile of the elements of a, k being in the range 0..1.");
+  }
+
+  //------------------------------------------------------------------------------
+  IToken* FunPercentile::Clone() const
+  {
+    return new FunPercentile(*this);
+  }
+
+  //------------------------------------------------------------------------------
+  //
+  // class FunSort
+  //
+  //------------------------------------------------------------------------------
+
+  FunSort::FunSort()
+    :ICallback(cmFUNC, _T("sort"), 1)
+  {}
+
+  //------------------------------------------------------------------------------
+  void FunSort::Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int a_iArgc)
+  {
+    assert(a_iArgc==1);
+    _unused(a_iArgc);
+
+    std::vector<float_type> numbers;
+    get_numbers(*a_pArg[0], 1, numbers);
+    std::sort(numbers.begin(), numbers.end());
+
+    set_numbers(ret, numbers, a_pArg[0]->GetRows(), a_pArg[0]->GetCols());
+  }
+
+  //------------------------------------------------------------------------------
+  const char_type* FunSort::GetDesc() const
+  {
+    return _T("sort(a) - Returns the elements of a in ascending order.");
+  }
+
+  //------------------------------------------------------------------------------
+  IToken* FunSort::Clone() const
+  {
+    return new FunSort(*this);
+  }
+
+  //------------------------------------------------------------------------------
+  //
+  // class FunRank
+  //
+  //------------------------------------------------------------------------------
+
+  FunRank::FunRank()
+    :ICallback(cmFUNC, _T("rank"), 1)
+  {}
+
+  //------------------------------------------------------------------------------
+  /** \brief Returns the rank of each element in ascending order.
+
+    Equal elements share the lowest of their ranks.
+  */
+  void FunRank::Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int a_iArgc)
+  {
+    assert(a_iArgc==1);
+    _unused(a_iArgc);
+
+    std::vector<float_type> numbers;
+    get_numbers(*a_pArg[0], 1, numbers);
+
+    std::vector<std::size_t> order(numbers.size());
+    for (std::size_t i = 0; i < order.size(); ++i)
+      order[i] = i;
+
+    std::sort(order.begin(), order.end(), [&numbers](std::size_t a, std::size_t b) {
+      return numbers[a] < numbers[b];
+    });
+
+    std::vector<float_type> ranks(numbers.size());
+    for (std::size_t i = 0; i < order.size(); ++i)
     {
-      switch(a_pArg[i]->GetType())
+      bool tie = i > 0 && numbers[order[i]] == numbers[order[i - 1]];
+      ranks[order[i]] = tie ? ranks[order[i - 1]] : (float_type)(i + 1);
+    }
+
+    set_numbers(ret, ranks, a_pArg[0]->GetRows(), a_pArg[0]->GetCols());
+  }
+
+  //------------------------------------------------------------------------------
+  const char_type* FunRank::GetDesc() const
+  {
+    return _T("rank(a) - Returns the rank of each element of a in ascending order.");
+  }
+
+  //------------------------------------------------------------------------------
+  IToken* FunRank::Clone() const
+  {
+    return new FunRank(*this);
+  }
+
+  //------------------------------------------------------------------------------
+  //
+  // class FunDistinct
+  //
+  //------------------------------------------------------------------------------
+
+  FunDistinct::FunDistinct()
+    :ICallback(cmFUNC, _T("distinct"), 1)
+  {}
+
+  //------------------------------------------------------------------------------
+  void FunDistinct::Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int a_iArgc)
+  {
+    assert(a_iArgc==1);
+    _unused(a_iArgc);
+
+    std::vector<float_type> numbers;
+    get_numbers(*a_pArg[0], 1, numbers);
+    std::sort(numbers.begin(), numbers.end());
+    numbers.erase(std::unique(numbers.begin(), numbers.end()), numbers.end());
+
+    set_numbers(ret, numbers, 1, (int)numbers.size());
+  }
+
+  //------------------------------------------------------------------------------
+  const char_type* FunDistinct::GetDesc() const
+  {
+    return _T("distinct(a) - Returns the distinct elements of a in ascending order.");
+  }
+
+  //------------------------------------------------------------------------------
+  IToken* FunDistinct::Clone() const
+  {
+    return new FunDistinct(*this);
+  }
+
+  //------------------------------------------------------------------------------
+  //
+  // class FunCountIf
+  //
+  //------------------------------------------------------------------------------
+
+  FunCountIf::FunCountIf()
+    :ICallback(cmFUNC, _T("count_if"), 2)
+  {}
+
+  //------------------------------------------------------------------------------
+  /** \brief Counts the elements of an array meeting a criterion.
+
+    The criterion is either a value the elements must be equal to or a string
+    made of a comparison operator and a value, i.e. ">5" or "<>done".
+  */
+  void FunCountIf::Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int a_iArgc)
+  {
+    assert(a_iArgc==2);
+    _unused(a_iArgc);
+
+    const IValue &crit = *a_pArg[1];
+    string_type op = _T("=");
+    string_type sVal;
+    float_type fVal = 0;
+    bool numeric = true;
+
+    if (crit.IsNonComplexScalar())
+    {
+      fVal = crit.GetFloat();
+    }
+    else if (crit.IsString())
+    {
+      split_criterion(crit.GetString(), op, sVal);
+
+      stringstream_type ss(sVal);
+      numeric = (ss >> fVal) && ss.eof();
+    }
+    else
+      throw ParserError(ErrorContext(ecTYPE_CONFLICT_FUN, GetExprPos(), GetIdent(), crit.GetType(), 's', 2));
+
+    const IValue &val = *a_pArg[0];
+    int count = 0;
+    for (int i = 0; i < val.GetRows(); ++i)
+    {
+      for (int j = 0; j < val.GetCols(); ++j)
       {
-      case 'f':
-      case 'i': avg += a_pArg[i]->GetFloat();   break;
-      default:
-        {
-          ErrorContext err;
-          err.Errc = ecTYPE_CONFLICT_FUN;
-          err.Arg = i+1;
-          err.Type1 = a_pArg[i]->GetType();
-          err.Type2 = 'f';
-          throw ParserError(err);
-        }
+        const IValue &elem = val.IsMatrix() ? val.GetArray().At(i, j) : val;
+        if (numeric && elem.IsNonComplexScalar())
+          count += compare(op, elem.GetFloat(), fVal);
+        else if (!numeric && elem.IsString())
+          count += compare(op, elem.GetString(), sVal);
       }
     }
 
-    avg = avg/a_iArgc;
-
-    *ret = avg;
+    *ret = count;
   }
 
   //------------------------------------------------------------------------------
-  const char_type* FunAvg::GetDesc() const
+  const char_type* FunCountIf::GetDesc() const
   {
-    return _T("avg(x,y,...,z) - Returns the average of all arguments.");
+    return _T("count_if(a, c) - Returns the number of elements of a meeting the criterion c, i.e. \">5\".");
   }
 
   //------------------------------------------------------------------------------
-  IToken* FunAvg::Clone() const
+  IToken* FunCountIf::Clone() const
   {
-    return new FunAvg(*this);
+    return new FunCountIf(*this);
   }
 
   //------------------------------------------------------------------------------
@@ -382,7 +768,9 @@ MUP_NAMESPACE_START
     }
 
     string_type mask = a_pArg[0]->GetString();
-    long_double_type number = a_pArg[1]->GetFloat();
+
+    // Like a string, a date has no number to apply
+    long_double_type number = (a_pArg[1]->IsDate()) ? 0 : a_pArg[1]->GetFloat();
 
     *ret = apply_mask(mask, to_string(std::round(number)));
   }
@@ -411,42 +799,14 @@ MUP_NAMESPACE_START
   //                                                                             |
   //------------------------------------------------------------------------------
 
-  // https://en.wikipedia.org/wiki/Rata_Die
-  int rata_die (int y, int m, int d) { /* Rata Die day one is 0001-01-01 */
-    if (m < 3)
-      y--, m += 12;
-    return 365*y + y/4 - y/100 + y/400 + (153*m - 457)/5 + d - 306;
-  }
-
-  string_type format_date (struct tm time, bool is_date_time) {
-    string_type year  = std::to_string(time.tm_year + 1900);
-    string_type month = std::to_string(time.tm_mon + 1);
-    string_type day   = std::to_string(time.tm_mday);
-    string_type hours = std::to_string(time.tm_hour);
-    string_type min   = std::to_string(time.tm_min);
-
-    month = month.length() > 1 ? month : '0' + month;
-    day = day.length() > 1 ? day : '0' + day;
-    hours = hours.length() > 1 ? hours : '0' + hours;
-    min = min.length() > 1 ? min : '0' + min;
-
-    if (is_date_time) {
-      return(year + "-" + month + "-" + day + "T" + hours + ":" + min);
-    } else {
-      return(year + "-" + month + "-" + day);
+  // Date values are used as they are, strings are read as "yyyy-mm-dd" or "yyyy-mm-ddTHH:MM[:SS]"
+  bool get_date (const IValue &val, date_type &date) {
+    if (val.IsDate()) {
+      date = val.GetDate();
+      return true;
     }
-  }
-
-  void add_days (struct tm* date, float_type days) {
-    // Avoid mismatch between winter and summer time on mktime() conversion
-    date->tm_isdst = -1;
-
-    // Seconds since start of epoch
-    time_t new_day = mktime(date) + (days * ONE_DAY);
 
-    // Update caller's date
-    // localtime is used because mktime converts from localtime to UTC and we need to convert it back
-    *date = *localtime(&new_day);
+    return ParseDate(val.GetString(), date);
   }
 
   void raise_error (EErrorCodes error, int position, const ptr_val_type *arguments) {
@@ -458,6 +818,66 @@ MUP_NAMESPACE_START
     throw ParserError(err);
   }
 
+  // Date functions given matrices compute one result per element with the kernels of
+  // mpDate.h. Returns true and the size of the matrices if there is a matrix argument.
+  bool is_batch (const ptr_val_type *a_pArg, int a_iArgc, const string_type &ident, int &rows, int &cols) {
+    bool batch = false;
+    rows = cols = 1;
+
+    for (int i = 0; i < a_iArgc; ++i) {
+      if (!a_pArg[i]->IsMatrix()) {
+        continue;
+      }
+
+      if (!batch) {
+        rows = a_pArg[i]->GetRows();
+        cols = a_pArg[i]->GetCols();
+        batch = true;
+      } else if (a_pArg[i]->GetRows() != rows || a_pArg[i]->GetCols() != cols) {
+        throw ParserError(ErrorContext(ecARRAY_SIZE_MISMATCH, -1, ident, 'm', 'm', i + 1));
+      }
+    }
+
+    return batch;
+  }
+
+  // Reads the dates of a batch argument row by row, a scalar is used for every element
+  bool get_dates (const IValue &val, std::vector<date_type> &dates) {
+    if (!val.IsMatrix()) {
+      date_type date;
+      if (!get_date(val, date)) {
+        return false;
+      }
+
+      dates.assign(dates.size(), date);
+      return true;
+    }
+
+    const matrix_type &m = val.GetArray();
+    for (int i = 0; i < m.GetRows(); ++i) {
+      for (int j = 0; j < m.GetCols(); ++j) {
+        if (!get_date(m.At(i, j), dates[i * m.GetCols() + j])) {
+          return false;
+        }
+      }
+    }
+
+    return true;
+  }
+
+  // Returns the results of a batch stored row by row as a matrix
+  template<typename T>
+  void set_batch_result (ptr_val_type &ret, const std::vector<T> &out, int rows, int cols) {
+    matrix_type res(rows, cols, 0.0);
+    for (int i = 0; i < rows; ++i) {
+      for (int j = 0; j < cols; ++j) {
+        res.At(i, j) = out[i * cols + j];
+      }
+    }
+
+    *ret = res;
+  }
+
   string_type localized_weekday(int week_day, const ptr_val_type *a_pArg) {
     string_type locale = a_pArg[1]->GetString();
     string_type ret = "";
@@ -509,27 +929,41 @@ MUP_NAMESPACE_START
       throw ParserError(ErrorContext(ecTOO_MANY_PARAMS, GetExprPos(), GetIdent()));
     }
 
-    string_type date_a = a_pArg[0]->GetString();
-    string_type date_b = a_pArg[1]->GetString();
+    int rows, cols;
+    if (is_batch(a_pArg, a_iArgc, GetIdent(), rows, cols)) {
+      int size = rows * cols;
+      std::vector<date_type> dates_a(size), dates_b(size);
+      if (!get_dates(*a_pArg[0], dates_a)) {
+        raise_error(ecINVALID_DATE_FORMAT, 1, a_pArg);
+      }
+      if (!get_dates(*a_pArg[1], dates_b)) {
+        raise_error(ecINVALID_DATE_FORMAT, 2, a_pArg);
+      }
 
-    struct tm tm, tm2;
-    //http://man7.org/linux/man-pages/man3/strptime.3.html
-    if (!strptime(date_a.c_str(), "%Y-%m-%d", &tm)) {
+      std::vector<int_type> days_a(size), days_b(size), out(size);
+      DaysOfDates(dates_a.data(), days_a.data(), size);
+      DaysOfDates(dates_b.data(), days_b.data(), size);
+      DaysDiff(days_a.data(), days_b.data(), out.data(), size);
+      set_batch_result(ret, out, rows, cols);
+      return;
+    }
+
+    date_type date_a, date_b;
+    if (!get_date(*a_pArg[0], date_a)) {
       raise_error(ecINVALID_DATE_FORMAT, 1, a_pArg);
     }
-    if (!strptime(date_b.c_str(), "%Y-%m-%d", &tm2)) {
+    if (!get_date(*a_pArg[1], date_b)) {
       raise_error(ecINVALID_DATE_FORMAT, 2, a_pArg);
     }
 
-    int total_days1 = rata_die(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
-    int total_days2 = rata_die(tm2.tm_year + 1900, tm2.tm_mon + 1, tm2.tm_mday);
-
-    *ret = abs(total_days1 - total_days2);
+    int_type days_a = DaysOfDate(date_a), days_b = DaysOfDate(date_b), days;
+    DaysDiff(&days_a, &days_b, &days, 1);
+    *ret = days;
   }
 
   const char_type* FunDaysDiff::GetDesc() const
   {
-    return _T("daysdiff(a,b) - Returns the difference in days between two dates.");
+    return _T("daysdiff(a,b) - Returns the difference in days between two dates or arrays of dates.");
   }
 
   IToken* FunDaysDiff::Clone() const
@@ -560,42 +994,54 @@ MUP_NAMESPACE_START
       throw ParserError(ErrorContext(ecTOO_MANY_PARAMS, GetExprPos(), GetIdent()));
     }
 
-    string_type date_a = a_pArg[0]->GetString();
-    string_type date_b = a_pArg[1]->GetString();
+    int rows, cols;
+    if (is_batch(a_pArg, a_iArgc, GetIdent(), rows, cols)) {
+      int size = rows * cols;
+      std::vector<date_type> dates_a(size), dates_b(size);
+      if (!get_dates(*a_pArg[0], dates_a)) {
+        raise_error(ecINVALID_DATETIME_FORMAT, 1, a_pArg);
+      }
+      if (!get_dates(*a_pArg[1], dates_b)) {
+        raise_error(ecINVALID_DATETIME_FORMAT, 2, a_pArg);
+      }
+      for (int i = 0; i < size; ++i) {
+        if (dates_a[i].IsTime != dates_b[i].IsTime) {
+          raise_error(ecDATE_AND_DATETIME, 1, a_pArg);
+        }
+      }
 
-    // Matches exactly: "yyyy-mm-dd"
-    std::regex basic_date ("^\\d{4}-\\d{1,2}-\\d{1,2}$");
-    if (std::regex_match (date_a, basic_date) && std::regex_match (date_b, basic_date)) {
-      date_a += "T00:00";
-      date_b += "T00:00";
-    } else if (std::regex_match (date_a, basic_date) || std::regex_match (date_b, basic_date)) {
-      raise_error(ecDATE_AND_DATETIME, 1, a_pArg);
+      std::vector<float_type> seconds_a(size), seconds_b(size), out(size);
+      SecondsOfDates(dates_a.data(), seconds_a.data(), size);
+      SecondsOfDates(dates_b.data(), seconds_b.data(), size);
+      HoursDiff(seconds_a.data(), seconds_b.data(), out.data(), size);
+      set_batch_result(ret, out, rows, cols);
+      return;
     }
 
-    // http://man7.org/linux/man-pages/man3/strptime.3.html
-    struct tm tm, tm2;
-    if (!strptime(date_a.c_str(), "%Y-%m-%dT%H:%M", &tm)) {
+    date_type date_a, date_b;
+    bool valid_a = get_date(*a_pArg[0], date_a);
+    bool valid_b = get_date(*a_pArg[1], date_b);
+
+    // Either two dates or two date times
+    if ((valid_a && !date_a.IsTime) != (valid_b && !date_b.IsTime)) {
+      raise_error(ecDATE_AND_DATETIME, 1, a_pArg);
+    }
+    if (!valid_a) {
       raise_error(ecINVALID_DATETIME_FORMAT, 1, a_pArg);
     }
-    if (!strptime(date_b.c_str(), "%Y-%m-%dT%H:%M", &tm2)) {
+    if (!valid_b) {
       raise_error(ecINVALID_DATETIME_FORMAT, 2, a_pArg);
     }
 
-    int total_days1 = rata_die(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
-    int total_days2 = rata_die(tm2.tm_year + 1900, tm2.tm_mon + 1, tm2.tm_mday);
-    int daysdiff = total_days2 - total_days1;
-
-    float_type initial_hours = tm.tm_hour + tm.tm_min/60.0;
-    float_type final_hours = tm2.tm_hour + tm2.tm_min/60.0;
-    float_type hoursdiff = daysdiff * 24 + (final_hours - initial_hours);
-
-    // Should be rounded with precision 2. (Ex: 3.67)
-    *ret = (std::round(hoursdiff * 100)) / 100;
+    // Rounded with precision 2. (Ex: 3.67)
+    float_type seconds_a = SecondsOfDate(date_a), seconds_b = SecondsOfDate(date_b), hours;
+    HoursDiff(&seconds_a, &seconds_b, &hours, 1);
+    *ret = hours;
   }
 
   const char_type* FunHoursDiff::GetDesc() const
   {
-    return _T("hoursdiff(a,b) - Returns the difference in hours between two dates.");
+    return _T("hoursdiff(a,b) - Returns the difference in hours between two dates or arrays of dates.");
   }
 
   IToken* FunHoursDiff::Clone() const
@@ -611,7 +1057,10 @@ MUP_NAMESPACE_START
 
   FunCurrentDate::FunCurrentDate()
     :ICallback(cmFUNC, _T("current_date"), -1)
-  {}
+  {
+    // The result depends on the time of the call
+    AddFlags(flVOLATILE);
+  }
   //------------------------------------------------------------------------------
   /** \brief Returns the current date with format yyyy-mm-dd.
       \param a_pArg Pointer to an array of Values
@@ -626,7 +1075,7 @@ MUP_NAMESPACE_START
     std::time_t t = std::time(0); // get time now
     std::tm now = *std::localtime(&t);
 
-    *ret = format_date(now, false);
+    *ret = date_type((float_type)DaysFromCivil(now.tm_year + 1900, now.tm_mon + 1, now.tm_mday), false);
   }
 
   //------------------------------------------------------------------------------
@@ -663,32 +1112,29 @@ MUP_NAMESPACE_START
       throw ParserError(ErrorContext(ecTOO_MANY_PARAMS, GetExprPos(), GetIdent()));
     }
 
-    string_type date = a_pArg[0]->GetString();
+    date_type date;
     float_type days = a_pArg[1]->GetFloat(); // Accept both integer or float numbers! :D
 
-    std::regex date_regex ("^\\d{4}-\\d{1,2}-\\d{1,2}$"); // "yyyy-mm-dd"
-    std::regex date_time_regex ("^\\d{4}-\\d{1,2}-\\d{1,2}T\\d{1,2}:\\d{1,2}$"); // "yyyy-mm-ddTHH:MM"
-    bool is_date_time = false;
-
-    // http://man7.org/linux/man-pages/man3/strptime.3.html
-    struct tm time = {0};
-    if (std::regex_match (date, date_regex)) {
-      if (!strptime(date.c_str(), "%Y-%m-%d", &time)) {
+    if (!get_date(*a_pArg[0], date)) {
+      // Tell a misshaped string from a date or date time out of range
+      string_type text = a_pArg[0]->GetString();
+      if (std::regex_match (text, std::regex("^\\d{4}-\\d{1,2}-\\d{1,2}$"))) {
         raise_error(ecADD_HOURS_DATE, 1, a_pArg);
-      }
-      is_date_time = false;
-    } else if (std::regex_match (date, date_time_regex)) {
-      if (!strptime(date.c_str(), "%Y-%m-%dT%H:%M", &time)) {
+      } else if (std::regex_match (text, std::regex("^\\d{4}-\\d{1,2}-\\d{1,2}T\\d{1,2}:\\d{1,2}$"))) {
         raise_error(ecADD_HOURS_DATETIME, 1, a_pArg);
+      } else {
+        raise_error(ecADD_HOURS, 1, a_pArg);
       }
-      is_date_time = true;
-    } else {
-      raise_error(ecADD_HOURS, 1, a_pArg);
     }
 
-    add_days(&time, days);
+    // Dates drop the fraction of a day, date times keep whole seconds
+    if (date.IsTime) {
+      date.Val = std::round(date.Val + days * SECONDS_PER_DAY);
+    } else {
+      date.Val += std::floor(days);
+    }
 
-    *ret = format_date(time, is_date_time);
+    *ret = date;
   }
 
   //------------------------------------------------------------------------------
@@ -703,6 +1149,58 @@ MUP_NAMESPACE_START
     return new FunAddDays(*this);
   }
 
+  //------------------------------------------------------------------------------
+  //
+  // class FunDate
+  //
+  //------------------------------------------------------------------------------
+
+  FunDate::FunDate(bool bTime)
+    :ICallback(cmFUNC, bTime ? _T("datetime") : _T("date"), 1)
+    ,m_bTime(bTime)
+  {}
+
+  //------------------------------------------------------------------------------
+  /** \brief Converts a string or a date value into a date or a date time.
+      \param a_pArg Pointer to an array of Values
+      \param a_iArgc Number of values stored in a_pArg
+
+    The string is read once, the date functions then work on the value directly.
+    A date converted to a date time starts at midnight, a date time converted to a
+    date loses its time of day.
+  */
+  void FunDate::Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int a_iArgc)
+  {
+    assert(a_iArgc==1);
+    _unused(a_iArgc);
+
+    date_type date;
+    if (!get_date(*a_pArg[0], date)) {
+      raise_error(m_bTime ? ecINVALID_DATETIME_FORMAT : ecINVALID_DATE_FORMAT, 1, a_pArg);
+    }
+
+    if (m_bTime && !date.IsTime) {
+      date = date_type(date.Val * SECONDS_PER_DAY, true);
+    } else if (!m_bTime && date.IsTime) {
+      date = date_type((float_type)DaysOfDate(date), false);
+    }
+
+    *ret = date;
+  }
+
+  //------------------------------------------------------------------------------
+  const char_type* FunDate::GetDesc() const
+  {
+    return m_bTime ? _T("datetime(x) - Converts \"yyyy-mm-ddTHH:MM[:SS]\" or a date into a date time.")
+                   : _T("date(x) - Converts \"yyyy-mm-dd\" or a date time into a date.");
+  }
+
+  //------------------------------------------------------------------------------
+  IToken* FunDate::Clone() const
+  {
+    return new FunDate(*this);
+  }
+
 
   //FunTimeDiff::FunTimeDiff()
   //  :ICallback(cmFUNC, _T("timediff"), -1)
@@ -885,7 +1383,10 @@ MUP_NAMESPACE_START
 
   FunCurrentTime::FunCurrentTime()
     :ICallback(cmFUNC, _T("current_time"), -1)
-  {}
+  {
+    // The result depends on the time of the call
+    AddFlags(flVOLATILE);
+  }
 
   void FunCurrentTime::Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int a_iArgc)
   {
@@ -938,24 +1439,6 @@ MUP_NAMESPACE_START
     :ICallback(cmFUNC, _T("regex"), -1)
   {}
 
-  std::vector<std::vector<std::string>> capture_regex_groups(const std::string& input, const std::string& pattern) {
-    std::vector<std::vector<std::string>> captured_groups;
-    std::smatch match;
-    std::regex re(pattern);
-    std::string::const_iterator search_start(input.cbegin());
-
-    while (std::regex_search(search_start, input.cend(), match, re)) {
-        std::vector<std::string> groups;
-        for (size_t i = 1; i < match.size(); ++i) {
-            groups.push_back(match[i].str());
-        }
-        captured_groups.push_back(groups);
-        search_start = match.suffix().first;
-    }
-
-    return captured_groups;
-  }
-
   void FunRegex::Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int a_iArgc)
   {
     if (a_iArgc < 2) {
@@ -964,15 +1447,15 @@ MUP_NAMESPACE_START
       throw ParserError(ErrorContext(ecTOO_MANY_PARAMS, GetExprPos(), GetIdent()));
     }
 
-     string_type input = a_pArg[0]->GetString();
-     string_type pattern = a_pArg[1]->GetString();
-
-     auto captured_groups = capture_regex_groups(input, pattern);
+     const string_type &input = a_pArg[0]->GetString();
+     std::regex re(a_pArg[1]->GetString());
 
-     if (captured_groups.size() == 0 || captured_groups[0].size() == 0) {
-       *ret = (string_type) "";
+     // The first group of the first match is returned
+     std::smatch match;
+     if (std::regex_search(input, match, re) && match.size() > 1 && match[1].matched) {
+       *ret = match.str(1);
      } else {
-       *ret = (string_type) captured_groups[0][0];
+       *ret = (string_type) "";
      }
   }
 
@@ -1007,47 +1490,35 @@ MUP_NAMESPACE_START
       throw ParserError(ErrorContext(ecTOO_MANY_PARAMS, GetExprPos(), GetIdent()));
     }
 
-    string_type date_time = a_pArg[0]->GetString();
-
-    struct tm date;
-    if (!strptime(date_time.c_str(), "%Y-%m-%d", &date)) {
-      raise_error(ecINVALID_DATE_FORMAT, 1, a_pArg);
-    }
-
-    int year = date.tm_year + 1900; // tm_year is the number of years since 1900
-
-    // Get ordinal day of the year
-    int day_of_year = date.tm_yday + 1; // tm_yday is the number of days since January 1st
-
-    // Get weekday number (0 is Sunday)
-    int weekday = date.tm_wday;
-
-    // Calculate week number
-    int week_number = (day_of_year - weekday + 10) / 7;
+    int rows, cols;
+    if (is_batch(a_pArg, a_iArgc, GetIdent(), rows, cols)) {
+      int size = rows * cols;
+      std::vector<date_type> dates(size);
+      if (!get_dates(*a_pArg[0], dates)) {
+        raise_error(ecINVALID_DATE_FORMAT, 1, a_pArg);
+      }
 
-    // Check if week belongs to previous year
-    if (week_number == 0) {
-        year--;
-        week_number = 52;
-        if (std::tm{0,0,0,1,0,year-1900}.tm_wday < 4) { // January 1st of the previous year is before Thursday
-            week_number = 53;
-        }
+      std::vector<int_type> days(size), out(size);
+      DaysOfDates(dates.data(), days.data(), size);
+      WeeksOfYear(days.data(), out.data(), size);
+      set_batch_result(ret, out, rows, cols);
+      return;
     }
 
-    // Check if week belongs to following year
-    if (week_number == 53) {
-        if (std::tm{0,0,0,1,0,year+1-1900}.tm_wday >= 4) { // January 1st of the following year is on or after Thursday
-            week_number = 1;
-        }
+    date_type date;
+    if (!get_date(*a_pArg[0], date)) {
+      raise_error(ecINVALID_DATE_FORMAT, 1, a_pArg);
     }
 
+    int_type days = DaysOfDate(date), week_number;
+    WeeksOfYear(&days, &week_number, 1);
     *ret = week_number;
   }
 
   ////------------------------------------------------------------------------------
   const char_type* FunWeekYear::GetDesc() const
   {
-    return _T("weekyear(date) - Returns the week number of the year.");
+    return _T("weekyear(date) - Returns the week number of the year of a date or an array of dates.");
   }
 
   ////------------------------------------------------------------------------------
@@ -1076,19 +1547,42 @@ MUP_NAMESPACE_START
       throw ParserError(ErrorContext(ecTOO_MANY_PARAMS, GetExprPos(), GetIdent()));
     }
 
-    string_type date_time = a_pArg[0]->GetString();
-
-    struct tm date;
-    if (!strptime(date_time.c_str(), "%Y-%m-%d", &date)) {
-      raise_error(ecINVALID_DATETIME_FORMAT, 1, a_pArg);
-    }
-
     bool has_locale = false;
     if (a_iArgc == 2) {
       has_locale = true;
     }
 
-    int week_day = date.tm_wday;
+    int rows, cols;
+    if (is_batch(a_pArg, 1, GetIdent(), rows, cols)) {
+      int size = rows * cols;
+      std::vector<date_type> dates(size);
+      if (!get_dates(*a_pArg[0], dates)) {
+        raise_error(ecINVALID_DATETIME_FORMAT, 1, a_pArg);
+      }
+
+      std::vector<int_type> days(size), out(size);
+      DaysOfDates(dates.data(), days.data(), size);
+      Weekdays(days.data(), out.data(), size);
+
+      if (has_locale) {
+        matrix_type res(rows, cols, string_type());
+        for (int i = 0; i < size; ++i) {
+          res.At(i / cols, i % cols) = localized_weekday((int)out[i], a_pArg);
+        }
+        *ret = res;
+      } else {
+        set_batch_result(ret, out, rows, cols);
+      }
+      return;
+    }
+
+    date_type date;
+    if (!get_date(*a_pArg[0], date)) {
+      raise_error(ecINVALID_DATETIME_FORMAT, 1, a_pArg);
+    }
+
+    int_type days = DaysOfDate(date), week_day;
+    Weekdays(&days, &week_day, 1);
 
     if(has_locale) {
       *ret = localized_weekday(week_day, a_pArg);
@@ -1100,7 +1594,7 @@ MUP_NAMESPACE_START
   ////------------------------------------------------------------------------------
   const char_type* FunWeekDay::GetDesc() const
   {
-    return _T("weekday(date) - Returns the week day of the date.");
+    return _T("weekday(date) - Returns the week day of a date or an array of dates.");
   }
 
   ////------------------------------------------------------------------------------
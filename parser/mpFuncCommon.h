@@ -105,6 +105,84 @@ MUP_NAMESPACE_START
     virtual IToken* Clone() const override;
   }; // class FunAvg
 
+  //------------------------------------------------------------------------------
+  /** \brief Determine the median of the parameter list.
+      \ingroup functions
+  */
+  class FunMedian : public ICallback
+  {
+  public:
+    FunMedian();
+    virtual void Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int a_iArgc) override;
+    virtual const char_type* GetDesc() const override;
+    virtual IToken* Clone() const override;
+  }; // class FunMedian
+
+  //------------------------------------------------------------------------------
+  /** \brief Determine a percentile of the elements of an array.
+      \ingroup functions
+  */
+  class FunPercentile : public ICallback
+  {
+  public:
+    FunPercentile();
+    virtual void Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int a_iArgc) override;
+    virtual const char_type* GetDesc() const override;
+    virtual IToken* Clone() const override;
+  }; // class FunPercentile
+
+  //------------------------------------------------------------------------------
+  /** \brief Sort the elements of an array.
+      \ingroup functions
+  */
+  class FunSort : public ICallback
+  {
+  public:
+    FunSort();
+    virtual void Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int a_iArgc) override;
+    virtual const char_type* GetDesc() const override;
+    virtual IToken* Clone() const override;
+  }; // class FunSort
+
+  //------------------------------------------------------------------------------
+  /** \brief Determine the rank of each element of an array.
+      \ingroup functions
+  */
+  class FunRank : public ICallback
+  {
+  public:
+    FunRank();
+    virtual void Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int a_iArgc) override;
+    virtual const char_type* GetDesc() const override;
+    virtual IToken* Clone() const override;
+  }; // class FunRank
+
+  //------------------------------------------------------------------------------
+  /** \brief Determine the distinct elements of an array.
+      \ingroup functions
+  */
+  class FunDistinct : public ICallback
+  {
+  public:
+    FunDistinct();
+    virtual void Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int a_iArgc) override;
+    virtual const char_type* GetDesc() const override;
+    virtual IToken* Clone() const override;
+  }; // class FunDistinct
+
+  //------------------------------------------------------------------------------
+  /** \brief Count the elements of an array meeting a criterion.
+      \ingroup functions
+  */
+  class FunCountIf : public ICallback
+  {
+  public:
+    FunCountIf();
+    virtual void Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int a_iArgc) override;
+    virtual const char_type* GetDesc() const override;
+    virtual IToken* Clone() const override;
+  }; // class FunCountIf
+
   //------------------------------------------------------------------------------
   /** \brief Parser function callback for determining the size of an array.
       \ingroup functions
@@ -185,6 +263,22 @@ MUP_NAMESPACE_START
     virtual IToken* Clone() const override;
   }; // class FunAddDays
 
+  //------------------------------------------------------------------------------
+  /** \brief Convert a string into a date or a date time value.
+      \ingroup functions
+  */
+  class FunDate : public ICallback
+  {
+  public:
+    FunDate(bool bTime);
+    virtual void Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int a_iArgc) override;
+    virtual const char_type* GetDesc() const override;
+    virtual IToken* Clone() const override;
+
+  private:
+    bool m_bTime;  ///< True for datetime(), false for date()
+  }; // class FunDate
+
   //------------------------------------------------------------------------------
   /** \brief Determine the difference in hours between two times.
       \ingroup functions
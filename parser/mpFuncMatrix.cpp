@@ -49,6 +49,19 @@
 
 MUP_NAMESPACE_START
 
+namespace
+{
+    /** \brief Returns the storage mode for a new matrix of mostly zero elements.
+
+        Large matrices are created sparse, so that filling a few of their elements
+        does not require memory for all of them.
+    */
+    matrix_type::EMatrixStorageMode GetZerosStorageMode(int m, int n)
+    {
+        return (m * n >= MUP_SPARSE_MIN_SIZE) ? matrix_type::msmSPARSE : matrix_type::msmDENSE;
+    }
+} // anonymous namespace
+
 //-----------------------------------------------------------------------
 //
 //  class FunMatrixOnes
@@ -135,7 +148,7 @@ void FunMatrixZeros::Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int arg
     }
     else
     {
-        *ret = matrix_type(m, n, 0.0);
+        *ret = matrix_type(m, n, 0.0, GetZerosStorageMode(m, n));
     }
 }
 
@@ -180,7 +193,7 @@ void FunMatrixEye::Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int argc)
     int m = a_pArg[0]->GetInteger(),
         n = (argc == 1) ? m : a_pArg[1]->GetInteger();
 
-    matrix_type eye(m, n, 0.0);
+    matrix_type eye(m, n, 0.0, GetZerosStorageMode(m, n));
 
     for (int i = 0; i < std::min(m, n); ++i)
     {
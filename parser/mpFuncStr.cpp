@@ -34,7 +34,10 @@
 #include <cassert>
 #include <cstdio>
 #include <cwchar>
+#include <clocale>
+#include <cstring>
 #include <algorithm>
+#include <utility>
 
 #include "mpValue.h"
 #include "mpError.h"
@@ -42,6 +45,28 @@
 
 
 MUP_NAMESPACE_START
+  //------------------------------------------------------------------------------
+  /** \brief Write a value with six decimals and without trailing zeros.
+  
+    This is the output string() had in former versions. The decimal separator is 
+    always a dot, whatever the locale.
+  */
+  static string_type FormatFixedCompat(float_type val)
+  {
+    char buf[400];
+    std::snprintf(buf, sizeof(buf), "%.6f", val);
+    string_type str(buf);
+
+    const char *szPoint = std::localeconv()->decimal_point;
+    string_type::size_type pos = str.find(szPoint);
+    if (pos!=string_type::npos && std::strcmp(szPoint, ".")!=0)
+      str.replace(pos, std::strlen(szPoint), ".");
+
+    string_type::size_type last = str.find_last_not_of('0');
+    str.erase(last + ((last==str.find('.')) ? 0 : 1));
+    return str;
+  }
+
   //------------------------------------------------------------------------------
   //
   // Concat function
@@ -55,9 +80,13 @@ MUP_NAMESPACE_START
   //------------------------------------------------------------------------------
   void FunStrConcat::Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int)
   {
-    string_type str1 = a_pArg[0]->GetString();
-    string_type str2 = a_pArg[1]->GetString();
-    *ret = (string_type) str1 + str2;
+    const string_type &str1 = a_pArg[0]->GetString();
+    const string_type &str2 = a_pArg[1]->GetString();
+
+    string_type result;
+    result.reserve(str1.size() + str2.size());
+    result.append(str1).append(str2);
+    *ret = std::move(result);
   }
 
   //------------------------------------------------------------------------------
@@ -90,10 +119,17 @@ MUP_NAMESPACE_START
     if (a_iArgc > 3)
       throw ParserError(ErrorContext(ecTOO_MANY_PARAMS, GetExprPos(), GetIdent()));
 
-    string_type str1 = a_pArg[0]->GetString();
-    string_type str2 = a_pArg[1]->GetString();
-    string_type opAttr = a_iArgc == 3 ? " download=\"" + a_pArg[2]->GetString() + "\">" : ">";
-    *ret = (string_type) "<a href=\"" + str2 +"\"" + opAttr + str1 + "</a>";
+    const string_type &str1 = a_pArg[0]->GetString();
+    const string_type &str2 = a_pArg[1]->GetString();
+    const string_type *download = a_iArgc == 3 ? &a_pArg[2]->GetString() : nullptr;
+
+    string_type result;
+    result.reserve(str1.size() + str2.size() + (download ? download->size() + 12 : 0) + 15);
+    result.append("<a href=\"").append(str2).append("\"");
+    if (download)
+      result.append(" download=\"").append(*download).append("\"");
+    result.append(">").append(str1).append("</a>");
+    *ret = std::move(result);
   }
 
   //------------------------------------------------------------------------------
@@ -122,12 +158,10 @@ MUP_NAMESPACE_START
   //------------------------------------------------------------------------------
   void FunStrLeft::Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int)
   {
-    string_type str = a_pArg[0]->GetString();
+    const string_type &str = a_pArg[0]->GetString();
     int cut = a_pArg[1]->GetInteger();
 
-    str = str.substr(0, cut);
-
-    *ret = (string_type) str;
+    *ret = str.substr(0, cut);
   }
 
   //------------------------------------------------------------------------------
@@ -155,14 +189,12 @@ MUP_NAMESPACE_START
   //------------------------------------------------------------------------------
   void FunStrRight::Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int)
   {
-    string_type str = a_pArg[0]->GetString();
+    const string_type &str = a_pArg[0]->GetString();
     int cut = a_pArg[1]->GetInteger();
 
-    cut = std::min(cut, (int)str.size());
+    cut = std::max(0, std::min(cut, (int)str.size()));
 
-    str = str.substr(str.size() - cut, str.size());
-
-    *ret = (string_type) str;
+    *ret = str.substr(str.size() - cut);
   }
 
   //------------------------------------------------------------------------------
@@ -186,12 +218,12 @@ MUP_NAMESPACE_START
     return value == NULL ? standard : value;
   }
 
-  string_type default_value(string_type value, string_type standard) {
+  const string_type& default_value(const string_type &value, const string_type &standard) {
     return value.empty() ? standard : value;
   }
 
   // If the value is an integer, it is NULL, therefore return standard
-  string_type default_value(int_type value, string_type standard) {
+  const string_type& default_value(int_type value, const string_type &standard) {
     return standard;
   }
 
@@ -221,8 +253,6 @@ MUP_NAMESPACE_START
     int_type integer_standard;
     float_type float_value;
     float_type float_standard;
-    string_type string_value;
-    string_type string_standard;
     bool_type bool_value;
     bool_type bool_standard;
 
@@ -232,6 +262,10 @@ MUP_NAMESPACE_START
     first_param_type = first_param_type == 'i' ? 'f' : first_param_type;
     second_param_type = second_param_type == 'i' ? 'f' : second_param_type;
 
+    // Dates are used by their text, like strings
+    first_param_type = a_pArg[0]->IsDate() ? 's' : first_param_type;
+    second_param_type = a_pArg[1]->IsDate() ? 's' : second_param_type;
+
     if (first_param_type != second_param_type) {
       if (a_pArg[0]->GetInteger() != NULL) {
         throw ParserError(ErrorContext(ecINVALID_TYPES_MATCH, GetExprPos(), GetIdent()));
@@ -261,14 +295,14 @@ MUP_NAMESPACE_START
     }
 
     if (second_param_type == 's') {
-      string_standard = a_pArg[1]->GetString();
+      const string_type &string_standard = a_pArg[1]->GetString();
 
       if (a_pArg[0]->GetType() == 'i') { // NULL first parameter
         integer_value = a_pArg[0]->GetInteger();
         *ret = default_value(integer_value, string_standard);
-      } else if (a_pArg[0]->GetType() == 's') { // NOT NULL first parameter
-        string_value = a_pArg[0]->GetString();
-        *ret = (string_type) default_value(string_value, string_standard);
+      } else if (a_pArg[0]->GetType() == 's' || a_pArg[0]->IsDate()) { // NOT NULL first parameter
+        const string_type &string_value = a_pArg[0]->GetString();
+        *ret = default_value(string_value, string_standard);
       }
 
       return;
@@ -300,8 +334,7 @@ MUP_NAMESPACE_START
   //------------------------------------------------------------------------------
   void FunStrLen::Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int)
   {
-    string_type str = a_pArg[0]->GetString();
-    *ret = (float_type)str.length();
+    *ret = (float_type)a_pArg[0]->GetString().length();
   }
 
   //------------------------------------------------------------------------------
@@ -398,11 +431,10 @@ MUP_NAMESPACE_START
     assert(a_iArgc==1);
     _unused(a_iArgc);
 
-    string_type in;
     double out;   // <- Ich will hier wirklich double, auch wenn der Type long double
                   // ist. sscanf und long double geht nicht mit GCC!
 
-    in = a_pArg[0]->GetString();
+    const string_type &in = a_pArg[0]->GetString();
 
 #ifndef _UNICODE
     sscanf(in.c_str(), "%lf", &out);
@@ -441,15 +473,14 @@ MUP_NAMESPACE_START
     assert(a_iArgc==1);
     _unused(a_iArgc);
 
-    string_type string_value;
     int_type    integer_value;
     float_type  float_value;
     bool_type   bool_value;
 
     double out;
 
-    if (a_pArg[0]->GetType() == 's') {
-      string_value = a_pArg[0]->GetString();
+    if (a_pArg[0]->GetType() == 's' || a_pArg[0]->IsDate()) {
+      const string_type &string_value = a_pArg[0]->GetString();
 
       #ifndef _UNICODE
           sscanf(string_value.c_str(), "%lf", &out);
@@ -496,17 +527,6 @@ MUP_NAMESPACE_START
   //
   //------------------------------------------------------------------------------
 
-  // auxiliary string() functions
-  string_type to_string(long_double_type number) {
-    std::string string_number = std::to_string (number);
-    int offset = 1;
-    if (string_number.find_last_not_of('0') == string_number.find('.')) {
-      offset = 0;
-    }
-    string_number.erase(string_number.find_last_not_of('0') + offset, std::string::npos);
-    return string_number;
-  }
-
   // string() defines
   FunString::FunString()
     :ICallback(cmFUNC, _T("string"), 1)
@@ -521,16 +541,20 @@ MUP_NAMESPACE_START
     int_type    integer_value;
     float_type  float_value;
     bool_type   bool_value;
-    string_type string_value;
+
+    char_type buf[FORMAT_BUF_SIZE];
 
     if (a_pArg[0]->GetType() == 'i') {
       integer_value = a_pArg[0]->GetInteger();
-      *ret = (string_type) to_string(integer_value);
+      *ret = string_type(buf, FormatInt(integer_value, buf));
     }
 
     if (a_pArg[0]->GetType() == 'f') {
       float_value = a_pArg[0]->GetFloat();
-      *ret = (string_type) to_string(float_value);
+      if (Value::GetFormatMode()==fmCOMPAT)
+        *ret = FormatFixedCompat(float_value);
+      else
+        *ret = string_type(buf, FormatFloat(float_value, buf, fmSHORTEST));
     }
 
     if (a_pArg[0]->GetType() == 'b') {
@@ -538,9 +562,8 @@ MUP_NAMESPACE_START
       *ret = (string_type) (bool_value ? "true" : "false");
     }
 
-    if (a_pArg[0]->GetType() == 's') {
-      string_value = a_pArg[0]->GetString();
-      *ret = (string_type) string_value;
+    if (a_pArg[0]->GetType() == 's' || a_pArg[0]->IsDate()) {
+      *ret = a_pArg[0]->GetString();
     }
 
     return;
@@ -597,14 +620,17 @@ MUP_NAMESPACE_START
 
   FunStrCalculate::FunStrCalculate()
     :ICallback(cmFUNC, _T("calculate"), 1)
-  {}
+  {
+    // The equation may call functions whose result is not reproducible
+    AddFlags(flVOLATILE);
+  }
 
   //------------------------------------------------------------------------------
   void FunStrCalculate::Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int)
   {
     using namespace std;
 
-    string_type equation = a_pArg[0]->GetString();
+    const string_type &equation = a_pArg[0]->GetString();
 
     *ret = EquationsParser::Calc(equation);
   }
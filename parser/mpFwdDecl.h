@@ -47,6 +47,7 @@ MUP_NAMESPACE_START
   class IOprtIndex;
   class Value;
   class ValueCache;
+  class MemoryResource;
   template<typename T>
   class TokenPtr;
 
@@ -124,6 +124,19 @@ MUP_NAMESPACE_START
     return ss.str();
   }
 
+  //------------------------------------------------------------------------------
+  /** \brief Returns the position to report for an error caused by an argument.
+      \param nArg One based index of the argument or -1 if it is not known.
+
+    A callback standing for several operators of the expression returns the 
+    position of the operator reading the argument. All others return their 
+    own position.
+  */
+  int ICallback::GetArgPos(int /*nArg*/) const
+  {
+    return GetExprPos();
+  }
+
   //------------------------------------------------------------------------------
   void ICallback::SetNumArgsPresent(int argc)
   {
@@ -66,6 +66,7 @@ MUP_NAMESPACE_START
       virtual void Eval(ptr_val_type& ret, const ptr_val_type *arg, int argc) = 0;
       virtual const char_type* GetDesc() const = 0;
       virtual string_type AsciiDump() const;
+      virtual int GetArgPos(int nArg) const;
         
       int GetArgc() const;
       int GetArgsPresent() const;
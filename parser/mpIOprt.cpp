@@ -72,6 +72,12 @@ MUP_NAMESPACE_START
     return ss.str();
   }
 
+  //------------------------------------------------------------------------------
+  ECmdCode IOprtBin::GetShortCircuitCode() const
+  {
+    return cmUNKNOWN;
+  }
+
   //------------------------------------------------------------------------------
   int IOprtBin::GetPri() const
   {
@@ -61,6 +61,14 @@ MUP_NAMESPACE_START
       virtual ~IOprtBin();
       virtual string_type AsciiDump() const;
 
+      /** \brief Returns the jump code used for skipping the second operand.
+
+        Operators whose result may be known after evaluating the first operand
+        return cmJMP_FALSE or cmJMP_TRUE. All others return cmUNKNOWN and have
+        both operands evaluated.
+      */
+      virtual ECmdCode GetShortCircuitCode() const;
+
       //------------------------------------------
       // IPrecedence implementation
       //------------------------------------------
@@ -39,6 +39,7 @@
 #include <vector>
 #include "mpFwdDecl.h"
 #include "mpTypes.h"
+#include "mpIToken.h"
 
 
 MUP_NAMESPACE_START
@@ -55,6 +56,18 @@ protected:
 
   IPackage();
   virtual ~IPackage();
+
+  /** \brief Mark a callback as pure, allowing the optimizer to reuse its results.
+
+    Callbacks are not pure unless they are marked. Only callbacks returning the 
+    same result for the same arguments without side effects may be marked.
+  */
+  template<typename T>
+  static T* Pure(T *pCallback)
+  {
+    pCallback->AddFlags(IToken::flPURE);
+    return pCallback;
+  }
 };
 
 MUP_NAMESPACE_END
@@ -40,9 +40,26 @@
 #include <cassert>
 
 #include "mpIPrecedence.h"
+#include "mpMemoryResource.h"
 
 MUP_NAMESPACE_START
 
+  namespace
+  {
+    /** \brief Prefix of each token recording the memory resource it was 
+               allocated from. 
+    */
+    struct TokenHeader
+    {
+      MemoryResource *m_pResource;
+      std::size_t m_nSize;
+    };
+
+    /** \brief Size of the token header keeping the token itself aligned. */
+    const std::size_t s_nHeaderSize = (sizeof(TokenHeader) + alignof(std::max_align_t) - 1) 
+                                      & ~(alignof(std::max_align_t) - 1);
+  } // anonymous namespace
+
 #ifdef MUP_LEAKAGE_REPORT
   std::list<IToken*> IToken::s_Tokens;
 #endif
@@ -111,6 +128,45 @@ MUP_NAMESPACE_START
 
 #endif
 
+  //------------------------------------------------------------------------------
+  /** \brief Allocates a token from the memory resource of the calling thread. 
+  
+    The resource is recorded in front of the token so that the token is 
+    returned to it even if it is deleted while another resource is installed.
+  */
+  void* IToken::operator new(std::size_t nSize)
+  {
+    MemoryResource *pResource = GetThreadMemoryResource();
+    char *pMem = static_cast<char*>(pResource->Allocate(s_nHeaderSize + nSize));
+
+    TokenHeader *pHeader = reinterpret_cast<TokenHeader*>(pMem);
+    pHeader->m_pResource = pResource;
+    pHeader->m_nSize = s_nHeaderSize + nSize;
+    return pMem + s_nHeaderSize;
+  }
+
+  //------------------------------------------------------------------------------
+  void IToken::operator delete(void *p)
+  {
+    if (p==nullptr)
+      return;
+
+    TokenHeader *pHeader = reinterpret_cast<TokenHeader*>(static_cast<char*>(p) - s_nHeaderSize);
+    pHeader->m_pResource->Deallocate(pHeader, pHeader->m_nSize);
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Returns the memory resource the token was allocated from. 
+  
+    Only valid for tokens created by new.
+  */
+  MemoryResource* IToken::GetMemoryResource() const
+  {
+    // The header precedes the most derived object
+    const char *pMem = static_cast<const char*>(dynamic_cast<const void*>(this)) - s_nHeaderSize;
+    return reinterpret_cast<const TokenHeader*>(pMem)->m_pResource;
+  }
+
   //------------------------------------------------------------------------------
   IToken::IToken(ECmdCode a_iCode)
     :m_eCode(a_iCode)
@@ -38,6 +38,7 @@
 #define MUP_ITOKEN_H
 
 #include <list>
+#include <cstddef>
 #include "mpTypes.h"
 #include "mpFwdDecl.h"
 
@@ -71,9 +72,14 @@ MUP_NAMESPACE_START
     enum EFlags
     {
       flNONE = 0,
-      flVOLATILE = 1
+      flVOLATILE = 1,    ///< The value may change between two evaluations
+      flSIDE_EFFECT = 2, ///< The callback modifies the values passed to it
+      flPURE = 4         ///< The callback returns the same result for the same arguments and has no side effects
     };
 
+    static void* operator new(std::size_t nSize);
+    static void operator delete(void *p);
+
     virtual IToken* Clone() const = 0;
     virtual string_type ToString() const;
     virtual string_type AsciiDump() const;
@@ -95,6 +101,8 @@ MUP_NAMESPACE_START
     void AddFlags(int flags);
     bool IsFlagSet(int flags) const;
 
+    MemoryResource* GetMemoryResource() const;
+
   protected:
 
     explicit IToken(ECmdCode a_iCode);
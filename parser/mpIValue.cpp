@@ -47,6 +47,7 @@
 //--- muParserX framework -----------------------------------------------------
 #include "mpValue.h"
 #include "mpError.h"
+#include "mpDate.h"
 #include "mpValue.h"
 
 
@@ -180,6 +181,8 @@ string_type IValue::ToString() const
 
     case 'i':
     case 'f':  ss << std::setprecision(std::numeric_limits<float_type>::digits10) << GetFloat(); break;
+    case 'd':
+    case 't':
     case 's':  ss << _T("\"") << GetString() << _T("\""); break;
     case 'b':  ss << ((GetBool() == true) ? _T("true") : _T("false")); break;
     case 'v':  ss << _T("void"); break;
@@ -189,9 +192,44 @@ string_type IValue::ToString() const
     return ss.str();
 }
 
+//---------------------------------------------------------------------------
+/** \brief Compare two values of which at least one is a date or a date time.
+    \param a_Val The value to compare with.
+    \param nCmp [out] Negative, zero or positive if this value is before, equal
+           to or after a_Val.
+    \return false if the values can not be compared.
+
+    Dates and date times compare by the time they represent. Comparing with a
+    string compares the text which orders chronologically for strings in the
+    format of the date functions.
+*/
+bool IValue::CompareDate(const IValue &a_Val, int &nCmp) const
+{
+    if (IsDate() && a_Val.IsDate())
+    {
+        float_type t1 = SecondsOfDate(GetDate()),
+            t2 = SecondsOfDate(a_Val.GetDate());
+
+        nCmp = (t1 < t2) ? -1 : ((t1 > t2) ? 1 : 0);
+        return true;
+    }
+
+    if (IsString() || a_Val.IsString())
+    {
+        nCmp = GetString().compare(a_Val.GetString());
+        return true;
+    }
+
+    return false;
+}
+
 //---------------------------------------------------------------------------
 bool IValue::operator==(const IValue &a_Val) const
 {
+    int nCmp;
+    if ((IsDate() || a_Val.IsDate()) && CompareDate(a_Val, nCmp))
+        return nCmp == 0;
+
     char_type type1 = GetType(),
         type2 = a_Val.GetType();
 
@@ -202,7 +240,12 @@ bool IValue::operator==(const IValue &a_Val) const
         case 'i':
         case 'f': return GetFloat() == a_Val.GetFloat();
         case 'c': return GetComplex() == a_Val.GetComplex();
-        case 's': return GetString() == a_Val.GetString();
+        case 's': if (IsInterned() && a_Val.IsInterned())
+                  {
+                      // Interned strings are equal only if they share their buffer
+                      return &GetString() == &a_Val.GetString();
+                  }
+                  return GetString() == a_Val.GetString();
         case 'b': return GetBool() == a_Val.GetBool();
         case 'v': return false;
         case 'm': if (GetRows() != a_Val.GetRows() || GetCols() != a_Val.GetCols())
@@ -213,7 +256,7 @@ bool IValue::operator==(const IValue &a_Val) const
                   {
                       for (int i = 0; i < GetRows(); ++i)
                       {
-                          if (const_cast<IValue*>(this)->At(i) != const_cast<IValue&>(a_Val).At(i))
+                          if (At(i) != a_Val.At(i))
                               return false;
                       }
 
@@ -237,6 +280,10 @@ bool IValue::operator==(const IValue &a_Val) const
 //---------------------------------------------------------------------------
 bool IValue::operator!=(const IValue &a_Val) const
 {
+    int nCmp;
+    if ((IsDate() || a_Val.IsDate()) && CompareDate(a_Val, nCmp))
+        return nCmp != 0;
+
     char_type type1 = GetType(),
         type2 = a_Val.GetType();
 
@@ -244,7 +291,9 @@ bool IValue::operator!=(const IValue &a_Val) const
     {
         switch (GetType())
         {
-        case 's': return GetString() != a_Val.GetString();
+        case 's': if (IsInterned() && a_Val.IsInterned())
+                      return &GetString() != &a_Val.GetString();
+                  return GetString() != a_Val.GetString();
         case 'i':
         case 'f': return GetFloat() != a_Val.GetFloat();
         case 'c': return (GetFloat() != a_Val.GetFloat()) || (GetImag() != a_Val.GetImag());
@@ -258,7 +307,7 @@ bool IValue::operator!=(const IValue &a_Val) const
                   {
                       for (int i = 0; i < GetRows(); ++i)
                       {
-                          if (const_cast<IValue*>(this)->At(i) != const_cast<IValue&>(a_Val).At(i))
+                          if (At(i) != a_Val.At(i))
                               return true;
                       }
 
@@ -282,6 +331,10 @@ bool IValue::operator!=(const IValue &a_Val) const
 //---------------------------------------------------------------------------
 bool IValue::operator<(const IValue &a_Val) const
 {
+    int nCmp;
+    if ((IsDate() || a_Val.IsDate()) && CompareDate(a_Val, nCmp))
+        return nCmp < 0;
+
     char_type type1 = GetType();
     char_type type2 = a_Val.GetType();
 
@@ -318,6 +371,10 @@ bool IValue::operator<(const IValue &a_Val) const
 //---------------------------------------------------------------------------
 bool IValue::operator> (const IValue &a_Val) const
 {
+    int nCmp;
+    if ((IsDate() || a_Val.IsDate()) && CompareDate(a_Val, nCmp))
+        return nCmp > 0;
+
     char_type type1 = GetType(),
         type2 = a_Val.GetType();
 
@@ -354,6 +411,10 @@ bool IValue::operator> (const IValue &a_Val) const
 //---------------------------------------------------------------------------
 bool IValue::operator>=(const IValue &a_Val) const
 {
+    int nCmp;
+    if ((IsDate() || a_Val.IsDate()) && CompareDate(a_Val, nCmp))
+        return nCmp >= 0;
+
     char_type type1 = GetType(),
         type2 = a_Val.GetType();
 
@@ -390,6 +451,10 @@ bool IValue::operator>=(const IValue &a_Val) const
 //---------------------------------------------------------------------------
 bool IValue::operator<=(const IValue &a_Val) const
 {
+    int nCmp;
+    if ((IsDate() || a_Val.IsDate()) && CompareDate(a_Val, nCmp))
+        return nCmp <= 0;
+
     char_type type1 = GetType(),
         type2 = a_Val.GetType();
 
@@ -434,7 +499,10 @@ IValue& IValue::operator=(const IValue &ref)
     case 'i':
     case 'f':
     case 'c': return *this = cmplx_type(ref.GetFloat(), ref.GetImag());
-    case 's': return *this = ref.GetString();
+    // An interned string shares its buffer
+    case 's': return (ref.IsInterned()) ? (*this = ref.GetSlice()) : (*this = ref.GetString());
+    case 'd':
+    case 't': return *this = ref.GetDate();
     case 'm': return *this = ref.GetArray();
     case 'b': return *this = ref.GetBool();
     case 'v':
@@ -76,6 +76,8 @@ MUP_NAMESPACE_START
     virtual IValue& operator=(bool_type val) = 0;
     virtual IValue& operator=(const cmplx_type &val) = 0;
     virtual IValue& operator=(const matrix_type &val) = 0;
+    virtual IValue& operator=(const date_type &val) = 0;
+    virtual IValue& operator=(const str_slice_type &val) = 0;
             IValue& operator=(const IValue &ref);
 
     virtual IValue& operator+=(const IValue &ref) = 0;
@@ -83,6 +85,7 @@ MUP_NAMESPACE_START
     virtual IValue& operator*=(const IValue &ref) = 0;
 
     virtual IValue& At(int nRow, int nCol = 0) = 0;
+    virtual const IValue& At(int nRow, int nCol = 0) const = 0;
     virtual IValue& At(const IValue &nRows, const IValue &nCols) = 0;
 
     virtual int_type GetInteger() const = 0;
@@ -91,7 +94,10 @@ MUP_NAMESPACE_START
     virtual bool GetBool() const = 0;
     virtual const cmplx_type& GetComplex() const = 0;
     virtual const string_type&  GetString() const = 0;
+    virtual str_slice_type GetSlice() const = 0;
+    virtual bool IsInterned() const = 0;
     virtual const matrix_type& GetArray() const = 0;
+    virtual date_type GetDate() const = 0;
     virtual char_type GetType() const = 0;
     virtual int GetRows() const = 0;
     virtual int GetCols() const = 0;
@@ -174,8 +180,21 @@ MUP_NAMESPACE_START
       return GetType() == 's';  
     }
 
+    //---------------------------------------------------------------------------
+    /** \brief Returns true if this value is a date or a date time. 
+        \throw nothrow
+    */
+    inline bool IsDate() const 
+    {
+      char_type t = GetType();
+      return t=='d' || t=='t';
+    }
+
   protected:
     virtual ~IValue();
+
+  private:
+    bool CompareDate(const IValue &a_Val, int &nCmp) const;
   }; // class IValue
 
   //---------------------------------------------------------------------------------------------
@@ -34,6 +34,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <map>
 #include <stdexcept>
 #include <sstream>
 #include <iostream>
@@ -61,12 +62,26 @@ public:
 		mssCOLS_FIRST
 	};
 
+	//---------------------------------------------------------------------------------------------
+	/** \brief Storage modes of a matrix.
+
+		Dense matrices store every element. Sparse matrices store only elements that were
+		written to and return a common default value for all other elements.
+	*/
+	enum EMatrixStorageMode
+	{
+		msmDENSE,
+		msmSPARSE
+	};
+
 	//---------------------------------------------------------------------------------------------
 	Matrix()
 		:m_nRows(1)
 		, m_nCols(1)
 		, m_eStorageScheme(mssROWS_FIRST)
+		, m_eStorageMode(msmDENSE)
 		, m_vData(1)
+		, m_mapData()
 	{}
 
 	//---------------------------------------------------------------------------------------------
@@ -74,7 +89,9 @@ public:
 		:m_nRows(nRows)
 		, m_nCols(1)
 		, m_eStorageScheme(mssROWS_FIRST)
+		, m_eStorageMode(msmDENSE)
 		, m_vData(m_nRows, value)
+		, m_mapData()
 	{}
 
 	//---------------------------------------------------------------------------------------------
@@ -84,7 +101,9 @@ public:
 		:m_nRows(1)
 		, m_nCols(1)
 		, m_eStorageScheme(mssROWS_FIRST)
+		, m_eStorageMode(msmDENSE)
 		, m_vData(1, v)
+		, m_mapData()
 	{}
 
 	//---------------------------------------------------------------------------------------------
@@ -94,7 +113,9 @@ public:
 		:m_nRows(v.size())
 		, m_nCols(1)
 		, m_eStorageScheme(mssROWS_FIRST)
+		, m_eStorageMode(msmDENSE)
 		, m_vData(v)
+		, m_mapData()
 	{}
 
 	//---------------------------------------------------------------------------------------------
@@ -105,7 +126,9 @@ public:
 		:m_nRows(TSize)
 		, m_nCols(1)
 		, m_eStorageScheme(mssROWS_FIRST)
+		, m_eStorageMode(msmDENSE)
 		, m_vData(v, v + TSize)
+		, m_mapData()
 	{}
 
 	//---------------------------------------------------------------------------------------------
@@ -114,7 +137,9 @@ public:
 		:m_nRows(TRows)
 		, m_nCols(TCols)
 		, m_eStorageScheme(mssROWS_FIRST)
+		, m_eStorageMode(msmDENSE)
 		, m_vData(TRows*TCols, 0)
+		, m_mapData()
 	{
 		for (int m = 0; m < TRows; ++m)
 		{
@@ -130,7 +155,21 @@ public:
 		:m_nRows(nRows)
 		, m_nCols(nCols)
 		, m_eStorageScheme(mssROWS_FIRST)
+		, m_eStorageMode(msmDENSE)
 		, m_vData(m_nRows*m_nCols, value)
+		, m_mapData()
+	{}
+
+	//---------------------------------------------------------------------------------------------
+	/* \brief Constructs a matrix with all elements set to value using the given storage mode.
+	*/
+	Matrix(int nRows, int nCols, const T &value, EMatrixStorageMode eMode)
+		:m_nRows(nRows)
+		, m_nCols(nCols)
+		, m_eStorageScheme(mssROWS_FIRST)
+		, m_eStorageMode(eMode)
+		, m_vData((eMode == msmDENSE) ? m_nRows*m_nCols : 1, value)
+		, m_mapData()
 	{}
 
 	//---------------------------------------------------------------------------------------------
@@ -154,7 +193,9 @@ public:
 		m_nCols = 1;
 		m_nRows = 1;
 		m_eStorageScheme = mssROWS_FIRST;
+		m_eStorageMode = msmDENSE;
 		m_vData.assign(1, v);
+		m_mapData.clear();
 		return *this;
 	}
 
@@ -164,6 +205,13 @@ public:
 		if (m_nRows != lhs.m_nRows || m_nCols != lhs.m_nCols)
 			throw MatrixError("Matrix dimension mismatch");
 
+		if (IsSparse() && lhs.IsSparse())
+		{
+			CombineSparse(lhs, [](T &v1, const T &v2) { v1 += v2; });
+			return *this;
+		}
+
+		Densify();
 		for (int i = 0; i < m_nRows; ++i)
 		{
 			for (int j = 0; j < m_nCols; ++j)
@@ -181,6 +229,13 @@ public:
 		if (m_nRows != lhs.m_nRows || m_nCols != lhs.m_nCols)
 			throw MatrixError("Matrix dimension mismatch");
 
+		if (IsSparse() && lhs.IsSparse())
+		{
+			CombineSparse(lhs, [](T &v1, const T &v2) { v1 -= v2; });
+			return *this;
+		}
+
+		Densify();
 		for (int i = 0; i < m_nRows; ++i)
 		{
 			for (int j = 0; j < m_nCols; ++j)
@@ -195,6 +250,15 @@ public:
 	//---------------------------------------------------------------------------------------------
 	Matrix& operator*=(const T &rhs)
 	{
+		if (IsSparse())
+		{
+			for (typename std::map<int, T>::iterator it = m_mapData.begin(); it != m_mapData.end(); ++it)
+				it->second *= rhs;
+
+			m_vData[0] *= rhs;
+			return *this;
+		}
+
 		// Matrix x Matrix multiplication
 		for (int m = 0; m < m_nRows; ++m)
 		{
@@ -214,28 +278,22 @@ public:
 		if (rhs.GetRows() == 0)
 		{
 			T v = rhs.At(0, 0);
-			for (int m = 0; m < m_nRows; ++m)
-			{
-				for (int n = 0; n < m_nCols; ++n)
-				{
-					At(m, n) *= v;
-				}
-			}
+			*this *= v;
 		}
 		else if (GetRows() == 0)
 		{
-			T v = At(0, 0);
+			// Read through the const At, reading must not store an element
+			T v = static_cast<const Matrix&>(*this).At(0, 0);
 			Assign(rhs);
-			for (int m = 0; m < m_nRows; ++m)
-			{
-				for (int n = 0; n < m_nCols; ++n)
-				{
-					At(m, n) *= v;
-				}
-			}
+			*this *= v;
+		}
+		else if (m_nCols == rhs.m_nRows && (HasSparseZeros() || rhs.HasSparseZeros()))
+		{
+			Assign(MultiplySparse(rhs));
 		}
 		else if (m_nCols == rhs.m_nRows)
 		{
+			Densify();
 			Matrix<T> out(m_nRows, rhs.m_nCols);
 
 			// For each cell in the output matrix
@@ -329,16 +387,25 @@ public:
 	}
 
 	//---------------------------------------------------------------------------------------------
+	/** \brief Returns a reference to an element.
+
+		In sparse mode elements that are not stored yet are created with the default value.
+		Storing the element may switch the matrix to dense storage, which like the growth of
+		a std::vector invalidates references to other elements.
+	*/
 	T& At(int nRow, int nCol = 0)
 	{
-		int i;
-		if (m_eStorageScheme == mssROWS_FIRST)
+		int i = GetIndex(nRow, nCol);
+		if (IsSparse())
 		{
-			i = nRow * m_nCols + nCol;
-		}
-		else
-		{
-			i = nCol * m_nRows + nRow;
+			typename std::map<int, T>::iterator it = m_mapData.lower_bound(i);
+			if (it != m_mapData.end() && it->first == i)
+				return it->second;
+
+			if (((int)m_mapData.size() + 1) * MUP_SPARSE_MAX_FILL <= m_nRows * m_nCols)
+				return m_mapData.insert(it, std::make_pair(i, m_vData[0]))->second;
+
+			Densify();
 		}
 
 		assert(i < (int)m_vData.size());
@@ -348,24 +415,44 @@ public:
 	//---------------------------------------------------------------------------------------------
 	const T& At(int nRow, int nCol = 0) const
 	{
-		int i;
-		if (m_eStorageScheme == mssROWS_FIRST)
-		{
-			i = nRow * m_nCols + nCol;
-		}
-		else
+		int i = GetIndex(nRow, nCol);
+		if (IsSparse())
 		{
-			i = nCol * m_nRows + nRow;
+			typename std::map<int, T>::const_iterator it = m_mapData.find(i);
+			return (it != m_mapData.end()) ? it->second : m_vData[0];
 		}
 
 		assert(i < (int)m_vData.size());
 		return m_vData[i];
 	}
 
+	//---------------------------------------------------------------------------------------------
+	/** \brief Calls func(nRow, nCol, value) for the stored elements of a sparse matrix.
+
+		The elements are visited in the order of their index, dense matrices visit nothing.
+	*/
+	template<class TFunc>
+	void ForEachStored(TFunc func) const
+	{
+		for (typename std::map<int, T>::const_iterator it = m_mapData.begin(); it != m_mapData.end(); ++it)
+		{
+			int nRow, nCol;
+			GetPos(it->first, nRow, nCol);
+			func(nRow, nCol, it->second);
+		}
+	}
+
+	//---------------------------------------------------------------------------------------------
+	/** \brief Returns the number of elements dense storage has room for. */
+	std::size_t GetCapacity() const
+	{
+		return m_vData.capacity();
+	}
+
 	//---------------------------------------------------------------------------------------------
 	const T* GetData() const
 	{
-		assert(m_vData.size());
+		assert(!IsSparse() && m_vData.size());
 		return &m_vData[0];
 	}
 
@@ -381,6 +468,41 @@ public:
 		return m_eStorageScheme;
 	}
 
+	//---------------------------------------------------------------------------------------------
+	EMatrixStorageMode GetStorageMode() const
+	{
+		return m_eStorageMode;
+	}
+
+	//---------------------------------------------------------------------------------------------
+	bool IsSparse() const
+	{
+		return m_eStorageMode == msmSPARSE;
+	}
+
+	//---------------------------------------------------------------------------------------------
+	/** \brief Returns true for sparse matrices whose elements that are not stored are zero. */
+	bool HasSparseZeros() const
+	{
+		return IsSparse() && m_vData[0] == T(0.0);
+	}
+
+	//---------------------------------------------------------------------------------------------
+	/** \brief Converts a sparse matrix into dense storage. */
+	void Densify()
+	{
+		if (!IsSparse())
+			return;
+
+		T v(m_vData[0]);
+		m_vData.assign(m_nRows*m_nCols, v);
+		for (typename std::map<int, T>::iterator it = m_mapData.begin(); it != m_mapData.end(); ++it)
+			m_vData[it->first] = it->second;
+
+		m_mapData.clear();
+		m_eStorageMode = msmDENSE;
+	}
+
 	//---------------------------------------------------------------------------------------------
 	Matrix<T>& Transpose()
 	{
@@ -396,6 +518,7 @@ public:
 	//---------------------------------------------------------------------------------------------
 	void Fill(const T &v)
 	{
+		m_mapData.clear();
 		m_vData.assign(m_vData.size(), v);
 	}
 
@@ -403,7 +526,135 @@ private:
 	int m_nRows;
 	int m_nCols;
 	EMatrixStorageScheme m_eStorageScheme;
-	std::vector<T> m_vData;
+	EMatrixStorageMode m_eStorageMode;
+	std::vector<T> m_vData;        ///< Elements of a dense matrix, the default value of a sparse one
+	std::map<int, T> m_mapData;    ///< Stored elements of a sparse matrix by their dense index
+
+	//---------------------------------------------------------------------------------------------
+	int GetIndex(int nRow, int nCol) const
+	{
+		return (m_eStorageScheme == mssROWS_FIRST) ? nRow * m_nCols + nCol : nCol * m_nRows + nRow;
+	}
+
+	//---------------------------------------------------------------------------------------------
+	void GetPos(int i, int &nRow, int &nCol) const
+	{
+		if (m_eStorageScheme == mssROWS_FIRST)
+		{
+			nRow = i / m_nCols;
+			nCol = i % m_nCols;
+		}
+		else
+		{
+			nRow = i % m_nRows;
+			nCol = i / m_nRows;
+		}
+	}
+
+	//---------------------------------------------------------------------------------------------
+	/** \brief Switches a sparse matrix to dense storage once dense storage is cheaper.
+
+		This is the case when more than one in MUP_SPARSE_MAX_FILL elements is stored.
+	*/
+	void CheckDensity()
+	{
+		if (IsSparse() && (int)m_mapData.size() * MUP_SPARSE_MAX_FILL > m_nRows * m_nCols)
+			Densify();
+	}
+
+	//---------------------------------------------------------------------------------------------
+	/** \brief Applies an elementwise operation to two sparse matrices of equal size.
+
+		Only the stored elements of both matrices are visited, the default values are
+		combined into the default value of the result.
+	*/
+	template<class TOp>
+	void CombineSparse(const Matrix &rhs, TOp op)
+	{
+		for (typename std::map<int, T>::iterator it = m_mapData.begin(); it != m_mapData.end(); ++it)
+		{
+			int nRow, nCol;
+			GetPos(it->first, nRow, nCol);
+			op(it->second, rhs.At(nRow, nCol));
+		}
+
+		// Elements stored only in rhs
+		for (typename std::map<int, T>::const_iterator it = rhs.m_mapData.begin(); it != rhs.m_mapData.end(); ++it)
+		{
+			int nRow, nCol;
+			rhs.GetPos(it->first, nRow, nCol);
+
+			int i = GetIndex(nRow, nCol);
+			if (m_mapData.find(i) != m_mapData.end())
+				continue;
+
+			T v(m_vData[0]);
+			op(v, it->second);
+			m_mapData.insert(std::make_pair(i, v));
+		}
+
+		op(m_vData[0], rhs.m_vData[0]);
+		CheckDensity();
+	}
+
+	//---------------------------------------------------------------------------------------------
+	/** \brief Matrix multiplication with at least one sparse operand whose default is zero.
+
+		Only products involving stored elements of the sparse operands are computed. The
+		result is sparse if both operands are.
+	*/
+	Matrix MultiplySparse(const Matrix &rhs) const
+	{
+		const T zero(0.0);
+		Matrix<T> out(m_nRows, rhs.m_nCols, zero, (HasSparseZeros() && rhs.HasSparseZeros()) ? msmSPARSE : msmDENSE);
+
+		if (HasSparseZeros())
+		{
+			// Group the stored elements of a sparse rhs by row
+			std::vector<std::vector<std::pair<int, const T*> > > vRows;
+			if (rhs.HasSparseZeros())
+			{
+				vRows.resize(rhs.m_nRows);
+				for (typename std::map<int, T>::const_iterator it = rhs.m_mapData.begin(); it != rhs.m_mapData.end(); ++it)
+				{
+					int nRow, nCol;
+					rhs.GetPos(it->first, nRow, nCol);
+					vRows[nRow].push_back(std::make_pair(nCol, &it->second));
+				}
+			}
+
+			for (typename std::map<int, T>::const_iterator it = m_mapData.begin(); it != m_mapData.end(); ++it)
+			{
+				int m, i;
+				GetPos(it->first, m, i);
+
+				if (rhs.HasSparseZeros())
+				{
+					for (std::size_t k = 0; k < vRows[i].size(); ++k)
+						out.At(m, vRows[i][k].first) += it->second * (*vRows[i][k].second);
+				}
+				else
+				{
+					for (int n = 0; n < rhs.m_nCols; ++n)
+						out.At(m, n) += it->second * rhs.At(i, n);
+				}
+			}
+		}
+		else
+		{
+			// Dense matrix times sparse matrix
+			for (typename std::map<int, T>::const_iterator it = rhs.m_mapData.begin(); it != rhs.m_mapData.end(); ++it)
+			{
+				int i, n;
+				rhs.GetPos(it->first, i, n);
+
+				for (int m = 0; m < m_nRows; ++m)
+					out.At(m, n) += At(m, i) * it->second;
+			}
+		}
+
+		return out;
+	}
 
 	//---------------------------------------------------------------------------------------------
 	void Assign(const Matrix &ref)
@@ -411,7 +662,10 @@ private:
 		m_nCols = ref.m_nCols;
 		m_nRows = ref.m_nRows;
 		m_eStorageScheme = ref.m_eStorageScheme;
+		m_eStorageMode = ref.m_eStorageMode;
 		m_vData = ref.m_vData;
+		m_mapData = ref.m_mapData;
+		CheckDensity();
 	}
 };
 
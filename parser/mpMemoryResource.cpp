@@ -0,0 +1,240 @@
+/** \file
+    \brief Implementation of the memory resources used for allocating parser tokens.
+
+<pre>
+               __________                                 ____  ___
+    _____  __ _\______   \_____ _______  ______ __________\   \/  /
+   /     \|  |  \     ___/\__  \\_  __ \/  ___// __ \_  __ \     / 
+  |  Y Y  \  |  /    |     / __ \|  | \/\___ \\  ___/|  | \/     \ 
+  |__|_|  /____/|____|    (____  /__|  /____  >\___  >__| /___/\  \
+        \/                     \/           \/     \/           \_/
+                                       Copyright (C) 2016, Ingo Berg
+                                       All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without 
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice, 
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright notice, 
+     this list of conditions and the following disclaimer in the documentation 
+     and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. 
+  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT 
+  NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+  POSSIBILITY OF SUCH DAMAGE.
+  </pre>
+*/
+#include "mpMemoryResource.h"
+
+//--- Standard includes ----------------------------------------------------
+#include <cassert>
+#include <cstdint>
+#include <new>
+
+
+MUP_NAMESPACE_START
+
+  namespace
+  {
+    /** \brief The memory resource forwarding to the global operator new and delete. */
+    class NewDeleteResource : public MemoryResource
+    {
+    protected:
+      virtual void* DoAllocate(std::size_t nBytes, std::size_t nAlign)
+      {
+        // operator new returns memory suitable for any fundamental alignment
+        assert(nAlign <= alignof(std::max_align_t));
+        _unused(nAlign);
+        return ::operator new(nBytes);
+      }
+
+      virtual void DoDeallocate(void *p, std::size_t, std::size_t)
+      {
+        ::operator delete(p);
+      }
+    };
+
+    // A trivial thread local type needs no construction or destruction.
+    thread_local MemoryResource *t_pResource = 0;
+
+    //---------------------------------------------------------------------------
+    std::size_t AlignUp(std::size_t n, std::size_t nAlign)
+    {
+      return (n + nAlign - 1) & ~(nAlign - 1);
+    }
+  } // anonymous namespace
+
+  //------------------------------------------------------------------------------
+  //
+  // class MemoryResource
+  //
+  //------------------------------------------------------------------------------
+
+  MemoryResource::~MemoryResource()
+  {}
+
+  //------------------------------------------------------------------------------
+  void* MemoryResource::Allocate(std::size_t nBytes, std::size_t nAlign)
+  {
+    return DoAllocate(nBytes, nAlign);
+  }
+
+  //------------------------------------------------------------------------------
+  void MemoryResource::Deallocate(void *p, std::size_t nBytes, std::size_t nAlign)
+  {
+    DoDeallocate(p, nBytes, nAlign);
+  }
+
+  //------------------------------------------------------------------------------
+  MemoryResource* GetNewDeleteResource()
+  {
+    static NewDeleteResource s_Resource;
+    return &s_Resource;
+  }
+
+  //------------------------------------------------------------------------------
+  //
+  // class MonotonicBufferResource
+  //
+  //------------------------------------------------------------------------------
+
+  MonotonicBufferResource::MonotonicBufferResource(std::size_t nInitialSize, MemoryResource *pUpstream)
+    :m_pUpstream(pUpstream)
+    ,m_pChunks(0)
+    ,m_pCur(0)
+    ,m_nAvail(0)
+    ,m_nNextSize(nInitialSize ? nInitialSize : 1)
+    ,m_nAllocated(0)
+  {
+    assert(m_pUpstream);
+  }
+
+  //------------------------------------------------------------------------------
+  MonotonicBufferResource::~MonotonicBufferResource()
+  {
+    while (m_pChunks)
+    {
+      Chunk *pChunk = m_pChunks;
+      m_pChunks = pChunk->m_pNext;
+      m_pUpstream->Deallocate(pChunk, pChunk->m_nSize);
+    }
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Reclaims all memory handed out by the resource. 
+  
+    The largest chunk is kept for the allocations that follow, all others 
+    are returned to the upstream resource.
+  */
+  void MonotonicBufferResource::Release()
+  {
+    Chunk *pLargest = m_pChunks;
+    for (Chunk *pChunk = m_pChunks; pChunk; pChunk = pChunk->m_pNext)
+    {
+      if (pChunk->m_nSize > pLargest->m_nSize)
+        pLargest = pChunk;
+    }
+
+    while (m_pChunks)
+    {
+      Chunk *pChunk = m_pChunks;
+      m_pChunks = pChunk->m_pNext;
+      if (pChunk != pLargest)
+        m_pUpstream->Deallocate(pChunk, pChunk->m_nSize);
+    }
+
+    m_pChunks = pLargest;
+    m_nAllocated = 0;
+    if (pLargest)
+    {
+      pLargest->m_pNext = 0;
+      std::size_t nHeader = AlignUp(sizeof(Chunk), alignof(std::max_align_t));
+      m_pCur = reinterpret_cast<char*>(pLargest) + nHeader;
+      m_nAvail = pLargest->m_nSize - nHeader;
+    }
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Returns the number of bytes handed out since the last release. */
+  std::size_t MonotonicBufferResource::GetBytesAllocated() const
+  {
+    return m_nAllocated;
+  }
+
+  //------------------------------------------------------------------------------
+  void MonotonicBufferResource::AddChunk(std::size_t nMinSize)
+  {
+    std::size_t nHeader = AlignUp(sizeof(Chunk), alignof(std::max_align_t));
+    std::size_t nSize = nHeader + nMinSize;
+    if (nSize < m_nNextSize)
+      nSize = m_nNextSize;
+
+    Chunk *pChunk = static_cast<Chunk*>(m_pUpstream->Allocate(nSize));
+    pChunk->m_pNext = m_pChunks;
+    pChunk->m_nSize = nSize;
+    m_pChunks = pChunk;
+    m_pCur = reinterpret_cast<char*>(pChunk) + nHeader;
+    m_nAvail = nSize - nHeader;
+    m_nNextSize = nSize * 2;
+  }
+
+  //------------------------------------------------------------------------------
+  void* MonotonicBufferResource::DoAllocate(std::size_t nBytes, std::size_t nAlign)
+  {
+    std::size_t nPad = AlignUp(reinterpret_cast<std::uintptr_t>(m_pCur), nAlign) - reinterpret_cast<std::uintptr_t>(m_pCur);
+    if (!m_pCur || nPad + nBytes > m_nAvail)
+    {
+      AddChunk(nBytes + nAlign);
+      nPad = AlignUp(reinterpret_cast<std::uintptr_t>(m_pCur), nAlign) - reinterpret_cast<std::uintptr_t>(m_pCur);
+    }
+
+    void *p = m_pCur + nPad;
+    m_pCur += nPad + nBytes;
+    m_nAvail -= nPad + nBytes;
+    m_nAllocated += nBytes;
+    return p;
+  }
+
+  //------------------------------------------------------------------------------
+  void MonotonicBufferResource::DoDeallocate(void*, std::size_t, std::size_t)
+  {}
+
+  //------------------------------------------------------------------------------
+  //
+  // Thread memory resource
+  //
+  //------------------------------------------------------------------------------
+
+  MemoryResource* GetThreadMemoryResource()
+  {
+    return t_pResource ? t_pResource : GetNewDeleteResource();
+  }
+
+  //------------------------------------------------------------------------------
+  MemoryResource* SetThreadMemoryResource(MemoryResource *pResource)
+  {
+    MemoryResource *pPrev = GetThreadMemoryResource();
+    t_pResource = pResource;
+    return pPrev;
+  }
+
+  //------------------------------------------------------------------------------
+  ScopedMemoryResource::ScopedMemoryResource(MemoryResource *pResource)
+    :m_pPrev(SetThreadMemoryResource(pResource))
+  {}
+
+  //------------------------------------------------------------------------------
+  ScopedMemoryResource::~ScopedMemoryResource()
+  {
+    SetThreadMemoryResource(m_pPrev);
+  }
+
+MUP_NAMESPACE_END
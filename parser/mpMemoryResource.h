@@ -0,0 +1,151 @@
+/** \file
+    \brief Definition of the memory resources used for allocating parser tokens.
+
+<pre>
+               __________                                 ____  ___
+    _____  __ _\______   \_____ _______  ______ __________\   \/  /
+   /     \|  |  \     ___/\__  \\_  __ \/  ___// __ \_  __ \     / 
+  |  Y Y  \  |  /    |     / __ \|  | \/\___ \\  ___/|  | \/     \ 
+  |__|_|  /____/|____|    (____  /__|  /____  >\___  >__| /___/\  \
+        \/                     \/           \/     \/           \_/
+                                       Copyright (C) 2016, Ingo Berg
+                                       All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without 
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice, 
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright notice, 
+     this list of conditions and the following disclaimer in the documentation 
+     and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. 
+  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT 
+  NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+  POSSIBILITY OF SUCH DAMAGE.
+  </pre>
+*/
+
+#ifndef MUP_MEMORY_RESOURCE_H
+#define MUP_MEMORY_RESOURCE_H
+
+#include <cstddef>
+
+#include "mpDefines.h"
+
+
+MUP_NAMESPACE_START
+
+  //------------------------------------------------------------------------------
+  /** \brief Interface of a source of raw memory.
+
+    Modeled after std::pmr::memory_resource. Tokens (values, variables and 
+    callbacks) are allocated from the memory resource installed for the 
+    calling thread by SetThreadMemoryResource and returned to the resource 
+    they came from when they are deleted.
+  */
+  class MemoryResource
+  {
+  public:
+    virtual ~MemoryResource();
+
+    void* Allocate(std::size_t nBytes, std::size_t nAlign = alignof(std::max_align_t));
+    void Deallocate(void *p, std::size_t nBytes, std::size_t nAlign = alignof(std::max_align_t));
+
+  protected:
+    virtual void* DoAllocate(std::size_t nBytes, std::size_t nAlign) = 0;
+    virtual void DoDeallocate(void *p, std::size_t nBytes, std::size_t nAlign) = 0;
+  };
+
+  //------------------------------------------------------------------------------
+  /** \brief Returns the resource using the global operator new and delete. */
+  MemoryResource* GetNewDeleteResource();
+
+  //------------------------------------------------------------------------------
+  /** \brief A memory resource releasing all of its memory at once.
+
+    Memory is handed out from chunks of increasing size taken from an upstream 
+    resource. Deallocate does nothing, the memory is reclaimed by Release or 
+    when the resource is destroyed. The resource is not thread safe.
+  */
+  class MonotonicBufferResource : public MemoryResource
+  {
+  public:
+    explicit MonotonicBufferResource(std::size_t nInitialSize = 4096, 
+                                     MemoryResource *pUpstream = GetNewDeleteResource());
+    virtual ~MonotonicBufferResource();
+
+    void Release();
+    std::size_t GetBytesAllocated() const;
+
+  protected:
+    virtual void* DoAllocate(std::size_t nBytes, std::size_t nAlign);
+    virtual void DoDeallocate(void *p, std::size_t nBytes, std::size_t nAlign);
+
+  private:
+    struct Chunk
+    {
+      Chunk *m_pNext;
+      std::size_t m_nSize;  ///< Size of the chunk including this header
+    };
+
+    MonotonicBufferResource(const MonotonicBufferResource &ref);
+    MonotonicBufferResource& operator=(const MonotonicBufferResource &ref);
+
+    void AddChunk(std::size_t nMinSize);
+
+    MemoryResource *m_pUpstream;
+    Chunk *m_pChunks;        ///< List of chunks, the current one first
+    char *m_pCur;            ///< Start of the free space in the current chunk
+    std::size_t m_nAvail;    ///< Free bytes in the current chunk
+    std::size_t m_nNextSize; ///< Size of the next chunk to request
+    std::size_t m_nAllocated;
+  };
+
+  //------------------------------------------------------------------------------
+  /** \brief Returns the memory resource tokens of the calling thread are 
+             allocated from. 
+             
+    This is the new/delete resource unless another one was installed.
+  */
+  MemoryResource* GetThreadMemoryResource();
+
+  /** \brief Installs the memory resource for allocating tokens in the calling 
+             thread.
+      \param pResource The new resource; 0 restores the new/delete resource.
+      \return The resource installed before.
+
+    The resource must outlive all tokens allocated from it. Parsers allocate 
+    tokens when defining functions, variables and constants, compiling and 
+    evaluating an expression, so the resource usually has to be installed 
+    for the whole lifetime of a parser.
+  */
+  MemoryResource* SetThreadMemoryResource(MemoryResource *pResource);
+
+  //------------------------------------------------------------------------------
+  /** \brief Installs a memory resource for the calling thread for the lifetime 
+             of the object and restores the previous one afterwards.
+  */
+  class ScopedMemoryResource
+  {
+  public:
+    explicit ScopedMemoryResource(MemoryResource *pResource);
+   ~ScopedMemoryResource();
+
+  private:
+    ScopedMemoryResource(const ScopedMemoryResource &ref);
+    ScopedMemoryResource& operator=(const ScopedMemoryResource &ref);
+
+    MemoryResource *m_pPrev;
+  };
+
+MUP_NAMESPACE_END
+
+#endif
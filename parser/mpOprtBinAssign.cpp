@@ -46,7 +46,9 @@ MUP_NAMESPACE_START
 
   OprtAssign::OprtAssign() 
     :IOprtBin(_T("="), (int)prASSIGN, oaLEFT)
-  {}
+  {
+    AddFlags(flSIDE_EFFECT);
+  }
 
   //---------------------------------------------------------------------
   const char_type* OprtAssign::GetDesc() const 
@@ -87,7 +89,9 @@ MUP_NAMESPACE_START
 
   OprtAssignAdd::OprtAssignAdd() 
     :IOprtBin(_T("+="), (int)prASSIGN, oaLEFT) 
-  {}
+  {
+    AddFlags(flSIDE_EFFECT);
+  }
 
   //---------------------------------------------------------------------
   void OprtAssignAdd::Eval(ptr_val_type& ret, const ptr_val_type *a_pArg, int)   
@@ -129,7 +133,9 @@ MUP_NAMESPACE_START
 
   OprtAssignSub::OprtAssignSub() 
     :IOprtBin(_T("-="), (int)prASSIGN, oaLEFT) 
-  {}
+  {
+    AddFlags(flSIDE_EFFECT);
+  }
 
   //---------------------------------------------------------------------
   void OprtAssignSub::Eval(ptr_val_type& ret, const ptr_val_type *a_pArg, int)   
@@ -169,7 +175,9 @@ MUP_NAMESPACE_START
 
   OprtAssignMul::OprtAssignMul() 
     :IOprtBin(_T("*="), (int)prASSIGN, oaLEFT) 
-  {}
+  {
+    AddFlags(flSIDE_EFFECT);
+  }
 
   //---------------------------------------------------------------------
   void OprtAssignMul::Eval(ptr_val_type& ret, const ptr_val_type *a_pArg, int)
@@ -211,7 +219,9 @@ MUP_NAMESPACE_START
   //---------------------------------------------------------------------
 
   OprtAssignDiv::OprtAssignDiv() : IOprtBin(_T("/="), (int)prASSIGN, oaLEFT) 
-  {}
+  {
+    AddFlags(flSIDE_EFFECT);
+  }
 
   //------------------------------------------------------------------------------
   void OprtAssignDiv::Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int)
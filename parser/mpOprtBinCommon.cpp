@@ -35,6 +35,7 @@
 #include "mpOprtBinCommon.h"
 #include <cmath>
 #include <limits>
+#include <utility>
 
 
 MUP_NAMESPACE_START
@@ -53,9 +54,13 @@ OprtStrAdd::OprtStrAdd()
 void OprtStrAdd::Eval(ptr_val_type& ret, const ptr_val_type *arg, int argc)
 {
     MUP_VERIFY(argc == 2);
-    string_type a = arg[0]->GetString();
-    string_type b = arg[1]->GetString();
-    *ret = a + b;
+    const string_type &a = arg[0]->GetString();
+    const string_type &b = arg[1]->GetString();
+
+    string_type sRes;
+    sRes.reserve(a.size() + b.size());
+    sRes.append(a).append(b);
+    *ret = std::move(sRes);
 }
 
 //-----------------------------------------------------------------------------------------------
@@ -70,6 +75,86 @@ IToken* OprtStrAdd::Clone() const
     return new OprtStrAdd(*this);
 }
 
+//-----------------------------------------------------------------------------------------------
+//
+// class OprtStrConcat
+//
+//-----------------------------------------------------------------------------------------------
+
+OprtStrConcat::OprtStrConcat()
+    :ICallback(cmFUNC, _T("//"), -1)
+    ,m_vArg()
+{}
+
+//-----------------------------------------------------------------------------------------------
+/** \brief Add an operand of the chain.
+    \param nOrder Index of the operator reading the operand in the unfused RPN.
+    \param nPos Position of that operator in the expression.
+*/
+void OprtStrConcat::AddArg(int nOrder, int nPos)
+{
+    m_vArg.push_back(std::make_pair(nOrder, nPos));
+}
+
+//-----------------------------------------------------------------------------------------------
+int OprtStrConcat::GetArgPos(int nArg) const
+{
+    return (nArg >= 1 && nArg <= (int)m_vArg.size()) ? m_vArg[nArg - 1].second : GetExprPos();
+}
+
+//-----------------------------------------------------------------------------------------------
+void OprtStrConcat::Eval(ptr_val_type& ret, const ptr_val_type *arg, int argc)
+{
+    MUP_VERIFY(argc >= 2 && argc == (int)m_vArg.size());
+
+    // An operand that is no string is reported for the operator the unfused chain 
+    // would have evaluated first.
+    int iErr = -1;
+    for (int i = 0; i < argc; ++i)
+    {
+        if (!arg[i]->IsString() && !arg[i]->IsDate() && (iErr < 0 || m_vArg[i].first < m_vArg[iErr].first))
+            iErr = i;
+    }
+
+    if (iErr >= 0)
+    {
+        try
+        {
+            arg[iErr]->GetString();
+        }
+        catch (ParserError &exc)
+        {
+            exc.GetContext().Arg = iErr + 1;
+            throw;
+        }
+    }
+
+    // The arguments are referenced, not copied. The first one may share its value item with
+    // the result and is only overwritten once the result is complete.
+    std::size_t nLen = 0;
+    for (int i = 0; i < argc; ++i)
+        nLen += arg[i]->GetString().size();
+
+    string_type sRes;
+    sRes.reserve(nLen);
+    for (int i = 0; i < argc; ++i)
+        sRes.append(arg[i]->GetString());
+
+    *ret = std::move(sRes);
+}
+
+//-----------------------------------------------------------------------------------------------
+const char_type* OprtStrConcat::GetDesc() const
+{
+    return _T("string concatenation of multiple operands");
+}
+
+//-----------------------------------------------------------------------------------------------
+IToken* OprtStrConcat::Clone() const
+{
+    return new OprtStrConcat(*this);
+}
+
 
 //-----------------------------------------------------------------------------------------------
 //
@@ -345,6 +430,12 @@ void OprtLOr::Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int num)
     *ret = a_pArg[0]->GetBool() || a_pArg[1]->GetBool();
 }
 
+//-----------------------------------------------------------------------------------------------
+ECmdCode OprtLOr::GetShortCircuitCode() const
+{
+    return cmJMP_TRUE;
+}
+
 //-----------------------------------------------------------------------------------------------
 const char_type* OprtLOr::GetDesc() const
 {
@@ -374,6 +465,12 @@ void OprtLAnd::Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int num)
     *ret = a_pArg[0]->GetBool() && a_pArg[1]->GetBool();
 }
 
+//-----------------------------------------------------------------------------------------------
+ECmdCode OprtLAnd::GetShortCircuitCode() const
+{
+    return cmJMP_FALSE;
+}
+
 //-----------------------------------------------------------------------------------------------
 const char_type* OprtLAnd::GetDesc() const
 {
@@ -41,6 +41,8 @@
   */
 
 #include <cmath>
+#include <vector>
+#include <utility>
 #include "mpIOprt.h"
 #include "mpValue.h"
 #include "mpError.h"
@@ -58,6 +60,30 @@ public:
     virtual IToken* Clone() const override;
 };
 
+//-----------------------------------------------------------------------------------------------
+/** \brief Callback object for a chain of string concatenations.
+    \ingroup binop
+
+    This callback is not defined in the parser. The RPN optimizer replaces chains like
+    <tt>a // b // c</tt> with it, the result is built with a single allocation. Errors
+    are reported at the operator of the chain reading the failing operand.
+*/
+class OprtStrConcat : public ICallback
+{
+public:
+    OprtStrConcat();
+    virtual void Eval(ptr_val_type& ret, const ptr_val_type *arg, int argc) override;
+    virtual const char_type* GetDesc() const override;
+    virtual IToken* Clone() const override;
+    virtual int GetArgPos(int nArg) const override;
+
+    void AddArg(int nOrder, int nPos);
+
+private:
+    /** \brief Order of evaluation and position of the operator reading each operand. */
+    std::vector<std::pair<int, int> > m_vArg;
+};
+
 //-----------------------------------------------------------------------------------------------
 /** \brief Callback object for testing if two values are equal.
     \ingroup binop
@@ -172,6 +198,7 @@ class OprtLOr : public IOprtBin
 public:
     OprtLOr(const char_type *szIdent = _T("||"));
     virtual void Eval(ptr_val_type& ret, const ptr_val_type *a_pArg, int) override;
+    virtual ECmdCode GetShortCircuitCode() const override;
     virtual const char_type* GetDesc() const override;
     virtual IToken* Clone() const override;
 };
@@ -185,6 +212,7 @@ class OprtLAnd : public IOprtBin
 public:
     OprtLAnd(const char_type *szIdent = _T("&&"));
     virtual void Eval(ptr_val_type& ret, const ptr_val_type *a_pArg, int) override;
+    virtual ECmdCode GetShortCircuitCode() const override;
     virtual const char_type* GetDesc() const override;
     virtual IToken* Clone() const override;
 };
@@ -72,7 +72,7 @@ void OprtSignCmplx::Eval(ptr_val_type &ret, const ptr_val_type *a_pArg, int a_iA
         Value v(a_pArg[0]->GetRows(), 0);
         for (int i = 0; i < a_pArg[0]->GetRows(); ++i)
         {
-            v.At(i) = a_pArg[0]->At(i).GetComplex() * (float_type)-1.0;
+            v.At(i) = a_pArg[0]->GetArray().At(i).GetComplex() * (float_type)-1.0;
         }
         *ret = v;
     }
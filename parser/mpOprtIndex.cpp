@@ -33,6 +33,29 @@
 
 MUP_NAMESPACE_START
 
+namespace
+{
+    //-----------------------------------------------------------------------------------------------
+    /** \brief Returns the value of an index into val.
+        \throw ParserError if the index is not an integer.
+    */
+    int GetIndex(const IValue &val, const IValue &idx)
+    {
+        if (!idx.IsInteger())
+        {
+            ErrorContext errc(ecTYPE_CONFLICT_IDX);
+            if (val.IsVariable())
+                errc.Ident = val.GetIdent();
+
+            errc.Type1 = idx.GetType();
+            errc.Type2 = 'i';
+            throw ParserError(errc);
+        }
+
+        return (int)idx.GetInteger();
+    }
+} // anonymous namespace
+
     //-----------------------------------------------------------------------------------------------
     //
     //  class  OprtIndex
@@ -41,6 +64,14 @@ MUP_NAMESPACE_START
 
     OprtIndex::OprtIndex()
         :ICallback(cmIC, _T("Index operator"), -1)
+        ,m_pView()
+    {}
+
+    //-----------------------------------------------------------------------------------------------
+    /** \brief Copy constructor, the copy creates a view of its own. */
+    OprtIndex::OprtIndex(const OprtIndex &a_Oprt)
+        :ICallback(a_Oprt)
+        ,m_pView()
     {}
 
     //-----------------------------------------------------------------------------------------------
@@ -56,44 +87,48 @@ MUP_NAMESPACE_START
         {
             int rows = a_pArg[-1]->GetRows();
             int cols = a_pArg[-1]->GetCols();
-            bool bArgIsVariable = a_pArg[-1]->IsVariable();
+            int nRow = 0, nCol = 0;
 
-            // If the index operator is applied to a variable the return value is also a variable
-            // pointing to a specific cell in the matrix. If the operator is applied to a value
-            // the return value is also a value.
             switch (a_iArgc)
             {
             case 1:
                 if (cols == 1)
-                {
-                    if (bArgIsVariable) 
-                        ret.Reset(new Variable(&(ret->At(*a_pArg[0], Value(0.0)))));
-                    else
-                        *ret = ret->At(*a_pArg[0], Value(0.0));
-                }
+                    nRow = GetIndex(*ret, *a_pArg[0]);
                 else if (rows == 1)
-                {
-                    if (bArgIsVariable) 
-                        ret.Reset(new Variable(&(ret->At(Value(0.0), *a_pArg[0]))));
-                    else
-                        *ret = ret->At(Value(0.0), *a_pArg[0]);
-                }
+                    nCol = GetIndex(*ret, *a_pArg[0]);
                 else
-                {
                     throw ParserError(ErrorContext(ecINDEX_DIMENSION, -1, GetIdent()));
-                }
                 break;
 
             case 2:
-                if (bArgIsVariable)
-                    ret.Reset(new Variable(&(ret->At(*a_pArg[0], *a_pArg[1]))));
-                else
-	                *ret = ret->At(*a_pArg[0], *a_pArg[1]);
+                nRow = GetIndex(*ret, *a_pArg[0]);
+                nCol = GetIndex(*ret, *a_pArg[1]);
                 break;
 
             default:
                 throw ParserError(ErrorContext(ecINDEX_DIMENSION, -1, GetIdent()));
             }
+
+            // If the index operator is applied to a variable the return value is also a variable
+            // referring to a specific cell in the matrix. The variable of the last evaluation is
+            // bound to the cell unless it is still in use elsewhere. The cell is looked up on
+            // every access, so that writing it can switch a sparse matrix to dense storage.
+            if (a_pArg[-1]->IsVariable())
+            {
+                // Check the index without storing the element
+                static_cast<const IValue&>(*ret).At(nRow, nCol);
+
+                if (m_pView.Get() == nullptr || m_pView->GetRef() > 1)
+                    m_pView.Reset(new Variable(nullptr));
+
+                static_cast<Variable*>(m_pView.Get())->BindElement(ret.Get(), nRow, nCol);
+                ret = m_pView;
+                return;
+            }
+
+            // Other values are only read, no element is stored in a sparse matrix
+            const IValue &elem = static_cast<const IValue&>(*ret).At(nRow, nCol);
+            *ret = elem;
         }
         catch(ParserError &exc)
         {
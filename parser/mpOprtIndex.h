@@ -55,9 +55,15 @@ MUP_NAMESPACE_START
   {
   public:
     OprtIndex();
+    OprtIndex(const OprtIndex &a_Oprt);
     virtual void Eval(ptr_val_type& ret, const ptr_val_type *arg, int argc) override;
     virtual const char_type* GetDesc() const override;
     virtual IToken* Clone() const override;
+
+  private:
+    OprtIndex& operator=(const OprtIndex &a_Oprt);
+
+    ptr_val_type m_pView;  ///< Variable referencing the element found by the last evaluation
   }; 
 
 MUP_NAMESPACE_END
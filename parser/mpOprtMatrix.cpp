@@ -76,7 +76,9 @@ MUP_NAMESPACE_START
 
   OprtCreateArray::OprtCreateArray()
       :ICallback(cmCBC, _T("Array constructor"), -1)
-  {}
+  {
+    AddFlags(flPURE);
+  }
 
   //-----------------------------------------------------------------------------------------------
   /** \brief Index operator implementation
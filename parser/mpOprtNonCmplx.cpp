@@ -60,7 +60,7 @@ MUP_NAMESPACE_START
       Value v(a_pArg[0]->GetRows(), 0);
       for (int i=0; i<a_pArg[0]->GetRows(); ++i)
       {
-        v.At(i) = -a_pArg[0]->At(i).GetFloat();
+        v.At(i) = -a_pArg[0]->GetArray().At(i).GetFloat();
       }
       *ret = v;
     }
@@ -110,7 +110,7 @@ MUP_NAMESPACE_START
       Value v(a_pArg[0]->GetRows(), 0);
       for (int i=0; i<a_pArg[0]->GetRows(); ++i)
       {
-        v.At(i) = a_pArg[0]->At(i).GetFloat();
+        v.At(i) = a_pArg[0]->GetArray().At(i).GetFloat();
       }
       *ret = v;
     }
@@ -283,15 +283,29 @@ MUP_NAMESPACE_START
     if (arg1->GetType()=='m' && arg2->GetType()=='m')
     {
       // Scalar multiplication
-      matrix_type a1 = arg1->GetArray();
-      matrix_type a2 = arg2->GetArray();
+      const matrix_type &a1 = arg1->GetArray(),
+                       &a2 = arg2->GetArray();
 
       if (a1.GetRows()!=a2.GetRows())
         throw ParserError(ErrorContext(ecARRAY_SIZE_MISMATCH, -1, GetIdent(), 'm', 'm', 2));
 
       float_type val(0);
-      for (int i=0; i<a1.GetRows(); ++i)
-        val += a1.At(i).GetFloat()*a2.At(i).GetFloat();
+      if (a1.HasSparseZeros() || a2.HasSparseZeros())
+      {
+        // Only the stored elements of a sparse operand contribute to the sum
+        const matrix_type &s = (a1.HasSparseZeros()) ? a1 : a2,
+                         &o = (a1.HasSparseZeros()) ? a2 : a1;
+        s.ForEachStored([&](int nRow, int nCol, const Value &v)
+        {
+          if (nCol==0)
+            val += v.GetFloat()*o.At(nRow).GetFloat();
+        });
+      }
+      else
+      {
+        for (int i=0; i<a1.GetRows(); ++i)
+          val += a1.At(i).GetFloat()*a2.At(i).GetFloat();
+      }
 
       *ret = val;
     }
@@ -58,33 +58,33 @@ void PackageCmplx::AddToParser(ParserXBase *pParser)
   pParser->DefineConst( _T("i"), cmplx_type(0.0, 1.0) );
 
   // Complex valued functions
-  pParser->DefineFun(new FunCmplxReal());
-  pParser->DefineFun(new FunCmplxImag());
-  pParser->DefineFun(new FunCmplxConj());
-  pParser->DefineFun(new FunCmplxArg());
-  pParser->DefineFun(new FunCmplxNorm());
-  pParser->DefineFun(new FunCmplxSin());
-  pParser->DefineFun(new FunCmplxCos());
-  pParser->DefineFun(new FunCmplxTan());
-  pParser->DefineFun(new FunCmplxSinH());
-  pParser->DefineFun(new FunCmplxCosH());
-  pParser->DefineFun(new FunCmplxTanH());
-  pParser->DefineFun(new FunCmplxSqrt());
-  pParser->DefineFun(new FunCmplxExp());
-  pParser->DefineFun(new FunCmplxLn());
-  pParser->DefineFun(new FunCmplxLog());
-  pParser->DefineFun(new FunCmplxLog2());
-  pParser->DefineFun(new FunCmplxLog10());
-  pParser->DefineFun(new FunCmplxAbs());
-  pParser->DefineFun(new FunCmplxPow());
+  pParser->DefineFun(Pure(new FunCmplxReal()));
+  pParser->DefineFun(Pure(new FunCmplxImag()));
+  pParser->DefineFun(Pure(new FunCmplxConj()));
+  pParser->DefineFun(Pure(new FunCmplxArg()));
+  pParser->DefineFun(Pure(new FunCmplxNorm()));
+  pParser->DefineFun(Pure(new FunCmplxSin()));
+  pParser->DefineFun(Pure(new FunCmplxCos()));
+  pParser->DefineFun(Pure(new FunCmplxTan()));
+  pParser->DefineFun(Pure(new FunCmplxSinH()));
+  pParser->DefineFun(Pure(new FunCmplxCosH()));
+  pParser->DefineFun(Pure(new FunCmplxTanH()));
+  pParser->DefineFun(Pure(new FunCmplxSqrt()));
+  pParser->DefineFun(Pure(new FunCmplxExp()));
+  pParser->DefineFun(Pure(new FunCmplxLn()));
+  pParser->DefineFun(Pure(new FunCmplxLog()));
+  pParser->DefineFun(Pure(new FunCmplxLog2()));
+  pParser->DefineFun(Pure(new FunCmplxLog10()));
+  pParser->DefineFun(Pure(new FunCmplxAbs()));
+  pParser->DefineFun(Pure(new FunCmplxPow()));
 
   // Complex valued operators
-  pParser->DefineOprt(new OprtAddCmplx());
-  pParser->DefineOprt(new OprtSubCmplx());
-  pParser->DefineOprt(new OprtMulCmplx());
-  pParser->DefineOprt(new OprtDivCmplx());
-  pParser->DefineOprt(new OprtPowCmplx());
-  pParser->DefineInfixOprt(new OprtSignCmplx());
+  pParser->DefineOprt(Pure(new OprtAddCmplx()));
+  pParser->DefineOprt(Pure(new OprtSubCmplx()));
+  pParser->DefineOprt(Pure(new OprtMulCmplx()));
+  pParser->DefineOprt(Pure(new OprtDivCmplx()));
+  pParser->DefineOprt(Pure(new OprtPowCmplx()));
+  pParser->DefineInfixOprt(Pure(new OprtSignCmplx()));
 }
 
 //------------------------------------------------------------------------------
@@ -71,6 +71,7 @@ void PackageCommon::AddToParser(ParserXBase *pParser)
   // Readers that need fancy decorations on their values must
   // be added first (i.e. hex -> "0x...") Otherwise the
   // zero in 0x will be read as a value of zero!
+  pParser->AddValueReader(new DateValReader);
   pParser->AddValueReader(new HexValReader);
   pParser->AddValueReader(new BinValReader);
   pParser->AddValueReader(new DblValReader);
@@ -83,52 +84,60 @@ void PackageCommon::AddToParser(ParserXBase *pParser)
   pParser->DefineConst( _T("null"), (int_type)MUP_CONST_NULL );
 
   // Vector
-  pParser->DefineFun(new FunSizeOf());
+  pParser->DefineFun(Pure(new FunSizeOf()));
 
   // Generic functions
-  pParser->DefineFun(new FunMax());
-  pParser->DefineFun(new FunMin());
-  pParser->DefineFun(new FunSum());
-  pParser->DefineFun(new FunAvg());
+  pParser->DefineFun(Pure(new FunMax()));
+  pParser->DefineFun(Pure(new FunMin()));
+  pParser->DefineFun(Pure(new FunSum()));
+  pParser->DefineFun(Pure(new FunAvg()));
+  pParser->DefineFun(Pure(new FunMedian()));
+  pParser->DefineFun(Pure(new FunPercentile()));
+  pParser->DefineFun(Pure(new FunSort()));
+  pParser->DefineFun(Pure(new FunRank()));
+  pParser->DefineFun(Pure(new FunDistinct()));
+  pParser->DefineFun(Pure(new FunCountIf()));
 
   // Special functions
-  pParser->DefineFun(new FunMask());
+  pParser->DefineFun(Pure(new FunMask()));
 
   // Date functions
-  pParser->DefineFun(new FunDaysDiff());
-  pParser->DefineFun(new FunHoursDiff());
+  pParser->DefineFun(Pure(new FunDaysDiff()));
+  pParser->DefineFun(Pure(new FunHoursDiff()));
   pParser->DefineFun(new FunCurrentDate());
-  pParser->DefineFun(new FunAddDays());
-  pParser->DefineFun(new FunWeekYear());
-  pParser->DefineFun(new FunWeekDay());
+  pParser->DefineFun(Pure(new FunAddDays()));
+  pParser->DefineFun(Pure(new FunDate(false)));
+  pParser->DefineFun(Pure(new FunDate(true)));
+  pParser->DefineFun(Pure(new FunWeekYear()));
+  pParser->DefineFun(Pure(new FunWeekDay()));
 
   // String functions
-  pParser->DefineFun(new FunRegex());
+  pParser->DefineFun(Pure(new FunRegex()));
 
   // Time functions
-  pParser->DefineFun(new FunTimeDiff());
+  pParser->DefineFun(Pure(new FunTimeDiff()));
   pParser->DefineFun(new FunCurrentTime());
 
   // misc
   pParser->DefineFun(new FunParserID);
 
   // integer package
-  pParser->DefineOprt(new OprtLAnd);
-  pParser->DefineOprt(new OprtLOr);
-  pParser->DefineOprt(new OprtAnd);
-  pParser->DefineOprt(new OprtOr);
-  pParser->DefineOprt(new OprtShr);
-  pParser->DefineOprt(new OprtShl);
+  pParser->DefineOprt(Pure(new OprtLAnd));
+  pParser->DefineOprt(Pure(new OprtLOr));
+  pParser->DefineOprt(Pure(new OprtAnd));
+  pParser->DefineOprt(Pure(new OprtOr));
+  pParser->DefineOprt(Pure(new OprtShr));
+  pParser->DefineOprt(Pure(new OprtShl));
 
   // boolean package
-  pParser->DefineOprt(new OprtLE);
-  pParser->DefineOprt(new OprtGE);
-  pParser->DefineOprt(new OprtLT);
-  pParser->DefineOprt(new OprtGT);
-  pParser->DefineOprt(new OprtEQ);
-  pParser->DefineOprt(new OprtNEQ);
-  pParser->DefineOprt(new OprtLAnd(_T("and")));  // add logic and with a different identifier
-  pParser->DefineOprt(new OprtLOr(_T("or")));    // add logic and with a different identifier
+  pParser->DefineOprt(Pure(new OprtLE));
+  pParser->DefineOprt(Pure(new OprtGE));
+  pParser->DefineOprt(Pure(new OprtLT));
+  pParser->DefineOprt(Pure(new OprtGT));
+  pParser->DefineOprt(Pure(new OprtEQ));
+  pParser->DefineOprt(Pure(new OprtNEQ));
+  pParser->DefineOprt(Pure(new OprtLAnd(_T("and"))));  // add logic and with a different identifier
+  pParser->DefineOprt(Pure(new OprtLOr(_T("or"))));    // add logic and with a different identifier
 //  pParser->DefineOprt(new OprtBXor);
 
   // assignement operators
@@ -139,11 +148,11 @@ void PackageCommon::AddToParser(ParserXBase *pParser)
   pParser->DefineOprt(new OprtAssignDiv);
 
   // infix operators
-  pParser->DefineInfixOprt(new OprtCastToFloat);
-  pParser->DefineInfixOprt(new OprtCastToInt);
+  pParser->DefineInfixOprt(Pure(new OprtCastToFloat));
+  pParser->DefineInfixOprt(Pure(new OprtCastToInt));
 
   // postfix operators
-  pParser->DefinePostfixOprt(new OprtFact);
+  pParser->DefinePostfixOprt(Pure(new OprtFact));
 // <ibg 20130708> commented: "%" is a reserved sign for either the
 //                modulo operator or comment lines.
 //  pParser->DefinePostfixOprt(new OprtPercentage);
@@ -54,13 +54,13 @@ IPackage* PackageMatrix::Instance()
 void PackageMatrix::AddToParser(ParserXBase *pParser)
 {
   // Matrix functions
-  pParser->DefineFun(new FunMatrixOnes());
-  pParser->DefineFun(new FunMatrixZeros());
-  pParser->DefineFun(new FunMatrixEye());
-  pParser->DefineFun(new FunMatrixSize());
+  pParser->DefineFun(Pure(new FunMatrixOnes()));
+  pParser->DefineFun(Pure(new FunMatrixZeros()));
+  pParser->DefineFun(Pure(new FunMatrixEye()));
+  pParser->DefineFun(Pure(new FunMatrixSize()));
   
   // Matrix Operators
-  pParser->DefinePostfixOprt(new OprtTranspose());
+  pParser->DefinePostfixOprt(Pure(new OprtTranspose()));
 
   // Colon operator
 //pParser->DefineOprt(new OprtColon());
@@ -55,44 +55,44 @@ IPackage* PackageNonCmplx::Instance()
 //------------------------------------------------------------------------------
 void PackageNonCmplx::AddToParser(ParserXBase *pParser)
 {
-  pParser->DefineFun(new FunSin());
-  pParser->DefineFun(new FunCos());
-  pParser->DefineFun(new FunTan());
-  pParser->DefineFun(new FunSinH());
-  pParser->DefineFun(new FunCosH());
-  pParser->DefineFun(new FunTanH());
-  pParser->DefineFun(new FunASin());
-  pParser->DefineFun(new FunACos());
-  pParser->DefineFun(new FunATan());
-  pParser->DefineFun(new FunASinH());
-  pParser->DefineFun(new FunACosH());
-  pParser->DefineFun(new FunATanH());
-  pParser->DefineFun(new FunLog());
-  pParser->DefineFun(new FunLog10());
-  pParser->DefineFun(new FunLog2());
-  pParser->DefineFun(new FunLn());
-  pParser->DefineFun(new FunExp());
-  pParser->DefineFun(new FunSqrt());
-  pParser->DefineFun(new FunCbrt());
-  pParser->DefineFun(new FunAbs());
-  pParser->DefineFun(new FunRound());
+  pParser->DefineFun(Pure(new FunSin()));
+  pParser->DefineFun(Pure(new FunCos()));
+  pParser->DefineFun(Pure(new FunTan()));
+  pParser->DefineFun(Pure(new FunSinH()));
+  pParser->DefineFun(Pure(new FunCosH()));
+  pParser->DefineFun(Pure(new FunTanH()));
+  pParser->DefineFun(Pure(new FunASin()));
+  pParser->DefineFun(Pure(new FunACos()));
+  pParser->DefineFun(Pure(new FunATan()));
+  pParser->DefineFun(Pure(new FunASinH()));
+  pParser->DefineFun(Pure(new FunACosH()));
+  pParser->DefineFun(Pure(new FunATanH()));
+  pParser->DefineFun(Pure(new FunLog()));
+  pParser->DefineFun(Pure(new FunLog10()));
+  pParser->DefineFun(Pure(new FunLog2()));
+  pParser->DefineFun(Pure(new FunLn()));
+  pParser->DefineFun(Pure(new FunExp()));
+  pParser->DefineFun(Pure(new FunSqrt()));
+  pParser->DefineFun(Pure(new FunCbrt()));
+  pParser->DefineFun(Pure(new FunAbs()));
+  pParser->DefineFun(Pure(new FunRound()));
 
   // binary functions
-  pParser->DefineFun(new FunPow());
-  pParser->DefineFun(new FunHypot());
-  pParser->DefineFun(new FunAtan2());
-  pParser->DefineFun(new FunFmod());
-  pParser->DefineFun(new FunRoundDecimal());
-  pParser->DefineFun(new FunRemainder());
+  pParser->DefineFun(Pure(new FunPow()));
+  pParser->DefineFun(Pure(new FunHypot()));
+  pParser->DefineFun(Pure(new FunAtan2()));
+  pParser->DefineFun(Pure(new FunFmod()));
+  pParser->DefineFun(Pure(new FunRoundDecimal()));
+  pParser->DefineFun(Pure(new FunRemainder()));
 
   // Operator callbacks
-  pParser->DefineInfixOprt(new OprtSign());
-  pParser->DefineInfixOprt(new OprtSignPos());
-  pParser->DefineOprt(new OprtAdd());
-  pParser->DefineOprt(new OprtSub());
-  pParser->DefineOprt(new OprtMul());
-  pParser->DefineOprt(new OprtDiv());
-  pParser->DefineOprt(new OprtPow);
+  pParser->DefineInfixOprt(Pure(new OprtSign()));
+  pParser->DefineInfixOprt(Pure(new OprtSignPos()));
+  pParser->DefineOprt(Pure(new OprtAdd()));
+  pParser->DefineOprt(Pure(new OprtSub()));
+  pParser->DefineOprt(Pure(new OprtMul()));
+  pParser->DefineOprt(Pure(new OprtDiv()));
+  pParser->DefineOprt(Pure(new OprtPow));
 }
 
 //------------------------------------------------------------------------------
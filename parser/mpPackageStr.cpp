@@ -57,22 +57,22 @@ void PackageStr::AddToParser(ParserXBase *pParser)
   pParser->AddValueReader(new StrValReader());
 
   // Functions
-  pParser->DefineFun(new FunStrLen());
-  pParser->DefineFun(new FunStrToNumber());
-  pParser->DefineFun(new FunStrNumber());
-  pParser->DefineFun(new FunStrToUpper());
-  pParser->DefineFun(new FunStrToLower());
-  pParser->DefineFun(new FunStrConcat());
-  pParser->DefineFun(new FunStrLink());
-  pParser->DefineFun(new FunStrLeft());
-  pParser->DefineFun(new FunStrRight());
-  pParser->DefineFun(new FunStrDefaultValue());
-  pParser->DefineFun(new FunString());
-  pParser->DefineFun(new FunStrContains());
+  pParser->DefineFun(Pure(new FunStrLen()));
+  pParser->DefineFun(Pure(new FunStrToNumber()));
+  pParser->DefineFun(Pure(new FunStrNumber()));
+  pParser->DefineFun(Pure(new FunStrToUpper()));
+  pParser->DefineFun(Pure(new FunStrToLower()));
+  pParser->DefineFun(Pure(new FunStrConcat()));
+  pParser->DefineFun(Pure(new FunStrLink()));
+  pParser->DefineFun(Pure(new FunStrLeft()));
+  pParser->DefineFun(Pure(new FunStrRight()));
+  pParser->DefineFun(Pure(new FunStrDefaultValue()));
+  pParser->DefineFun(Pure(new FunString()));
+  pParser->DefineFun(Pure(new FunStrContains()));
   pParser->DefineFun(new FunStrCalculate());
 
   // Operators
-  pParser->DefineOprt(new OprtStrAdd);
+  pParser->DefineOprt(Pure(new OprtStrAdd));
 }
 
 //------------------------------------------------------------------------------
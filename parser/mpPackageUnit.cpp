@@ -96,12 +96,12 @@ IPackage* PackageUnit::Instance()
 //------------------------------------------------------------------------------
 void PackageUnit::AddToParser(ParserXBase *pParser)
 {
-  pParser->DefinePostfixOprt(new OprtNano(this));
-  pParser->DefinePostfixOprt(new OprtMicro(this));
-  pParser->DefinePostfixOprt(new OprtMilli(this));
-  pParser->DefinePostfixOprt(new OprtKilo(this));
-  pParser->DefinePostfixOprt(new OprtMega(this));
-  pParser->DefinePostfixOprt(new OprtGiga(this));
+  pParser->DefinePostfixOprt(Pure(new OprtNano(this)));
+  pParser->DefinePostfixOprt(Pure(new OprtMicro(this)));
+  pParser->DefinePostfixOprt(Pure(new OprtMilli(this)));
+  pParser->DefinePostfixOprt(Pure(new OprtKilo(this)));
+  pParser->DefinePostfixOprt(Pure(new OprtMega(this)));
+  pParser->DefinePostfixOprt(Pure(new OprtGiga(this)));
 }
 
 //------------------------------------------------------------------------------
@@ -43,6 +43,8 @@
 #include "mpDefines.h"
 #include "mpIfThenElse.h"
 #include "mpScriptTokens.h"
+#include "mpStrIntern.h"
+#include "mpTrace.h"
 
 using namespace std;
 
@@ -61,6 +63,10 @@ const char_type *g_sCmdCode[] = {
 	_T("ELSE             "),
 	_T("ENDIF            "),
 	_T("JMP              "),
+	_T("JMP_FALSE        "),
+	_T("JMP_TRUE         "),
+	_T("STORE            "),
+	_T("LOAD             "),
 	_T("VAL              "),
 	_T("FUNC             "),
 	_T("OPRT_BIN         "),
@@ -119,9 +125,14 @@ ParserXBase::ParserXBase()
 	, m_sOprtChars()
 	, m_sInfixOprtChars()
 	, m_bIsQueryingExprVar(false)
+	, m_bExprScanned(false)
+	, m_bReuseTokens(false)
 	, m_bAutoCreateVar(false)
+	, m_bCompensatedSum(false)
+	, m_bProfile(false)
 	, m_rpn()
 	, m_vStackBuffer()
+	, m_pCache(&m_cache)
 {
 	InitTokenReader();
 }
@@ -145,9 +156,15 @@ ParserXBase::ParserXBase(const ParserXBase &a_Parser)
 	, m_sNameChars()
 	, m_sOprtChars()
 	, m_sInfixOprtChars()
+	, m_bIsQueryingExprVar(false)
+	, m_bExprScanned(false)
+	, m_bReuseTokens(false)
 	, m_bAutoCreateVar()
+	, m_bCompensatedSum()
+	, m_bProfile()
 	, m_rpn()
 	, m_vStackBuffer()
+	, m_pCache(&m_cache)
 {
 	m_pTokenReader.reset(new TokenReader(this));
 	Assign(a_Parser);
@@ -159,10 +176,13 @@ ParserXBase::ParserXBase(const ParserXBase &a_Parser)
 	  */
 ParserXBase::~ParserXBase()
 {
-	// It is important to release the stack buffer before
-	// releasing the value cache. Since it may contain
+	// It is important to release the stack buffer, the RPN and the
+	// tokens before releasing the value cache. Since they may contain
 	// Values referencing the cache.
 	m_vStackBuffer.clear();
+	m_rpn.Reset();
+	m_stOpt.clear();
+	m_pTokenReader->ReInit();
 	m_cache.ReleaseAll();
 }
 
@@ -213,11 +233,15 @@ void ParserXBase::Assign(const ParserXBase &ref)
 	m_sInfixOprtChars = ref.m_sInfixOprtChars;
 
 	m_bAutoCreateVar = ref.m_bAutoCreateVar;
+	m_bCompensatedSum = ref.m_bCompensatedSum;
+	m_bProfile = ref.m_bProfile;
+	EnableSharedValueCache(ref.IsSharedValueCacheEnabled());
 
 	// Things that should not be copied:
 	// - m_vStackBuffer
 	// - m_cache
 	// - m_rpn
+	// - m_profiler
 }
 
 //---------------------------------------------------------------------------
@@ -336,8 +360,20 @@ void ParserXBase::ReInit() const
 	m_pParserEngine = &ParserXBase::ParseFromString;
 	m_pTokenReader->ReInit();
 	m_rpn.Reset();
-	m_vStackBuffer.clear();
 	m_nPos = 0;
+	ResetScan();
+}
+
+//---------------------------------------------------------------------------
+/** \brief Discard the tokens stored by a preceding scan of the expression.
+
+	New definitions may change the way the expression is broken up into
+	tokens. A compiled RPN is not affected.
+	*/
+void ParserXBase::ResetScan() const
+{
+	m_bExprScanned = false;
+	m_bReuseTokens = false;
 }
 
 //---------------------------------------------------------------------------
@@ -389,6 +425,8 @@ void ParserXBase::SetExpr(const string_type &a_sExpr)
 {
 	m_pTokenReader->SetExpr(a_sExpr);
 	ReInit();
+
+	MUP_TRACE1(set_expr, m_pTokenReader->GetExpr().c_str());
 }
 
 //---------------------------------------------------------------------------
@@ -431,7 +469,13 @@ void ParserXBase::DefineConst(const string_type &ident, const Value &val)
 
 	CheckForEntityExistence(ident, ecCONSTANT_DEFINED);
 
-	m_valDef[ident] = ptr_tok_type(val.Clone());
+	// String constants are interned like string literals
+	Value *pVal = static_cast<Value*>(val.Clone());
+	if (pVal->GetType() == 's')
+		*pVal = InternString(val.GetString());
+
+	m_valDef[ident] = ptr_tok_type(pVal);
+	ResetScan();
 }
 
 //---------------------------------------------------------------------------
@@ -449,6 +493,7 @@ void ParserXBase::DefineFun(const ptr_cal_type &fun)
 
 	fun->SetParent(this);
 	m_FunDef[fun->GetIdent()] = ptr_tok_type(fun->Clone());
+	ResetScan();
 }
 
 //---------------------------------------------------------------------------
@@ -462,6 +507,7 @@ void ParserXBase::DefineOprt(const TokenPtr<IOprtBin> &oprt)
 
 	oprt->SetParent(this);
 	m_OprtDef[oprt->GetIdent()] = ptr_tok_type(oprt->Clone());
+	ResetScan();
 }
 
 //---------------------------------------------------------------------------
@@ -478,6 +524,7 @@ void ParserXBase::DefinePostfixOprt(const TokenPtr<IOprtPostfix> &oprt)
 	// Operator is not added yet, add it.
 	oprt->SetParent(this);
 	m_PostOprtDef[oprt->GetIdent()] = ptr_tok_type(oprt->Clone());
+	ResetScan();
 }
 
 //---------------------------------------------------------------------------
@@ -493,6 +540,7 @@ void ParserXBase::DefineInfixOprt(const TokenPtr<IOprtInfix> &oprt)
 	// Function is not added yet, add it.
 	oprt->SetParent(this);
 	m_InfixOprtDef[oprt->GetIdent()] = ptr_tok_type(oprt->Clone());
+	ResetScan();
 }
 
 //---------------------------------------------------------------------------
@@ -577,14 +625,26 @@ bool ParserXBase::IsInfixOprtDefined(const string_type &ident) const
 /** \brief Return a map containing the used variables only. */
 const var_maptype& ParserXBase::GetExprVar() const
 {
-	utils::scoped_setter<bool> guard(m_bIsQueryingExprVar, true);
-
-	// Create RPN,  but do not compute the result or switch to RPN
-	// parsing mode. The expression may contain yet to be defined variables.
-	CreateRPN();
+	ScanExpr();
 	return m_pTokenReader->GetUsedVar();
 }
 
+//---------------------------------------------------------------------------
+/** \brief Return a map containing the used functions only. */
+const fun_maptype& ParserXBase::GetExprFun() const
+{
+	ScanExpr();
+	return m_pTokenReader->GetUsedFun();
+}
+
+//---------------------------------------------------------------------------
+/** \brief Return a map containing the used constants only. */
+const val_maptype& ParserXBase::GetExprConst() const
+{
+	ScanExpr();
+	return m_pTokenReader->GetUsedConst();
+}
+
 //---------------------------------------------------------------------------
 /** \brief Return a map containing the used variables only. */
 const var_maptype& ParserXBase::GetVar() const
@@ -702,20 +762,77 @@ void ParserXBase::DumpRPN() const
 	m_rpn.AsciiDump();
 }
 
+//---------------------------------------------------------------------------
+/** \brief Writes the reverse polish notation of the expression to a stream. */
+void ParserXBase::DumpRPN(std::basic_ostream<char_type> &os) const
+{
+	m_rpn.AsciiDump(os);
+}
+
+//---------------------------------------------------------------------------
+/** \brief Read the tokens of the expression without creating the RPN.
+
+	This is a lexical pass only, neither the RPN nor the stack buffer are created.
+	The expression may contain yet to be defined variables. The token reader keeps
+	the tokens so the next call to CreateRPN does not need to read them again.
+	*/
+void ParserXBase::ScanExpr() const
+{
+	if (m_bExprScanned)
+		return;
+
+	if (!m_pTokenReader->GetExpr().length())
+		Error(ecUNEXPECTED_EOF, 0);
+
+	utils::scoped_setter<bool> guard(m_bIsQueryingExprVar, true);
+
+	ReInit();
+	while (m_pTokenReader->ReadNextToken()->GetCode() != cmEOE)
+		;
+
+	bool bReuse = true;
+	const var_maptype &vars = m_pTokenReader->GetUsedVar();
+	for (var_maptype::const_iterator it = vars.begin(); it != vars.end(); ++it)
+	{
+		if (m_varDef.find(it->first) == m_varDef.end())
+		{
+			bReuse = false;
+			break;
+		}
+	}
+
+	m_bExprScanned = true;
+	m_bReuseTokens = bReuse;
+}
+
 //---------------------------------------------------------------------------
 void ParserXBase::CreateRPN() const
 {
 	if (!m_pTokenReader->GetExpr().length())
 		Error(ecUNEXPECTED_EOF, 0);
 
-	// The Stacks take the ownership over the tokens
-	Stack<ptr_tok_type> stOpt;
-	Stack<int>  stArgCount;
-	Stack<int>  stIdxCount;
+	MUP_TRACE1(compile_begin, m_pTokenReader->GetExpr().c_str());
+
+	// The Stacks take the ownership over the tokens. They are members so
+	// their capacity is kept when the parser is used with another expression.
+	Stack<ptr_tok_type> &stOpt = m_stOpt;
+	Stack<int> &stArgCount = m_stArgCount;
+	Stack<int> &stIdxCount = m_stIdxCount;
+	stOpt.clear();
+	stArgCount.clear();
+	stIdxCount.clear();
 	ptr_tok_type pTok, pTokPrev;
 	Value val;
 
-	ReInit();
+	if (m_bReuseTokens)
+	{
+		// The expression has been read before, hand out the stored tokens again
+		m_pTokenReader->Rewind();
+		m_rpn.Reset();
+		m_nPos = 0;
+	}
+	else
+		ReInit();
 
 	for (;;)
 	{
@@ -844,7 +961,7 @@ void ParserXBase::CreateRPN() const
 
 		case  cmARG_SEP:
 			if (stArgCount.empty())
-				Error(ecUNEXPECTED_COMMA, m_pTokenReader->GetPos() - 1);
+				Error(ecUNEXPECTED_COMMA, pTok->GetExprPos());
 
 			++stArgCount.top();
 
@@ -895,7 +1012,17 @@ void ParserXBase::CreateRPN() const
 			} // while ( ... )
 
 			if (pTok->GetCode() == cmIF)
+			{
 				m_rpn.Add(pTok);
+			}
+			else
+			{
+				// The left operand is complete now. Operators able to tell their
+				// result from it get a jump token in front of the right operand.
+				ECmdCode eJmp = static_cast<IOprtBin*>(pTok->AsICallback())->GetShortCircuitCode();
+				if (eJmp != cmUNKNOWN)
+					m_rpn.Add(ptr_tok_type(new TokenIfThenElse(eJmp)));
+			}
 
 			stOpt.push(pTok);
 		}
@@ -950,38 +1077,77 @@ void ParserXBase::CreateRPN() const
 	{
 		Error(ecUNEXPECTED_COMMA, -1);
 	}
+
+	m_bExprScanned = true;
+	m_bReuseTokens = true;
+
+	MUP_TRACE2(compile_end, m_pTokenReader->GetExpr().c_str(), m_rpn.GetSize());
 }
 
 //---------------------------------------------------------------------------
-/** \brief One of the two main parse functions.
-	  \sa ParseCmdCode(), ParseValue()
+/** \brief Translates the expression into reverse polish notation.
 
-	  Parse expression from input string. Perform syntax checking and create bytecode.
-	  After parsing the string and creating the bytecode the function pointer
-	  #m_pParseFormula will be changed to the second parse routine the uses bytecode instead of string parsing.
-	  */
-const IValue& ParserXBase::ParseFromString() const
+	Eval() does this when it is called for the first time after the expression
+	was set. Calling Compile first separates the translation from the evaluation.
+	*/
+void ParserXBase::Compile() const
 {
 	CreateRPN();
 
 	// Umsachalten auf RPN
-	m_vStackBuffer.assign(m_rpn.GetRequiredStackSize(), ptr_val_type());
+	// The temporaries of the optimizer are placed behind the stack. Value items
+	// of a previous expression are reused, slots still referencing a variable
+	// get their own value item since they may be written to.
+	m_vStackBuffer.resize(m_rpn.GetRequiredStackSize() + m_rpn.GetNumTemp());
+	m_pCache->Reserve((int)m_vStackBuffer.size());
 	for (std::size_t i = 0; i < m_vStackBuffer.size(); ++i)
 	{
-		Value *pValue = new Value;
-		pValue->BindToCache(&m_cache);
-		m_vStackBuffer[i].Reset(pValue);
+		ptr_val_type &val = m_vStackBuffer[i];
+		if (val.Get() == nullptr || val->IsVariable())
+			val.Reset(m_pCache->CreateFromCache());
 	}
 
-	m_pParserEngine = &ParserXBase::ParseFromRPN;
+	// Profiling is done by a separate instance of the evaluation loop, the loop
+	// of the unprofiled instance does not check whether profiling is enabled.
+	m_pParserEngine = (m_bProfile) ? &ParserXBase::ParseFromRPN<true> : &ParserXBase::ParseFromRPN<false>;
+}
 
+//---------------------------------------------------------------------------
+/** \brief One of the two main parse functions.
+	  \sa ParseCmdCode(), ParseValue()
+
+	  Parse expression from input string. Perform syntax checking and create bytecode.
+	  After parsing the string and creating the bytecode the function pointer
+	  #m_pParseFormula will be changed to the second parse routine the uses bytecode instead of string parsing.
+	  */
+const IValue& ParserXBase::ParseFromString() const
+{
+	Compile();
 	return (this->*m_pParserEngine)();
 }
 
 //---------------------------------------------------------------------------
+/** \brief Adds a call of a callback to the profile of this parser and of the process.
+	  \param pFun The callback called
+	  \param sArgTypes The type codes of its arguments
+	  \param tStart The time the call started
+	  */
+void ParserXBase::RecordCall(const ICallback *pFun, const string_type &sArgTypes, Profiler::clock_type::time_point tStart) const
+{
+	unsigned long long nNs = (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(Profiler::clock_type::now() - tStart).count();
+	m_profiler.Record(pFun->GetIdent(), sArgTypes, nNs);
+	Profiler::Process().Record(pFun->GetIdent(), sArgTypes, nNs);
+}
+
+//---------------------------------------------------------------------------
+/** \brief Evaluates the expression in reverse polish notation.
+	  \tparam bProfile If true the calls of callbacks are timed and recorded.
+	  */
+template<bool bProfile>
 const IValue& ParserXBase::ParseFromRPN() const
 {
 	ptr_val_type *pStack = &m_vStackBuffer[0];
+	ptr_val_type *pTemp = pStack + m_rpn.GetRequiredStackSize();
 	if (m_rpn.GetSize() == 0)
 	{
 		// Passiert bei leeren strings oder solchen, die nur Leerzeichen enthalten
@@ -992,6 +1158,8 @@ const IValue& ParserXBase::ParseFromRPN() const
 		throw ParserError(err);
 	}
 
+	MUP_TRACE1(eval_begin, m_pTokenReader->GetExpr().c_str());
+
 	const ptr_tok_type *pRPN = &(m_rpn.GetData()[0]);
 
 	int sidx = -1;
@@ -1021,7 +1189,7 @@ const IValue& ParserXBase::ParseFromRPN() const
 			{
 				ptr_val_type &val = pStack[sidx];
 				if (val->IsVariable())
-					val.Reset(m_cache.CreateFromCache());
+					val.Reset(m_pCache->CreateFromCache());
 
 				*val = *(static_cast<IValue*>(pTok));
 			}
@@ -1041,7 +1209,7 @@ const IValue& ParserXBase::ParseFromRPN() const
 	  ptr_val_type &val = pStack[sidx];   // Pointer to the variable or value beeing indexed
 	  if (val->IsVariable())
 	  {
-	  ptr_val_type buf(m_cache.CreateFromCache());
+	  ptr_val_type buf(m_pCache->CreateFromCache());
 	  pFun->Eval(buf, &val, nArgs);
 	  val = buf;
 	  }
@@ -1061,7 +1229,21 @@ const IValue& ParserXBase::ParseFromRPN() const
 
 			ptr_val_type &idx = pStack[sidx];   // Pointer to the first index
 			ptr_val_type &val = pStack[--sidx];   // Pointer to the variable or value beeing indexed
+
+			string_type sArgTypes;
+			Profiler::clock_type::time_point tStart;
+			if (bProfile)
+			{
+				sArgTypes = Profiler::GetArgTypes(&val, nArgs + 1);
+				tStart = Profiler::clock_type::now();
+			}
+
+			MUP_TRACE1(callback_entry, pIdxOprt->GetIdent().c_str());
 			pIdxOprt->Eval(val, &idx, nArgs);
+			MUP_TRACE1(callback_exit, pIdxOprt->GetIdent().c_str());
+
+			if (bProfile)
+				RecordCall(pIdxOprt, sArgTypes, tStart);
 		}
 		continue;
 
@@ -1077,11 +1259,21 @@ const IValue& ParserXBase::ParseFromRPN() const
 			MUP_VERIFY(sidx >= 0);
 
 			ptr_val_type &val = pStack[sidx];
+
+			string_type sArgTypes;
+			Profiler::clock_type::time_point tStart;
+			if (bProfile)
+			{
+				sArgTypes = Profiler::GetArgTypes(&val, nArgs);
+				tStart = Profiler::clock_type::now();
+			}
+
+			MUP_TRACE1(callback_entry, pFun->GetIdent().c_str());
 			try
 			{
 				if (val->IsVariable())
 				{
-					ptr_val_type buf(m_cache.CreateFromCache());
+					ptr_val_type buf(m_pCache->CreateFromCache());
 					pFun->Eval(buf, &val, nArgs);
 					val = buf;
 				}
@@ -1114,7 +1306,7 @@ const IValue& ParserXBase::ParseFromRPN() const
 					err.Expr = m_pTokenReader->GetExpr();
 					err.Ident = pFun->GetIdent();
 					err.Errc = ecEVAL;
-					err.Pos = pFun->GetExprPos();
+					err.Pos = pFun->GetArgPos(exc.GetContext().Arg);
 					err.Hint = exc.GetMsg();
 					throw ParserError(err);
 				}
@@ -1128,6 +1320,10 @@ const IValue& ParserXBase::ParseFromRPN() const
 				err.Pos = pFun->GetExprPos();
 				throw ParserError(err);
 			}
+			MUP_TRACE1(callback_exit, pFun->GetIdent().c_str());
+
+			if (bProfile)
+				RecordCall(pFun, sArgTypes, tStart);
 		}
 		continue;
 
@@ -1137,6 +1333,45 @@ const IValue& ParserXBase::ParseFromRPN() const
 				i += static_cast<TokenIfThenElse*>(pTok)->GetOffset();
 			continue;
 
+		case cmSTORE:
+			MUP_VERIFY(sidx >= 0);
+			*pTemp[static_cast<TokenTemp*>(pTok)->GetSlot()] = *pStack[sidx];
+			continue;
+
+		case cmLOAD:
+		{
+			sidx++;
+			MUP_VERIFY(sidx < m_rpn.GetRequiredStackSize());
+
+			ptr_val_type &val = pStack[sidx];
+			if (val->IsVariable())
+				val.Reset(m_pCache->CreateFromCache());
+
+			*val = *pTemp[static_cast<TokenTemp*>(pTok)->GetSlot()];
+		}
+		continue;
+
+		case cmJMP_FALSE:
+		case cmJMP_TRUE:
+		{
+			MUP_VERIFY(sidx >= 0);
+
+			// Skip the right operand and the operator if the left operand decides
+			// the result. Non boolean values are left to the operator for raising
+			// the type conflict.
+			ptr_val_type &val = pStack[sidx];
+			bool bRes = (eCode == cmJMP_TRUE);
+			if (val->GetType() == 'b' && val->GetBool() == bRes)
+			{
+				if (val->IsVariable())
+					val.Reset(m_pCache->CreateFromCache());
+
+				*val = bRes;
+				i += static_cast<TokenIfThenElse*>(pTok)->GetOffset();
+			}
+		}
+		continue;
+
 		case cmELSE:
 		case cmJMP:
 			i += static_cast<TokenIfThenElse*>(pTok)->GetOffset();
@@ -1150,6 +1385,7 @@ const IValue& ParserXBase::ParseFromRPN() const
 		} // switch token
 	} // for all RPN tokens
 
+	MUP_TRACE1(eval_end, m_pTokenReader->GetExpr().c_str());
 	return *pStack[0];
 }
 
@@ -1253,6 +1489,17 @@ void ParserXBase::EnableOptimizer(bool bStat)
 	m_rpn.EnableOptimizer(bStat);
 }
 
+//------------------------------------------------------------------------------
+/** \brief Enable compensated summation in sum and avg.
+
+	  Compensated summation keeps the rounding error of long sums from growing
+	  with the number of values at the cost of a slower summation.
+	  */
+void ParserXBase::EnableCompensatedSum(bool bStat)
+{
+	m_bCompensatedSum = bStat;
+}
+
 //---------------------------------------------------------------------------
 /** \brief Enable the dumping of bytecode amd stack content on the console.
 	  \param bDumpCmd Flag to enable dumping of the current bytecode to the console.
@@ -1272,6 +1519,83 @@ bool ParserXBase::IsAutoCreateVarEnabled() const
 	return m_bAutoCreateVar;
 }
 
+//------------------------------------------------------------------------------
+bool ParserXBase::IsCompensatedSumEnabled() const
+{
+	return m_bCompensatedSum;
+}
+
+//------------------------------------------------------------------------------
+/** \brief Enable profiling of the functions and operators called during evaluation.
+
+	  The calls are recorded in the profile of this parser and in the profile of 
+	  the process. Evaluation without profiling does not pay for it.
+	  */
+void ParserXBase::EnableProfiling(bool bStat)
+{
+	m_bProfile = bStat;
+
+	// Switch the evaluation loop of an expression compiled already
+	if (m_pParserEngine != &ParserXBase::ParseFromString)
+		m_pParserEngine = (m_bProfile) ? &ParserXBase::ParseFromRPN<true> : &ParserXBase::ParseFromRPN<false>;
+}
+
+//------------------------------------------------------------------------------
+/** \brief Recycle value items in the cache shared by the parsers of the calling thread.
+
+	  Short lived parsers reuse the values of parsers destroyed before them. The 
+	  parser must be used and destroyed by the thread enabling the shared cache.
+	  */
+void ParserXBase::EnableSharedValueCache(bool bStat)
+{
+	m_pCache = (bStat) ? &ValueCache::GetThreadCache() : &m_cache;
+}
+
+//------------------------------------------------------------------------------
+bool ParserXBase::IsSharedValueCacheEnabled() const
+{
+	return m_pCache != &m_cache;
+}
+
+//------------------------------------------------------------------------------
+/** \brief Returns the counters of the value cache used by this parser. */
+ValueCacheStats ParserXBase::GetValueCacheStats() const
+{
+	return m_pCache->GetStats();
+}
+
+//------------------------------------------------------------------------------
+bool ParserXBase::IsProfilingEnabled() const
+{
+	return m_bProfile;
+}
+
+//------------------------------------------------------------------------------
+/** \brief Returns the statistics of the callbacks called by this parser. */
+profile_maptype ParserXBase::GetProfile() const
+{
+	return m_profiler.Snapshot();
+}
+
+//------------------------------------------------------------------------------
+void ParserXBase::ResetProfile()
+{
+	m_profiler.Reset();
+}
+
+//------------------------------------------------------------------------------
+/** \brief Returns the statistics of the callbacks called by all parsers of the process. */
+profile_maptype ParserXBase::GetProcessProfile()
+{
+	return Profiler::Process().Snapshot();
+}
+
+//------------------------------------------------------------------------------
+void ParserXBase::ResetProcessProfile()
+{
+	Profiler::Process().Reset();
+}
+
 //------------------------------------------------------------------------------
 /** \brief Dump stack content.
 
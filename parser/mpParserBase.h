@@ -53,6 +53,7 @@
 #include "mpTypes.h"
 #include "mpRPN.h"
 #include "mpValueCache.h"
+#include "mpProfiler.h"
 
 MUP_NAMESPACE_START
   
@@ -85,6 +86,7 @@ MUP_NAMESPACE_START
     virtual ~ParserXBase();
     
     const IValue& Eval() const;
+    void Compile() const;
 
     void SetExpr(const string_type &a_sExpr);
     void AddValueReader(IValueReader *a_pReader);
@@ -120,8 +122,11 @@ MUP_NAMESPACE_START
     void ClearPostfixOprt();
     void ClearOprt();
     void DumpRPN() const;
+    void DumpRPN(std::basic_ostream<char_type> &os) const;
 
     const var_maptype& GetExprVar() const;
+    const fun_maptype& GetExprFun() const;
+    const val_maptype& GetExprConst() const;
     const var_maptype& GetVar() const;
     const val_maptype& GetConst() const;
     const fun_maptype& GetFunDef() const;
@@ -134,7 +139,20 @@ MUP_NAMESPACE_START
     
     void EnableAutoCreateVar(bool bStat);
     void EnableOptimizer(bool bStat);
+    void EnableCompensatedSum(bool bStat);
+    void EnableProfiling(bool bStat);
+    void EnableSharedValueCache(bool bStat);
     bool IsAutoCreateVarEnabled() const;
+    bool IsCompensatedSumEnabled() const;
+    bool IsProfilingEnabled() const;
+    bool IsSharedValueCacheEnabled() const;
+
+    ValueCacheStats GetValueCacheStats() const;
+
+    profile_maptype GetProfile() const;
+    void ResetProfile();
+    static profile_maptype GetProcessProfile();
+    static void ResetProcessProfile();
 
     const char_type* ValidNameChars() const;
     const char_type* ValidOprtChars() const;
@@ -159,7 +177,9 @@ MUP_NAMESPACE_START
   private:
 
     void  ReInit() const;
+    void  ResetScan() const;
     void  ClearExpr();
+    void  ScanExpr() const;
     void  CreateRPN() const;
     void  StackDump(const Stack<ptr_tok_type> &a_stOprt) const;
 
@@ -174,7 +194,8 @@ MUP_NAMESPACE_START
     void ApplyIfElse(Stack<ptr_tok_type> &a_stOpt) const;
     void ApplyRemainingOprt(Stack<ptr_tok_type> &a_stOpt) const;
     const IValue& ParseFromString() const; 
-    const IValue& ParseFromRPN() const; 
+    template<bool bProfile> const IValue& ParseFromRPN() const;
+    void RecordCall(const ICallback *pFun, const string_type &sArgTypes, Profiler::clock_type::time_point tStart) const;
 
     /** \brief Pointer to the parser function. 
     
@@ -212,11 +233,33 @@ MUP_NAMESPACE_START
     */
     mutable bool m_bIsQueryingExprVar;    
 
+    /** \brief A flag indicating the token reader holds all tokens of the expression.
+
+      Set after the expression has been read completely either by ScanExpr or by 
+      CreateRPN. The lists of used variables, functions and constants are valid
+      until the expression or the parser definitions change.
+    */
+    mutable bool m_bExprScanned;
+
+    /** \brief A flag indicating CreateRPN may reuse the stored tokens. 
+
+      Tokens of undefined variables are not bound to a value. If the scan found
+      any the expression has to be read once more for evaluation.
+    */
+    mutable bool m_bReuseTokens;
+
     mutable bool m_bAutoCreateVar;      ///< If this flag is set unknown variables will be defined automatically
+    bool m_bCompensatedSum;             ///< If this flag is set sum and avg use compensated summation
+    bool m_bProfile;                    ///< If this flag is set the calls of callbacks are profiled
 
     mutable RPN m_rpn;                  ///< reverse polish notation
+    mutable Stack<ptr_tok_type> m_stOpt; ///< Operator stack used by CreateRPN
+    mutable Stack<int> m_stArgCount;     ///< Argument counters used by CreateRPN
+    mutable Stack<int> m_stIdxCount;     ///< Index counters used by CreateRPN
     mutable val_vec_type m_vStackBuffer;
     mutable ValueCache m_cache;         ///< A cache for recycling value items instead of deleting them
+    ValueCache *m_pCache;               ///< The cache in use, either m_cache or the cache of the thread
+    mutable Profiler m_profiler;        ///< Statistics of the callbacks called by this parser
 
   };
 MUP_NAMESPACE_END
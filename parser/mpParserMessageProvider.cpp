@@ -113,6 +113,9 @@ MUP_NAMESPACE_START
     m_vErrMsg[ecINVALID_TYPES_MATCH]          = _T("Both values of the default(x, y) function should have the same type");
     m_vErrMsg[ecUKNOWN_LOCALE]                = _T("The chosen locale is not supported");
     m_vErrMsg[ecINVALID_TIME_FORMAT]          = _T("Invalid time format on parameter(s). Please use the \"HH:MM:SS\" format.");
+    m_vErrMsg[ecCIRCULAR_DEPENDENCY]          = _T("Formula \"$IDENT$\" depends on its own result.");
+    m_vErrMsg[ecUNDEFINED_NAME]               = _T("Neither an input nor a formula named \"$IDENT$\" is defined.");
+    m_vErrMsg[ecNOT_AN_INPUT]                 = _T("\"$IDENT$\" is a formula and can't be set as an input.");
   }
 
 #if defined(_UNICODE)
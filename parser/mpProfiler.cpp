@@ -0,0 +1,113 @@
+/** \file
+    \brief Implementation of the profiler recording the calls of callbacks during evaluation.
+
+<pre>
+               __________                                 ____  ___
+    _____  __ _\______   \_____ _______  ______ __________\   \/  /
+   /     \|  |  \     ___/\__  \\_  __ \/  ___// __ \_  __ \     / 
+  |  Y Y  \  |  /    |     / __ \|  | \/\___ \\  ___/|  | \/     \ 
+  |__|_|  /____/|____|    (____  /__|  /____  >\___  >__| /___/\  \
+        \/                     \/           \/     \/           \_/
+                                       Copyright (C) 2016, Ingo Berg
+                                       All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without 
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice, 
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright notice, 
+     this list of conditions and the following disclaimer in the documentation 
+     and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. 
+  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT 
+  NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+  POSSIBILITY OF SUCH DAMAGE.
+  </pre>
+*/
+
+
+#include "mpProfiler.h"
+
+//--- muParserX framework --------------------------------------------------
+#include "mpIValue.h"
+
+
+MUP_NAMESPACE_START
+
+  //------------------------------------------------------------------------------
+  CallbackStats::CallbackStats()
+    :Calls(0)
+    ,TotalNs(0)
+    ,MaxNs(0)
+    ,ArgTypes()
+  {}
+
+  //------------------------------------------------------------------------------
+  Profiler::Profiler()
+    :m_mtx()
+    ,m_mapStats()
+  {}
+
+  //------------------------------------------------------------------------------
+  /** \brief Adds a call of a callback to the statistics.
+      \param sIdent Identifier of the callback
+      \param sArgTypes Type codes of the arguments as returned by GetArgTypes
+      \param nNs Time of the call in nanoseconds
+  */
+  void Profiler::Record(const string_type &sIdent, const string_type &sArgTypes, unsigned long long nNs)
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+
+    CallbackStats &stats = m_mapStats[sIdent];
+    ++stats.Calls;
+    stats.TotalNs += nNs;
+    if (nNs > stats.MaxNs)
+      stats.MaxNs = nNs;
+
+    ++stats.ArgTypes[sArgTypes];
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Returns a copy of the statistics collected so far. */
+  profile_maptype Profiler::Snapshot() const
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_mapStats;
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Discards the statistics collected so far. */
+  void Profiler::Reset()
+  {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_mapStats.clear();
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Returns the profiler aggregating the calls of all parsers. */
+  Profiler& Profiler::Process()
+  {
+    static Profiler s_profiler;
+    return s_profiler;
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Returns the type codes of a list of arguments as a string. */
+  string_type Profiler::GetArgTypes(const ptr_val_type *a_pArg, int a_iArgc)
+  {
+    string_type sTypes;
+    for (int i = 0; i < a_iArgc; ++i)
+      sTypes += a_pArg[i]->GetType();
+
+    return sTypes;
+  }
+
+MUP_NAMESPACE_END
@@ -0,0 +1,104 @@
+/** \file
+    \brief Definition of the profiler recording the calls of callbacks during evaluation.
+
+<pre>
+               __________                                 ____  ___
+    _____  __ _\______   \_____ _______  ______ __________\   \/  /
+   /     \|  |  \     ___/\__  \\_  __ \/  ___// __ \_  __ \     / 
+  |  Y Y  \  |  /    |     / __ \|  | \/\___ \\  ___/|  | \/     \ 
+  |__|_|  /____/|____|    (____  /__|  /____  >\___  >__| /___/\  \
+        \/                     \/           \/     \/           \_/
+                                       Copyright (C) 2016, Ingo Berg
+                                       All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without 
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice, 
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright notice, 
+     this list of conditions and the following disclaimer in the documentation 
+     and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. 
+  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT 
+  NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+  POSSIBILITY OF SUCH DAMAGE.
+  </pre>
+*/
+
+
+#ifndef MUP_PROFILER_H
+#define MUP_PROFILER_H
+
+//--- Standard includes ----------------------------------------------------
+#include <chrono>
+#include <map>
+#include <mutex>
+
+//--- muParserX framework --------------------------------------------------
+#include "mpTypes.h"
+
+
+MUP_NAMESPACE_START
+
+  //------------------------------------------------------------------------------
+  /** \brief Statistics of the calls of a single callback. */
+  struct CallbackStats
+  {
+    CallbackStats();
+
+    unsigned long long Calls;    ///< Number of calls
+    unsigned long long TotalNs;  ///< Cumulative time of all calls in nanoseconds
+    unsigned long long MaxNs;    ///< Time of the slowest call in nanoseconds
+
+    /** \brief Number of calls per argument type signature.
+    
+      The signature holds the type code of each argument, "fs" stands for 
+      a call with a floating point and a string argument.
+    */
+    std::map<string_type, unsigned long long> ArgTypes;
+  };
+
+  /** \brief Type of a profile, the statistics of each callback identifier. */
+  typedef std::map<string_type, CallbackStats> profile_maptype;
+
+  //------------------------------------------------------------------------------
+  /** \brief Profiler collecting the statistics of callbacks called during evaluation.
+
+    Each parser has its own profiler, the process wide profiler aggregates the 
+    calls of all parsers. Recording is thread safe.
+  */
+  class Profiler
+  {
+  public:
+
+    typedef std::chrono::steady_clock clock_type;
+
+    Profiler();
+
+    void Record(const string_type &sIdent, const string_type &sArgTypes, unsigned long long nNs);
+    profile_maptype Snapshot() const;
+    void Reset();
+
+    static Profiler& Process();
+    static string_type GetArgTypes(const ptr_val_type *a_pArg, int a_iArgc);
+
+  private:
+
+    Profiler(const Profiler &a_Profiler);
+    Profiler& operator=(const Profiler &a_Profiler);
+
+    mutable std::mutex m_mtx;
+    profile_maptype m_mapStats;
+  }; // class Profiler
+
+MUP_NAMESPACE_END
+
+#endif
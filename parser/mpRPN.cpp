@@ -31,14 +31,21 @@
 
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
+#include <functional>
+#include <utility>
 
 #include "mpRPN.h"
 #include "mpIToken.h"
 #include "mpICallback.h"
+#include "mpIOprt.h"
+#include "mpIValue.h"
+#include "mpVariable.h"
 #include "mpError.h"
 #include "mpStack.h"
 #include "mpIfThenElse.h"
 #include "mpScriptTokens.h"
+#include "mpOprtBinCommon.h"
 
 MUP_NAMESPACE_START
 
@@ -48,7 +55,8 @@ RPN::RPN()
 	, m_nStackPos(-1)
 	, m_nLine(0)
 	, m_nMaxStackPos(0)
-	, m_bEnableOptimizer(false)
+	, m_nNumTemp(0)
+	, m_bEnableOptimizer(true)
 {}
 
 //---------------------------------------------------------------------------
@@ -106,19 +114,39 @@ void RPN::Reset()
 	m_vRPN.clear();
 	m_nStackPos = -1;
 	m_nMaxStackPos = 0;
+	m_nNumTemp = 0;
 	m_nLine = 0;
 }
 
 //---------------------------------------------------------------------------
-/** \brief
+/** \brief Finish the RPN once the last token has been added.
 
-	At the moment this will only ass the jump distances to the if-else clauses
-	found in the expression.
+	Sets the jump distances and, if the optimizer is enabled, fuses chains of
+	string concatenations and replaces repeated subexpressions with a temporary
+	computed only once.
 */
 void RPN::Finalize()
+{
+	if (m_bEnableOptimizer)
+		FuseStrConcat();
+
+	SetJumpOffsets();
+
+	if (m_bEnableOptimizer)
+	{
+		while (EliminateCommonSubexpr())
+			SetJumpOffsets();
+	}
+}
+
+//---------------------------------------------------------------------------
+/** \brief Set the jump distances of the if-else clauses and of the
+	short-circuit jumps of logical operators found in the expression.
+*/
+void RPN::SetJumpOffsets()
 {
 	// Determine the if-then-else jump offsets
-	Stack<int> stIf, stElse;
+	Stack<int> stIf, stElse, stJmp;
 	int idx;
 	for (int i = 0; i < static_cast<int>(m_vRPN.size()); ++i)
 	{
@@ -139,12 +167,461 @@ void RPN::Finalize()
 			static_cast<TokenIfThenElse*>(m_vRPN[idx].Get())->SetOffset(i - idx);
 			break;
 
+		case  cmJMP_FALSE:
+		case  cmJMP_TRUE:
+			stJmp.push(i);
+			break;
+
+		// A short-circuit jump lands on its operator, which is skipped as well
+		case  cmOPRT_BIN:
+			if (static_cast<IOprtBin*>(m_vRPN[i]->AsICallback())->GetShortCircuitCode() == cmUNKNOWN)
+				continue;
+
+			idx = stJmp.pop();
+			static_cast<TokenIfThenElse*>(m_vRPN[idx].Get())->SetOffset(i - idx);
+			break;
+
 		default:
 			continue;
 		}
 	}
 }
 
+//---------------------------------------------------------------------------
+/** \brief Replace chains of the string concatenation operator with a single
+	callback concatenating all operands.
+
+	<tt>a // b // c</tt> is compiled to <tt>a b // c //</tt>, each operator
+	copying the string built so far. An operator having another concatenation
+	as operand takes over its operands instead, the chain is then evaluated
+	with a single allocation. Jumps never land on a concatenation so removing
+	the inner operators does not break any jump. Each operand keeps the 
+	position of the operator reading it for error messages.
+*/
+void RPN::FuseStrConcat()
+{
+	// The token computing each value of the simulated stack, or -1
+	std::vector<int> vStack;
+	// Order and position of the operators reading the operands of a concatenation
+	std::vector<std::vector<std::pair<int, int> > > vArgs(m_vRPN.size());
+	std::vector<int> vPos(m_vRPN.size(), 0);    // Position of its leftmost operator
+	std::vector<bool> vFused(m_vRPN.size(), false);
+	bool bFused = false;
+
+	for (int i = 0; i < static_cast<int>(m_vRPN.size()); ++i)
+	{
+		IToken *pTok = m_vRPN[i].Get();
+		switch (pTok->GetCode())
+		{
+		case cmVAL:
+			vStack.push_back(i);
+			break;
+
+		case cmFUNC:
+		case cmOPRT_BIN:
+		case cmOPRT_INFIX:
+		case cmOPRT_POSTFIX:
+		case cmCBC:
+		case cmIC:
+		{
+			ICallback *pFun = pTok->AsICallback();
+			int nArgs = pFun->GetArgsPresent() + ((pTok->GetCode() == cmIC) ? 1 : 0);
+			MUP_VERIFY(nArgs >= 0 && nArgs <= (int)vStack.size());
+
+			if (dynamic_cast<OprtStrAdd*>(pFun) != nullptr)
+			{
+				vPos[i] = pFun->GetExprPos();
+				for (std::size_t k = vStack.size() - nArgs; k < vStack.size(); ++k)
+				{
+					int nArg = vStack[k];
+					if (nArg >= 0 && vArgs[nArg].size() > 0)
+					{
+						vFused[nArg] = bFused = true;
+						vArgs[i].insert(vArgs[i].end(), vArgs[nArg].begin(), vArgs[nArg].end());
+						vPos[i] = std::min(vPos[i], vPos[nArg]);
+					}
+					else
+						vArgs[i].push_back(std::make_pair(i, pFun->GetExprPos()));
+				}
+			}
+
+			vStack.resize(vStack.size() - nArgs);
+			vStack.push_back(i);
+		}
+		break;
+
+		case cmIF:
+		case cmELSE:
+			MUP_VERIFY(vStack.size() > 0);
+			vStack.pop_back();
+			break;
+
+		case cmENDIF:
+			MUP_VERIFY(vStack.size() > 0);
+			vStack.back() = -1;
+			break;
+
+		case cmSCRIPT_NEWLINE:
+			vStack.clear();
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	if (!bFused)
+		return;
+
+	// Rebuild the RPN in order to recompute the required stack size
+	token_vec_type vRPN;
+	vRPN.swap(m_vRPN);
+	m_vRPN.reserve(vRPN.size());
+	m_nStackPos = -1;
+	m_nMaxStackPos = 0;
+	m_nLine = 0;
+
+	for (int i = 0; i < static_cast<int>(vRPN.size()); ++i)
+	{
+		if (vFused[i])
+			continue;
+
+		ptr_tok_type tok = vRPN[i];
+		if (vArgs[i].size() > 2)
+		{
+			OprtStrConcat *pFun = new OprtStrConcat();
+			for (std::size_t k = 0; k < vArgs[i].size(); ++k)
+				pFun->AddArg(vArgs[i][k].first, vArgs[i][k].second);
+
+			pFun->SetNumArgsPresent(static_cast<int>(vArgs[i].size()));
+			pFun->SetExprPos(vPos[i]);
+			tok.Reset(pFun);
+		}
+
+		if (tok->GetCode() == cmSCRIPT_NEWLINE)
+			AddNewline(tok, static_cast<TokenNewline*>(tok.Get())->GetStackOffset());
+		else
+			Add(tok);
+	}
+}
+
+//---------------------------------------------------------------------------
+//
+//  Common subexpression elimination
+//
+//---------------------------------------------------------------------------
+
+namespace
+{
+	/** \brief Summary of a subexpression found while scanning the RPN. */
+	struct SubExpr
+	{
+		int nStart;          ///< Index of the first token of the subexpression
+		int nEnd;            ///< Index of the token computing its value
+		std::size_t nHash;   ///< Hash over all tokens of the subexpression
+		bool bPure;          ///< true if the value may be computed once and reused
+		bool bCall;          ///< true if it contains at least one callback
+		bool bVar;           ///< true if it reads a variable
+	};
+
+	//---------------------------------------------------------------------------
+	void HashCombine(std::size_t &nHash, std::size_t nVal)
+	{
+		nHash ^= nVal + 0x9e3779b9 + (nHash << 6) + (nHash >> 2);
+	}
+
+	//---------------------------------------------------------------------------
+	/** \brief Add a value token to a hash.
+		\return false if the value can't take part in a reused subexpression.
+
+		Variables are identified by the value they are bound to. Matrix
+		constants are not considered.
+	*/
+	bool HashValue(const IValue *pVal, std::size_t &nHash)
+	{
+		if (pVal->IsVariable())
+		{
+			HashCombine(nHash, std::hash<const void*>()(static_cast<const Variable*>(pVal)->GetPtr()));
+			return true;
+		}
+
+		HashCombine(nHash, (std::size_t)pVal->GetType());
+		switch (pVal->GetType())
+		{
+		case 'i':
+		case 'f':
+		case 'c':
+		case 'd':
+		case 't':
+			HashCombine(nHash, std::hash<float_type>()(pVal->GetComplex().real()));
+			HashCombine(nHash, std::hash<float_type>()(pVal->GetComplex().imag()));
+			return true;
+
+		case 'b': HashCombine(nHash, pVal->GetBool());  return true;
+		case 's': HashCombine(nHash, std::hash<string_type>()(pVal->GetString()));  return true;
+		default:  return false;
+		}
+	}
+
+	//---------------------------------------------------------------------------
+	/** \brief Check two tokens of the RPN for equality. */
+	bool IsSameToken(const IToken *pTok1, const IToken *pTok2)
+	{
+		if (pTok1->GetCode() != pTok2->GetCode())
+			return false;
+
+		switch (pTok1->GetCode())
+		{
+		case cmVAL:
+		{
+			const IValue *pVal1 = static_cast<const IValue*>(pTok1),
+				*pVal2 = static_cast<const IValue*>(pTok2);
+
+			if (pVal1->IsVariable() || pVal2->IsVariable())
+			{
+				return pVal1->IsVariable() && pVal2->IsVariable() &&
+					static_cast<const Variable*>(pVal1)->GetPtr() == static_cast<const Variable*>(pVal2)->GetPtr();
+			}
+
+			if (pVal1->GetType() != pVal2->GetType())
+				return false;
+
+			switch (pVal1->GetType())
+			{
+			case 'i':
+			case 'f':
+			case 'c':
+			case 'd':
+			case 't': return pVal1->GetComplex() == pVal2->GetComplex();
+			case 'b': return pVal1->GetBool() == pVal2->GetBool();
+			case 's': return pVal1->GetString() == pVal2->GetString();
+			default:  return false;
+			}
+		}
+
+		case cmFUNC:
+		case cmOPRT_BIN:
+		case cmOPRT_INFIX:
+		case cmOPRT_POSTFIX:
+		case cmCBC:
+		case cmIC:
+			return pTok1->GetIdent() == pTok2->GetIdent() &&
+				static_cast<const ICallback*>(pTok1)->GetArgsPresent() == static_cast<const ICallback*>(pTok2)->GetArgsPresent();
+
+		case cmSTORE:
+		case cmLOAD:
+			return static_cast<const TokenTemp*>(pTok1)->GetSlot() == static_cast<const TokenTemp*>(pTok2)->GetSlot();
+
+		default:
+			// Jump offsets are relative and equal if all other tokens are
+			return true;
+		}
+	}
+
+	//---------------------------------------------------------------------------
+	bool IsLarger(const SubExpr &e1, const SubExpr &e2)
+	{
+		int nLen1 = e1.nEnd - e1.nStart,
+			nLen2 = e2.nEnd - e2.nStart;
+
+		if (nLen1 != nLen2)
+			return nLen1 > nLen2;
+
+		if (e1.nHash != e2.nHash)
+			return e1.nHash < e2.nHash;
+
+		return e1.nStart < e2.nStart;
+	}
+} // anonymous namespace
+
+//---------------------------------------------------------------------------
+/** \brief Replace repeated copies of the largest reusable subexpression.
+	\return true if the RPN was modified.
+
+	The first copy stores its value in a temporary, the following copies are
+	replaced by a single token loading this temporary. Subexpressions containing
+	callbacks not marked as pure are never reused, subexpressions reading variables only
+	if the expression does not modify any variable. A copy is only replaced if
+	no jump can skip the first copy without skipping it as well.
+*/
+bool RPN::EliminateCommonSubexpr()
+{
+	typedef std::pair<int, int> range_type;
+
+	bool bSideEffect = false;
+	std::vector<range_type> vJmp;
+	for (int i = 0; i < static_cast<int>(m_vRPN.size()); ++i)
+	{
+		IToken *pTok = m_vRPN[i].Get();
+		switch (pTok->GetCode())
+		{
+		case cmIF:
+		case cmELSE:
+		case cmJMP_FALSE:
+		case cmJMP_TRUE:
+			vJmp.push_back(range_type(i + 1, i + static_cast<TokenIfThenElse*>(pTok)->GetOffset()));
+			break;
+
+		default:
+			if (pTok->AsICallback() && pTok->IsFlagSet(IToken::flSIDE_EFFECT))
+				bSideEffect = true;
+		}
+	}
+
+	// Simulate the value stack in order to find the extent of each subexpression
+	std::vector<SubExpr> vStack, vExpr;
+	for (int i = 0; i < static_cast<int>(m_vRPN.size()); ++i)
+	{
+		IToken *pTok = m_vRPN[i].Get();
+		SubExpr expr = { i, i, (std::size_t)pTok->GetCode(), true, false, false };
+
+		switch (pTok->GetCode())
+		{
+		case cmVAL:
+			expr.bVar = static_cast<IValue*>(pTok)->IsVariable();
+			expr.bPure = HashValue(static_cast<IValue*>(pTok), expr.nHash);
+			break;
+
+		case cmLOAD:
+			HashCombine(expr.nHash, static_cast<TokenTemp*>(pTok)->GetSlot());
+			break;
+
+		case cmFUNC:
+		case cmOPRT_BIN:
+		case cmOPRT_INFIX:
+		case cmOPRT_POSTFIX:
+		case cmCBC:
+		case cmIC:
+		{
+			ICallback *pFun = pTok->AsICallback();
+
+			// The index operator takes the indexed value as an additional argument
+			// and may return a reference to a variable, it is never reused.
+			int nArgs = pFun->GetArgsPresent() + ((pTok->GetCode() == cmIC) ? 1 : 0);
+			MUP_VERIFY(nArgs >= 0 && nArgs <= (int)vStack.size());
+
+			HashCombine(expr.nHash, std::hash<string_type>()(pFun->GetIdent()));
+			expr.bCall = true;
+			expr.bPure = pTok->GetCode() != cmIC &&
+				pTok->IsFlagSet(IToken::flPURE) &&
+				!pTok->IsFlagSet(IToken::flVOLATILE) &&
+				!pTok->IsFlagSet(IToken::flSIDE_EFFECT);
+
+			for (std::size_t k = vStack.size() - nArgs; k < vStack.size(); ++k)
+			{
+				const SubExpr &arg = vStack[k];
+				HashCombine(expr.nHash, arg.nHash);
+				expr.bPure = expr.bPure && arg.bPure;
+				expr.bVar = expr.bVar || arg.bVar;
+			}
+
+			if (nArgs > 0)
+				expr.nStart = vStack[vStack.size() - nArgs].nStart;
+
+			vStack.resize(vStack.size() - nArgs);
+		}
+		break;
+
+		// Drop the condition and the value of the if branch
+		case cmIF:
+		case cmELSE:
+			MUP_VERIFY(vStack.size() > 0);
+			vStack.pop_back();
+			continue;
+
+		// The result of a conditional is not reused
+		case cmENDIF:
+			MUP_VERIFY(vStack.size() > 0);
+			vStack.pop_back();
+			expr.bPure = false;
+			break;
+
+		case cmSCRIPT_NEWLINE:
+			vStack.clear();
+			continue;
+
+		default:
+			continue;
+		}
+
+		if (expr.bVar && bSideEffect)
+			expr.bPure = false;
+
+		vStack.push_back(expr);
+		if (expr.bPure && expr.bCall)
+			vExpr.push_back(expr);
+	}
+
+	// Identical subexpressions are adjacent after sorting, the largest come first
+	std::sort(vExpr.begin(), vExpr.end(), IsLarger);
+
+	for (std::size_t i = 0; i < vExpr.size(); )
+	{
+		const SubExpr &first = vExpr[i];
+		int nLen = first.nEnd - first.nStart;
+
+		std::vector<SubExpr> vCopy;
+		std::size_t j = i + 1;
+		for (; j < vExpr.size() && vExpr[j].nHash == first.nHash && vExpr[j].nEnd - vExpr[j].nStart == nLen; ++j)
+		{
+			const SubExpr &copy = vExpr[j];
+
+			bool bSame = true;
+			for (int k = 0; bSame && k <= nLen; ++k)
+				bSame = IsSameToken(m_vRPN[first.nStart + k].Get(), m_vRPN[copy.nStart + k].Get());
+
+			// Every jump skipping the first copy must skip this copy as well
+			for (std::size_t k = 0; bSame && k < vJmp.size(); ++k)
+			{
+				const range_type &jmp = vJmp[k];
+				if (jmp.first <= first.nEnd && first.nEnd <= jmp.second)
+					bSame = jmp.first <= copy.nStart && copy.nStart <= jmp.second;
+			}
+
+			if (bSame)
+				vCopy.push_back(copy);
+		}
+
+		if (vCopy.empty())
+		{
+			i = j;
+			continue;
+		}
+
+		// Store the first copy and load the others
+		int nSlot = m_nNumTemp++;
+		token_vec_type vRPN;
+		vRPN.reserve(m_vRPN.size());
+
+		std::size_t nCopy = 0;
+		for (int k = 0; k < static_cast<int>(m_vRPN.size()); ++k)
+		{
+			if (nCopy < vCopy.size() && k == vCopy[nCopy].nStart)
+			{
+				ptr_tok_type tok(new TokenTemp(cmLOAD, nSlot));
+				tok->SetExprPos(m_vRPN[k]->GetExprPos());
+				vRPN.push_back(tok);
+
+				k = vCopy[nCopy++].nEnd;
+				continue;
+			}
+
+			vRPN.push_back(m_vRPN[k]);
+			if (k == first.nEnd)
+			{
+				ptr_tok_type tok(new TokenTemp(cmSTORE, nSlot));
+				tok->SetExprPos(m_vRPN[k]->GetExprPos());
+				vRPN.push_back(tok);
+			}
+		}
+
+		m_vRPN.swap(vRPN);
+		return true;
+	}
+
+	return false;
+}
+
 //---------------------------------------------------------------------------
 void  RPN::EnableOptimizer(bool bStat)
 {
@@ -169,15 +646,30 @@ int RPN::GetRequiredStackSize() const
 	return m_nMaxStackPos + 1;
 }
 
+//---------------------------------------------------------------------------
+/** \brief Returns the number of temporaries needed for evaluating the RPN. */
+int RPN::GetNumTemp() const
+{
+	return m_nNumTemp;
+}
+
 //---------------------------------------------------------------------------
 void RPN::AsciiDump() const
 {
-	console() << "Number of tokens: " << m_vRPN.size() << "\n";
-	console() << "MaxStackPos:       " << m_nMaxStackPos << "\n";
+	AsciiDump(console());
+}
+
+//---------------------------------------------------------------------------
+/** \brief Writes the tokens of the reverse polish notation to a stream. */
+void RPN::AsciiDump(std::basic_ostream<char_type> &os) const
+{
+	os << "Number of tokens: " << m_vRPN.size() << "\n";
+	os << "MaxStackPos:       " << m_nMaxStackPos << "\n";
+	os << "Temporaries:       " << m_nNumTemp << "\n";
 	for (std::size_t i = 0; i < m_vRPN.size(); ++i)
 	{
 		ptr_tok_type pTok = m_vRPN[i];
-		console() << std::setw(2) << i << " : "
+		os << std::setw(2) << i << " : "
 			<< std::setw(2) << pTok->GetExprPos() << " : "
 			<< pTok->AsciiDump() << std::endl;
 	}
@@ -55,19 +55,26 @@ MUP_NAMESPACE_START
     void Reset();
     void Finalize();
     void AsciiDump() const;
+    void AsciiDump(std::basic_ostream<char_type> &os) const;
 
     const token_vec_type& GetData() const;
     std::size_t GetSize() const;
 
     int GetRequiredStackSize() const;
+    int GetNumTemp() const;
     void EnableOptimizer(bool bStat);
 
   private:
 
+    void SetJumpOffsets();
+    void FuseStrConcat();
+    bool EliminateCommonSubexpr();
+
     token_vec_type m_vRPN;
     int m_nStackPos;
     int m_nLine;
     int m_nMaxStackPos;
+    int m_nNumTemp;          ///< Number of temporaries used for common subexpressions
     bool m_bEnableOptimizer;
   };
 
@@ -0,0 +1,152 @@
+/** \file
+    \brief Implementation of reduction kernels over arrays of numbers.
+
+<pre>
+               __________                                 ____  ___
+    _____  __ _\______   \_____ _______  ______ __________\   \/  /
+   /     \|  |  \     ___/\__  \\_  __ \/  ___// __ \_  __ \     / 
+  |  Y Y  \  |  /    |     / __ \|  | \/\___ \\  ___/|  | \/     \ 
+  |__|_|  /____/|____|    (____  /__|  /____  >\___  >__| /___/\  \
+        \/                     \/           \/     \/           \_/
+                                       Copyright (C) 2016, Ingo Berg
+                                       All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without 
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice, 
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright notice, 
+     this list of conditions and the following disclaimer in the documentation 
+     and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. 
+  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT 
+  NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+  POSSIBILITY OF SUCH DAMAGE.
+  </pre>
+*/
+
+
+#include "mpReduce.h"
+
+//--- Standard includes ----------------------------------------------------
+#include <algorithm>
+#include <cmath>
+
+
+MUP_NAMESPACE_START
+
+namespace
+{
+  /** \brief Number of independent partial results kept by the kernels.
+
+    Partial results that do not depend on each other allow the compiler to
+    keep them in one vector register.
+  */
+  const int LANES = 4;
+
+  //------------------------------------------------------------------------------
+  /** \brief Adds a value to a sum and collects the rounding error in comp.
+
+    This is the Kahan-Babuska (Neumaier) variant of compensated summation, it
+    stays exact when the value is larger than the sum.
+  */
+  inline void AddCompensated(float_type &sum, float_type &comp, float_type val)
+  {
+    float_type t = sum + val;
+    comp += (std::fabs(sum) >= std::fabs(val)) ? (sum - t) + val : (val - t) + sum;
+    sum = t;
+  }
+} // anonymous namespace
+
+  //------------------------------------------------------------------------------
+  /** \brief Returns fInit plus the sum of an array of numbers.
+
+    The numbers are added one after the other. Floating point addition is not
+    associative, so splitting the sum into independent partial sums would change
+    results like 1e16 + 1 - 1e16 + 1.
+  */
+  float_type SumOf(const float_type *pVal, int nSize, float_type fInit)
+  {
+    float_type sum = fInit;
+    for (int i = 0; i < nSize; ++i)
+      sum += pVal[i];
+
+    return sum;
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Adds an array of numbers to a sum using compensated summation.
+      \param fSum [in, out] The sum.
+      \param fComp [in, out] The rounding error collected so far, the result is 
+                   fSum + fComp.
+
+    The error of the result does not grow with the size of the array, but the
+    kernel needs about four times the operations of SumOf.
+  */
+  void CompensatedSumOf(const float_type *pVal, int nSize, float_type &fSum, float_type &fComp)
+  {
+    float_type s[LANES] = {0, 0, 0, 0},
+               c[LANES] = {0, 0, 0, 0};
+
+    int i = 0;
+    for (; i + LANES <= nSize; i += LANES)
+    {
+      for (int k = 0; k < LANES; ++k)
+        AddCompensated(s[k], c[k], pVal[i + k]);
+    }
+
+    for (; i < nSize; ++i)
+      AddCompensated(s[0], c[0], pVal[i]);
+
+    for (int k = 0; k < LANES; ++k)
+    {
+      AddCompensated(fSum, fComp, s[k]);
+      fComp += c[k];
+    }
+  }
+
+  //------------------------------------------------------------------------------
+  float_type MinOf(const float_type *pVal, int nSize, float_type fInit)
+  {
+    float_type m[LANES] = {fInit, fInit, fInit, fInit};
+
+    int i = 0;
+    for (; i + LANES <= nSize; i += LANES)
+    {
+      for (int k = 0; k < LANES; ++k)
+        m[k] = std::min(m[k], pVal[i + k]);
+    }
+
+    for (; i < nSize; ++i)
+      m[0] = std::min(m[0], pVal[i]);
+
+    return std::min(std::min(m[0], m[1]), std::min(m[2], m[3]));
+  }
+
+  //------------------------------------------------------------------------------
+  float_type MaxOf(const float_type *pVal, int nSize, float_type fInit)
+  {
+    float_type m[LANES] = {fInit, fInit, fInit, fInit};
+
+    int i = 0;
+    for (; i + LANES <= nSize; i += LANES)
+    {
+      for (int k = 0; k < LANES; ++k)
+        m[k] = std::max(m[k], pVal[i + k]);
+    }
+
+    for (; i < nSize; ++i)
+      m[0] = std::max(m[0], pVal[i]);
+
+    return std::max(std::max(m[0], m[1]), std::max(m[2], m[3]));
+  }
+
+MUP_NAMESPACE_END
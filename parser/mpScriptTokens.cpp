@@ -70,5 +70,36 @@ MUP_NAMESPACE_START
     ss << _T("]");
     return ss.str();
   }
+
+  //---------------------------------------------------------------------------
+  TokenTemp::TokenTemp(ECmdCode eCode, int nSlot)
+    :IToken(eCode, g_sCmdCode[ eCode ])
+    ,m_nSlot(nSlot)
+  {}
+
+  //---------------------------------------------------------------------------
+  IToken* TokenTemp::Clone() const
+  {
+    return new TokenTemp(*this);
+  }
+
+  //---------------------------------------------------------------------------
+  int TokenTemp::GetSlot() const
+  {
+    return m_nSlot;
+  }
+
+  //---------------------------------------------------------------------------
+  string_type TokenTemp::AsciiDump() const
+  {
+    stringstream_type ss;
+
+    ss << g_sCmdCode[ GetCode() ];
+    ss << _T(" [addr=0x") << std::hex << this << std::dec;
+    ss << _T("; pos=") << GetExprPos();
+    ss << _T("; slot=") << m_nSlot;
+    ss << _T("]");
+    return ss.str();
+  }
   
 MUP_NAMESPACE_END
@@ -63,6 +63,32 @@ MUP_NAMESPACE_START
       int m_nOffset;
   };
 
+  //---------------------------------------------------------------------------
+  /** \brief A token for storing or loading a temporary value.
+
+    Tokens of this type are created by the RPN optimizer. A cmSTORE token copies
+    the value on top of the stack into a temporary slot, a cmLOAD token pushes
+    the value of that slot back onto the stack.
+  */
+  class TokenTemp : public IToken
+  {
+  public:
+
+      TokenTemp(ECmdCode eCode, int nSlot);
+
+      //---------------------------------------------
+      // IToken interface
+      //---------------------------------------------
+
+      virtual IToken* Clone() const;
+      virtual string_type AsciiDump() const;
+
+      int GetSlot() const;
+
+  private:
+      int m_nSlot;
+  };
+
 MUP_NAMESPACE_END
 
 #endif
@@ -0,0 +1,85 @@
+/** \file
+    \brief Implementation of the table of interned string constants.
+
+<pre>
+               __________                                 ____  ___
+    _____  __ _\______   \_____ _______  ______ __________\   \/  /
+   /     \|  |  \     ___/\__  \\_  __ \/  ___// __ \_  __ \     / 
+  |  Y Y  \  |  /    |     / __ \|  | \/\___ \\  ___/|  | \/     \ 
+  |__|_|  /____/|____|    (____  /__|  /____  >\___  >__| /___/\  \
+        \/                     \/           \/     \/           \_/
+                                       Copyright (C) 2016, Ingo Berg
+                                       All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without 
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice, 
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright notice, 
+     this list of conditions and the following disclaimer in the documentation 
+     and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. 
+  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT 
+  NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+  POSSIBILITY OF SUCH DAMAGE.
+  </pre>
+*/
+
+
+#include "mpStrIntern.h"
+
+//--- Standard includes ----------------------------------------------------
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+
+MUP_NAMESPACE_START
+
+  //------------------------------------------------------------------------------
+  str_slice_type InternString(const string_type &a_sVal)
+  {
+    typedef std::unordered_map<string_type, std::weak_ptr<const string_type> > table_type;
+
+    // The table does not keep its strings alive. A text gets a new buffer only
+    // once no value uses the old one, so live buffers are unique.
+    static std::mutex s_mtx;
+    static table_type s_table;
+    static std::size_t s_nPurge = 64;
+
+    std::lock_guard<std::mutex> lock(s_mtx);
+
+    std::weak_ptr<const string_type> &entry = s_table[a_sVal];
+    std::shared_ptr<const string_type> pBuf = entry.lock();
+    if (!pBuf)
+    {
+      pBuf = std::make_shared<const string_type>(a_sVal);
+      entry = pBuf;
+    }
+
+    // Drop the entries of unused strings whenever the table has doubled in size
+    if (s_table.size() >= s_nPurge)
+    {
+      for (table_type::iterator it = s_table.begin(); it != s_table.end(); )
+      {
+        if (it->second.expired())
+          it = s_table.erase(it);
+        else
+          ++it;
+      }
+
+      s_nPurge = std::max<std::size_t>(64, 2 * s_table.size());
+    }
+
+    return str_slice_type(pBuf, 0, pBuf->size(), true);
+  }
+
+MUP_NAMESPACE_END
@@ -88,6 +88,8 @@ void TokenReader::Assign(const TokenReader &obj)
 	m_nNumIfElse = obj.m_nNumIfElse;
 	m_nSynFlags = obj.m_nSynFlags;
 	m_UsedVar = obj.m_UsedVar;
+	m_UsedFun = obj.m_UsedFun;
+	m_UsedConst = obj.m_UsedConst;
 	m_pVarDef = obj.m_pVarDef;
 	m_pPostOprtDef = obj.m_pPostOprtDef;
 	m_pInfixOprtDef = obj.m_pInfixOprtDef;
@@ -95,7 +97,10 @@ void TokenReader::Assign(const TokenReader &obj)
 	m_pFunDef = obj.m_pFunDef;
 	m_pConstDef = obj.m_pConstDef;
 	m_pDynVarShadowValues = obj.m_pDynVarShadowValues;
-	m_vTokens = obj.m_vTokens;
+	// Literals are bound to the value cache of the parser they were read by.
+	// The tokens are not shared, the expression will be read again.
+	m_vTokens.clear();
+	m_nNextTok = 0;
 
 	// Reader klassen klonen
 	DeleteValReader();
@@ -125,6 +130,7 @@ TokenReader::TokenReader(ParserXBase *a_pParent)
 	, m_nNumIfElse(0)
 	, m_nSynFlags(0)
 	, m_vTokens()
+	, m_nNextTok(0)
 	, m_eLastTokCode(cmUNKNOWN)
 	, m_pFunDef(nullptr)
 	, m_pOprtDef(nullptr)
@@ -135,6 +141,8 @@ TokenReader::TokenReader(ParserXBase *a_pParent)
 	, m_pVarDef(nullptr)
 	, m_vValueReader()
 	, m_UsedVar()
+	, m_UsedFun()
+	, m_UsedConst()
 	, m_fZero(0)
 {
 	assert(m_pParser);
@@ -225,6 +233,20 @@ const var_maptype& TokenReader::GetUsedVar() const
 	return m_UsedVar;
 }
 
+//---------------------------------------------------------------------------
+/** \brief Return a map containing the used functions only. */
+const fun_maptype& TokenReader::GetUsedFun() const
+{
+	return m_UsedFun;
+}
+
+//---------------------------------------------------------------------------
+/** \brief Return a map containing the used constants only. */
+const val_maptype& TokenReader::GetUsedConst() const
+{
+	return m_UsedConst;
+}
+
 //---------------------------------------------------------------------------
 /** \brief Initialize the token Reader.
 
@@ -255,8 +277,25 @@ void TokenReader::ReInit()
 	m_nNumIfElse = 0;
 	m_nSynFlags = noOPT | noBC | noCBC | noPFX | noCOMMA | noIO | noIC | noIF | noELSE;
 	m_UsedVar.clear();
+	m_UsedFun.clear();
+	m_UsedConst.clear();
 	m_eLastTokCode = cmUNKNOWN;
 	m_vTokens.clear();
+	m_nNextTok = 0;
+}
+
+//---------------------------------------------------------------------------
+/** \brief Hand out the tokens read so far once more.
+	\post #m_nNextTok==0
+	\throw nothrow
+
+	The tokens and the lists of used variables, functions and constants are kept.
+	Subsequent calls to ReadNextToken return the stored tokens in their original
+	order before the reader continues with the expression string.
+	*/
+void TokenReader::Rewind()
+{
+	m_nNextTok = 0;
 }
 
 //---------------------------------------------------------------------------
@@ -265,6 +304,7 @@ const ptr_tok_type& TokenReader::Store(const ptr_tok_type &t, int token_pos)
 	m_eLastTokCode = t->GetCode();
 	t->SetExprPos(token_pos);
 	m_vTokens.push_back(t);
+	m_nNextTok = (int)m_vTokens.size();
 	return t;
 }
 
@@ -301,6 +341,10 @@ ptr_tok_type TokenReader::ReadNextToken()
 {
 	assert(m_pParser);
 
+	// Replay tokens stored by a previous pass over the expression
+	if (m_nNextTok < (int)m_vTokens.size())
+		return m_vTokens[m_nNextTok++];
+
 	SkipCommentsAndWhitespaces();
 
 	int token_pos = m_nPos;
@@ -719,6 +763,7 @@ bool TokenReader::IsFunTok(ptr_tok_type &a_Tok)
 			throw ecUNEXPECTED_FUN;
 
 		m_nSynFlags = sfALLOW_NONE ^ noBO;
+		m_UsedFun[item->first] = item->second;  // Add function to used-fun-list
 		return true;
 	}
 	catch (EErrorCodes e)
@@ -864,7 +909,6 @@ bool TokenReader::IsValTok(ptr_tok_type &a_Tok)
 	if (m_vValueReader.size() == 0)
 		return false;
 
-	stringstream_type stream(m_sExpr.c_str() + m_nPos);
 	string_type sTok;
 
 	try
@@ -883,7 +927,12 @@ bool TokenReader::IsValTok(ptr_tok_type &a_Tok)
 					throw ecUNEXPECTED_VAL;
 
 				m_nSynFlags = noVAL | noVAR | noFUN | noBO | noIFX | noIO;
-				a_Tok = ptr_tok_type(val.Clone());
+
+				// Take the literal from the value cache of the parser, it returns
+				// there once the expression is discarded.
+				Value *pVal = m_pParser->m_pCache->CreateFromCache();
+				*pVal = val;
+				a_Tok = ptr_tok_type(pVal);
 				a_Tok->SetIdent(string_type(sTok.begin(), sTok.begin() + (m_nPos - iStart)));
 				return true;
 			}
@@ -947,6 +996,7 @@ bool TokenReader::IsVarOrConstTok(ptr_tok_type &a_Tok)
 			m_nSynFlags = noVAL | noVAR | noFUN | noBO | noIFX | noIO;
 			a_Tok = ptr_tok_type(item->second->Clone());
 			a_Tok->SetIdent(sTok);
+			m_UsedConst[item->first] = item->second;  // Add constant to used-const-list
 			return true;
 		}
 	}
@@ -98,6 +98,7 @@ MUP_NAMESPACE_START
     int  m_nSynFlags;        ///< Flags to controll the syntax flow
 
     token_buf_type m_vTokens;
+    int  m_nNextTok;         ///< Index of the next stored token handed out by ReadNextToken
     ECmdCode m_eLastTokCode;
 
     mutable fun_maptype  *m_pFunDef;
@@ -110,6 +111,8 @@ MUP_NAMESPACE_START
 
     readervec_type m_vValueReader;  ///< Value token identification function
     var_maptype m_UsedVar;
+    fun_maptype m_UsedFun;
+    val_maptype m_UsedConst;
     float_type m_fZero;             ///< Dummy value of zero, referenced by undefined variables
 
   public:
@@ -123,10 +126,13 @@ MUP_NAMESPACE_START
     int GetPos() const;
     const string_type& GetExpr() const;
     const var_maptype& GetUsedVar() const;
+    const fun_maptype& GetUsedFun() const;
+    const val_maptype& GetUsedConst() const;
     const token_buf_type& GetTokens() const;
     void SetExpr(const string_type &a_sExpr);
 
     void ReInit();
+    void Rewind();
     ptr_tok_type ReadNextToken();
   }; // class TokenReader
 
@@ -0,0 +1,69 @@
+/** \file
+    \brief Definition of the static user space tracepoints of the parser.
+
+<pre>
+               __________                                 ____  ___
+    _____  __ _\______   \_____ _______  ______ __________\   \/  /
+   /     \|  |  \     ___/\__  \\_  __ \/  ___// __ \_  __ \     / 
+  |  Y Y  \  |  /    |     / __ \|  | \/\___ \\  ___/|  | \/     \ 
+  |__|_|  /____/|____|    (____  /__|  /____  >\___  >__| /___/\  \
+        \/                     \/           \/     \/           \_/
+                                       Copyright (C) 2016, Ingo Berg
+                                       All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without 
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice, 
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright notice, 
+     this list of conditions and the following disclaimer in the documentation 
+     and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND 
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED 
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. 
+  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, 
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT 
+  NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, 
+  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+  POSSIBILITY OF SUCH DAMAGE.
+  </pre>
+*/
+
+
+#ifndef MUP_TRACE_H
+#define MUP_TRACE_H
+
+/** \brief Macros placing USDT probes of the provider "muparserx".
+
+  Probes are compiled in only if MUP_ENABLE_USDT is defined, they need the 
+  sys/sdt.h header of SystemTap. A probe not attached to is a single nop 
+  instruction, perf and bpftrace attach to them at runtime:
+
+  <pre>
+  bpftrace -e 'usdt:./example:muparserx:callback_entry { @[str(arg0)] = count(); }'
+  </pre>
+
+  Probes and their arguments:
+  - set_expr(expr)
+  - compile_begin(expr), compile_end(expr, number of RPN tokens)
+  - eval_begin(expr), eval_end(expr)
+  - callback_entry(ident), callback_exit(ident)
+  - error(error code, message)
+
+  Strings are passed as pointers to their characters.
+*/
+#if defined(MUP_ENABLE_USDT)
+  #include <sys/sdt.h>
+
+  #define MUP_TRACE1(NAME, A1)      DTRACE_PROBE1(muparserx, NAME, A1)
+  #define MUP_TRACE2(NAME, A1, A2)  DTRACE_PROBE2(muparserx, NAME, A1, A2)
+#else
+  #define MUP_TRACE1(NAME, A1)
+  #define MUP_TRACE2(NAME, A1, A2)
+#endif
+
+#endif
@@ -42,6 +42,7 @@
 #include <vector>
 #include <map>
 #include <complex>
+#include <memory>
 
 //--- muParserX framework ---------------------------------------------------
 #include "suSortPred.h"  // We need the string utils sorting predicates
@@ -102,6 +103,20 @@ typedef MUP_INT_TYPE int_type;
 /** \brief The basic type used for representing complex numbers. */
 typedef std::complex<float_type> cmplx_type;
 
+/** \brief Parser datatype for dates and date times.
+
+      Dates count the days, date times the seconds since 1970-01-01T00:00. Both
+      refer to the calendar date and wall clock time, time zones are not considered.
+*/
+struct date_type
+{
+  date_type() : Val(0), IsTime(false) {}
+  date_type(float_type a_fVal, bool a_bTime) : Val(a_fVal), IsTime(a_bTime) {}
+
+  float_type Val;  ///< Days or seconds since 1970-01-01
+  bool IsTime;     ///< True for date times
+};
+
 /** \brief Parser boolean datatype.
 
       This must be bool! The only reason for this typedef is that I need the name bool_type
@@ -118,6 +133,26 @@ typedef MUP_STRING_TYPE string_type;
 /** \brief Character type of the parser. */
 typedef string_type::value_type char_type;
 
+/** \brief Parser datatype for substrings.
+
+      An immutable part of a string buffer. All slices taken from a buffer share it,
+      values use them to share the buffers of interned strings.
+*/
+struct str_slice_type
+{
+  str_slice_type() : Buf(), Pos(0), Len(0), Interned(false) {}
+  str_slice_type(const std::shared_ptr<const string_type> &a_pBuf, std::size_t a_nPos, std::size_t a_nLen, bool a_bInterned = false)
+    : Buf(a_pBuf), Pos(a_nPos), Len(a_nLen), Interned(a_bInterned) {}
+
+  const char_type* Data() const { return Buf->data() + Pos; }
+  bool IsWhole() const { return Pos == 0 && Len == Buf->size(); }
+
+  std::shared_ptr<const string_type> Buf;  ///< The shared buffer
+  std::size_t Pos;                         ///< Offset of the first character in the buffer
+  std::size_t Len;                         ///< Number of characters
+  bool Interned;                           ///< True if Buf is the interned buffer of this text, see InternString
+};
+
 typedef std::basic_stringstream<char_type, std::char_traits<char_type>, std::allocator<char_type> > stringstream_type;
 
 /** \brief Type of a vector holding pointers to value reader objects. */
@@ -165,29 +200,33 @@ enum ECmdCode
     cmELSE              =  8,  ///< Ternary if then else operator
     cmENDIF             =  9,  ///< Ternary if then else operator
     cmJMP               = 10,  ///< Reserved for future use
-    cmVAL               = 11,  ///< value item
-    cmFUNC              = 12,  ///< Code for a function item
-    cmOPRT_BIN          = 13,  ///< Binary operator
-    cmOPRT_INFIX        = 14,  ///< Infix operator
-    cmOPRT_POSTFIX      = 15,  ///< Postfix operator
-    cmEOE               = 16,  ///< End of expression
+    cmJMP_FALSE         = 11,  ///< Short-circuit jump of the logical and operator
+    cmJMP_TRUE          = 12,  ///< Short-circuit jump of the logical or operator
+    cmSTORE             = 13,  ///< Store the value on top of the stack in a temporary
+    cmLOAD              = 14,  ///< Push the value of a temporary onto the stack
+    cmVAL               = 15,  ///< value item
+    cmFUNC              = 16,  ///< Code for a function item
+    cmOPRT_BIN          = 17,  ///< Binary operator
+    cmOPRT_INFIX        = 18,  ///< Infix operator
+    cmOPRT_POSTFIX      = 19,  ///< Postfix operator
+    cmEOE               = 20,  ///< End of expression
 
     // The following codes are reserved in case i will ever turn this
     // into a scripting language
-    cmSCRIPT_NEWLINE    = 17,  ///< Newline
-    cmSCRIPT_COMMENT    = 18,
-    cmSCRIPT_WHILE      = 19,  ///< Reserved for future use
-    cmSCRIPT_GOTO       = 20,  ///< Reserved for future use
-    cmSCRIPT_LABEL      = 21,  ///< Reserved for future use
-    cmSCRIPT_FOR        = 22,  ///< Reserved for future use
-    cmSCRIPT_IF         = 23,  ///< Reserved for future use
-    cmSCRIPT_ELSE       = 24,  ///< Reserved for future use
-    cmSCRIPT_ELSEIF     = 25,  ///< Reserved for future use
-    cmSCRIPT_ENDIF      = 26,  ///< Reserved for future use
-    cmSCRIPT_FUNCTION   = 27,  ///< Reserved for future use
+    cmSCRIPT_NEWLINE    = 21,  ///< Newline
+    cmSCRIPT_COMMENT    = 22,
+    cmSCRIPT_WHILE      = 23,  ///< Reserved for future use
+    cmSCRIPT_GOTO       = 24,  ///< Reserved for future use
+    cmSCRIPT_LABEL      = 25,  ///< Reserved for future use
+    cmSCRIPT_FOR        = 26,  ///< Reserved for future use
+    cmSCRIPT_IF         = 27,  ///< Reserved for future use
+    cmSCRIPT_ELSE       = 28,  ///< Reserved for future use
+    cmSCRIPT_ELSEIF     = 29,  ///< Reserved for future use
+    cmSCRIPT_ENDIF      = 30,  ///< Reserved for future use
+    cmSCRIPT_FUNCTION   = 31,  ///< Reserved for future use
 
     // misc codes
-    cmUNKNOWN           = 28,  ///< uninitialized item
+    cmUNKNOWN           = 32,  ///< uninitialized item
     cmCOUNT                    ///< Dummy entry for counting the enum values
 }; // ECmdCode
 
@@ -375,6 +414,11 @@ enum EErrorCodes
     // time related errors
     ecINVALID_TIME_FORMAT       = 60, ///< Invalid time format
 
+    // formula graph errors
+    ecCIRCULAR_DEPENDENCY       = 61, ///< A formula depends on its own result
+    ecUNDEFINED_NAME            = 62, ///< Neither an input nor a formula of this name exists
+    ecNOT_AN_INPUT              = 63, ///< A formula can't be set like an input
+
     // The last two are special entries
     ecCOUNT,                          ///< This is no error code, It just stores the total number of error codes
     ecUNDEFINED                 = -1  ///< Undefined message, placeholder to detect unassigned error messages
@@ -34,6 +34,8 @@
     */
 #include "mpValReader.h"
 #include "mpError.h"
+#include "mpDate.h"
+#include "mpStrIntern.h"
 
 
 MUP_NAMESPACE_START
@@ -332,7 +334,7 @@ bool StrValReader::IsValue(const char_type *a_pszExpr, int &a_iPos, Value &a_Val
     if (szExpr[0] != '"')
         return false;
 
-    a_Val = Unescape(a_pszExpr, ++a_iPos);
+    a_Val = InternString(Unescape(a_pszExpr, ++a_iPos));
     return true;
 }
 
@@ -344,4 +346,50 @@ IValueReader* StrValReader::Clone(TokenReader *pTokenReader) const
 
     return pReader;
 }
+
+//------------------------------------------------------------------------------
+//
+//  Reader for date values
+//
+//------------------------------------------------------------------------------
+
+DateValReader::DateValReader()
+    :IValueReader()
+{}
+
+//------------------------------------------------------------------------------
+DateValReader::~DateValReader()
+{}
+
+//------------------------------------------------------------------------------
+bool DateValReader::IsValue(const char_type *a_pszExpr, int &a_iPos, Value &a_Val)
+{
+    const char_type *szExpr = a_pszExpr + a_iPos;
+    if (szExpr[0] != 'd' || szExpr[1] != '"')
+        return false;
+
+    int nEnd = 2;
+    while (szExpr[nEnd] != 0 && szExpr[nEnd] != '"')
+        ++nEnd;
+
+    if (szExpr[nEnd] == 0)
+        throw ParserError(ErrorContext(ecUNTERMINATED_STRING, a_iPos + nEnd));
+
+    date_type date;
+    if (!ParseDate(string_type(szExpr + 2, szExpr + nEnd), date))
+        throw ParserError(ErrorContext(ecINVALID_DATETIME_FORMAT, a_iPos));
+
+    a_Val = date;
+    a_iPos += nEnd + 1;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+IValueReader* DateValReader::Clone(TokenReader *pTokenReader) const
+{
+    IValueReader *pReader = new DateValReader(*this);
+    pReader->SetParent(pTokenReader);
+
+    return pReader;
+}
 MUP_NAMESPACE_END
@@ -133,6 +133,27 @@ MUP_NAMESPACE_START
       string_type Unescape(const char_type *szExpr, int &len);
   };
 
+  //------------------------------------------------------------------------------
+  //
+  //  Reader for date values
+  //
+  //------------------------------------------------------------------------------
+
+  /** \brief A class for reading date literals from an expression string.
+      \ingroup valreader
+
+    Date literals look like strings prefixed by a "d", i.e. d"2019-01-01" or
+    d"2019-01-01T08:30". They are read once when the expression is parsed.
+  */
+  class DateValReader : public IValueReader
+  {
+  public:    
+      DateValReader();
+      virtual ~DateValReader();
+      virtual bool IsValue(const char_type *a_szExpr, int &a_iPos, Value &a_fVal) override;
+      virtual IValueReader* Clone(TokenReader *pTokenReader) const override;
+  };
+
 MUP_NAMESPACE_END
 
 #endif
@@ -33,12 +33,16 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "mpValue.h"
 #include "mpError.h"
 #include "mpValueCache.h"
+#include "mpDate.h"
 #include <iomanip>
 #include <limits>
+#include <utility>
 
 
 MUP_NAMESPACE_START
 
+EFormatMode Value::s_eFormatMode = fmCOMPAT;
+
 //------------------------------------------------------------------------------
 /** \brief Construct an empty value object of a given type.
     \param cType The type of the value to construct (default='v').
@@ -166,6 +170,17 @@ Value::Value(const matrix_type &val)
     , m_pCache(nullptr)
 {}
 
+//---------------------------------------------------------------------------
+Value::Value(const date_type &val)
+    :IValue(cmVAL)
+    , m_val(val.Val, 0)
+    , m_psVal(new string_type(FormatDate(val)))
+    , m_pvVal(nullptr)
+    , m_cType((val.IsTime) ? 't' : 'd')
+    , m_iFlags(flNONE)
+    , m_pCache(nullptr)
+{}
+
 //---------------------------------------------------------------------------
 Value::Value(const Value &a_Val)
     :IValue(cmVAL)
@@ -196,10 +211,16 @@ Value::Value(const IValue &a_Val)
     case 'c': m_val = cmplx_type(a_Val.GetFloat(), a_Val.GetImag());
         break;
 
-    case 's': if (!m_psVal)
-        m_psVal = new string_type(a_Val.GetString());
+    case 'd':
+    case 't': m_val = cmplx_type(a_Val.GetDate().Val, 0);
+              m_psVal = new string_type(FormatDate(a_Val.GetDate()));
+        break;
+
+    // An interned string shares its buffer
+    case 's': if (a_Val.IsInterned())
+                  m_sliceVal = a_Val.GetSlice();
               else
-                  *m_psVal = a_Val.GetString();
+                  m_psVal = new string_type(a_Val.GetString());
         break;
 
     case 'm': if (!m_pvVal)
@@ -262,6 +283,28 @@ IValue& Value::At(int nRow, int nCol)
         throw ParserError(ErrorContext(ecINDEX_OUT_OF_BOUNDS));
 }
 
+//---------------------------------------------------------------------------
+/** \brief Return the matrix element at row col for reading.
+
+  Unlike the non-const version this does not store the element in a sparse matrix.
+*/
+const IValue& Value::At(int nRow, int nCol) const
+{
+    if (IsMatrix())
+    {
+        if (nRow >= m_pvVal->GetRows() || nCol >= m_pvVal->GetCols() || nRow < 0 || nCol < 0)
+            throw ParserError(ErrorContext(ecINDEX_OUT_OF_BOUNDS, -1, GetIdent()));
+
+        return static_cast<const matrix_type*>(m_pvVal)->At(nRow, nCol);
+    }
+    else if (nRow == 0 && nCol == 0)
+    {
+        return *this;
+    }
+    else
+        throw ParserError(ErrorContext(ecINDEX_OUT_OF_BOUNDS));
+}
+
 //---------------------------------------------------------------------------
 Value::~Value()
 {
@@ -292,22 +335,23 @@ void Value::Assign(const Value &ref)
     m_cType = ref.m_cType;
     m_iFlags = ref.m_iFlags;
 
-    // allocate room for a string
-    if (ref.m_psVal)
+    // allocate room for a string or the text of a date, a slice shares the 
+    // buffer of ref.
+    m_sliceVal = ref.m_sliceVal;
+    if (ref.m_psVal && !ref.m_sliceVal.Buf && (ref.m_cType == 's' || ref.IsDate()))
     {
         if (!m_psVal)
             m_psVal = new string_type(*ref.m_psVal);
         else
             *m_psVal = *ref.m_psVal;
     }
-    else
+    else if (!ref.m_sliceVal.Buf && m_psVal)
     {
-        delete m_psVal;
-        m_psVal = nullptr;
+        m_psVal->clear();
     }
 
     // allocate room for a vector
-    if (ref.m_pvVal)
+    if (ref.m_cType == 'm')
     {
         if (m_pvVal == nullptr)
             m_pvVal = new matrix_type(*ref.m_pvVal);
@@ -316,8 +360,7 @@ void Value::Assign(const Value &ref)
     }
     else
     {
-        delete m_pvVal;
-        m_pvVal = nullptr;
+        ClearMatrix();
     }
 
     // Do NOT access ref beyound this point! If you do, "unboxing" of
@@ -329,16 +372,54 @@ void Value::Assign(const Value &ref)
     // moment you delete m_pvVal!
 }
 
+//---------------------------------------------------------------------------
+/** \brief Empty the string of this value. 
+
+  The buffer is kept as room for later strings, so that values recycled by
+  the value cache do not allocate their strings again. Buffers larger than
+  MUP_VALUE_MAX_STRING_CAPACITY are released.
+*/
+void Value::ClearString()
+{
+    if (m_psVal && m_psVal->capacity() > MUP_VALUE_MAX_STRING_CAPACITY)
+    {
+        delete m_psVal;
+        m_psVal = nullptr;
+    }
+    else if (m_psVal)
+    {
+        m_psVal->clear();
+    }
+
+    m_sliceVal = str_slice_type();
+}
+
+//---------------------------------------------------------------------------
+/** \brief Empty the matrix of this value.
+
+  The storage of up to MUP_VALUE_MAX_MATRIX_CAPACITY elements is kept, larger
+  storage is released.
+*/
+void Value::ClearMatrix()
+{
+    if (m_pvVal && m_pvVal->GetCapacity() > MUP_VALUE_MAX_MATRIX_CAPACITY)
+    {
+        delete m_pvVal;
+        m_pvVal = nullptr;
+    }
+    else if (m_pvVal)
+    {
+        *m_pvVal = Value(0.0);
+    }
+}
+
 //---------------------------------------------------------------------------
 void Value::Reset()
 {
     m_val = cmplx_type(0, 0);
 
-    delete m_psVal;
-    m_psVal = nullptr;
-
-    delete m_pvVal;
-    m_pvVal = nullptr;
+    ClearString();
+    ClearMatrix();
 
     m_cType = 'f';
     m_iFlags = flNONE;
@@ -349,11 +430,8 @@ IValue& Value::operator=(bool val)
 {
     m_val = cmplx_type((float_type)val, 0);
 
-    delete m_psVal;
-    m_psVal = nullptr;
-
-    delete m_pvVal;
-    m_pvVal = nullptr;
+    ClearString();
+    ClearMatrix();
 
     m_cType = 'b';
     m_iFlags = flNONE;
@@ -365,11 +443,8 @@ IValue& Value::operator=(int_type a_iVal)
 {
   m_val = cmplx_type(a_iVal,0);
 
-  delete m_psVal;
-  m_psVal = nullptr;
-
-  delete m_pvVal;
-  m_pvVal = nullptr;
+  ClearString();
+  ClearMatrix();
 
   m_cType = 'i';
   m_iFlags = flNONE;
@@ -381,11 +456,8 @@ IValue& Value::operator=(float_type val)
 {
     m_val = cmplx_type(val, 0);
 
-    delete m_psVal;
-    m_psVal = nullptr;
-
-    delete m_pvVal;
-    m_pvVal = nullptr;
+    ClearString();
+    ClearMatrix();
 
     m_cType = (val == (int_type)val) ? 'i' : 'f';
     m_iFlags = flNONE;
@@ -393,17 +465,24 @@ IValue& Value::operator=(float_type val)
 }
 
 //---------------------------------------------------------------------------
+/** \brief Assign a string.
+
+  The string is stored in the value itself. A string fitting into the buffer
+  kept by ClearString is copied into it, longer strings are moved.
+*/
 IValue& Value::operator=(string_type a_sVal)
 {
     m_val = cmplx_type();
 
     if (!m_psVal)
-        m_psVal = new string_type(a_sVal);
+        m_psVal = new string_type(std::move(a_sVal));
+    else if (a_sVal.size() <= m_psVal->capacity())
+        m_psVal->assign(a_sVal);
     else
-        *m_psVal = a_sVal;
+        *m_psVal = std::move(a_sVal);
 
-    delete m_pvVal;
-    m_pvVal = nullptr;
+    m_sliceVal = str_slice_type();
+    ClearMatrix();
 
     m_cType = 's';
     m_iFlags = flNONE;
@@ -413,19 +492,7 @@ IValue& Value::operator=(string_type a_sVal)
 //---------------------------------------------------------------------------
 IValue& Value::operator=(const char_type *a_szVal)
 {
-    m_val = cmplx_type();
-
-    if (!m_psVal)
-        m_psVal = new string_type(a_szVal);
-    else
-        *m_psVal = a_szVal;
-
-    delete m_pvVal;
-    m_pvVal = nullptr;
-
-    m_cType = 's';
-    m_iFlags = flNONE;
-    return *this;
+    return *this = string_type(a_szVal);
 }
 
 //---------------------------------------------------------------------------
@@ -433,8 +500,7 @@ IValue& Value::operator=(const matrix_type &a_vVal)
 {
     m_val = cmplx_type(0, 0);
 
-    delete m_psVal;
-    m_psVal = nullptr;
+    ClearString();
 
     if (m_pvVal == nullptr)
         m_pvVal = new matrix_type(a_vVal);
@@ -452,11 +518,8 @@ IValue& Value::operator=(const cmplx_type &val)
 {
     m_val = val;
 
-    delete m_psVal;
-    m_psVal = nullptr;
-
-    delete m_pvVal;
-    m_pvVal = nullptr;
+    ClearString();
+    ClearMatrix();
 
     m_cType = (m_val.imag() == 0) ? ((m_val.real() == (int)m_val.real()) ? 'i' : 'f') : 'c';
     m_iFlags = flNONE;
@@ -464,6 +527,69 @@ IValue& Value::operator=(const cmplx_type &val)
     return *this;
 }
 
+//---------------------------------------------------------------------------
+IValue& Value::operator=(const date_type &val)
+{
+    m_val = cmplx_type(val.Val, 0);
+
+    // The text of the date is written here, reading it must not change the value
+    if (!m_psVal)
+        m_psVal = new string_type(FormatDate(val));
+    else
+        *m_psVal = FormatDate(val);
+
+    m_sliceVal = str_slice_type();
+    ClearMatrix();
+
+    m_cType = (val.IsTime) ? 't' : 'd';
+    m_iFlags = flNONE;
+
+    return *this;
+}
+
+//---------------------------------------------------------------------------
+/** \brief Assign a string slice.
+
+  A slice covering its whole buffer shares it, the characters of a part of a 
+  buffer are copied into the value. A string buffer of this value is kept as 
+  room for later strings.
+*/
+IValue& Value::operator=(const str_slice_type &val)
+{
+    if (!val.Buf)
+        return *this = string_type();
+
+    if (!val.IsWhole())
+    {
+        m_val = cmplx_type();
+
+        if (!m_psVal)
+            m_psVal = new string_type(val.Data(), val.Len);
+        else
+            m_psVal->assign(val.Data(), val.Len);
+
+        m_sliceVal = str_slice_type();
+        ClearMatrix();
+
+        m_cType = 's';
+        m_iFlags = flNONE;
+        return *this;
+    }
+
+    m_val = cmplx_type();
+    m_sliceVal = val;
+
+    if (m_psVal)
+        m_psVal->clear();
+
+    ClearMatrix();
+
+    m_cType = 's';
+    m_iFlags = flNONE;
+
+    return *this;
+}
+
 //---------------------------------------------------------------------------
 IValue& Value::operator+=(const IValue &val)
 {
@@ -482,6 +608,7 @@ IValue& Value::operator+=(const IValue &val)
     else if (IsString() && val.IsString())
     {
         // string/string addition
+        ResolveSlice();
         assert(m_psVal);
         *m_psVal += val.GetString();
     }
@@ -574,7 +701,8 @@ IValue& Value::operator*=(const IValue &val)
 //---------------------------------------------------------------------------
 /** \brief Returns a character representing the type of this value instance.
     \return m_cType Either one of 'i' for integer, 'f' for floating point,
-    'b' for boolean, 's' for string, 'c' for complex or 'm' for matrix values.
+    'b' for boolean, 's' for string, 'c' for complex, 'm' for matrix, 'd' for
+    date or 't' for date time values.
     */
 char_type Value::GetType() const
 {
@@ -668,11 +796,66 @@ const cmplx_type& Value::GetComplex() const
 //---------------------------------------------------------------------------
 const string_type& Value::GetString() const
 {
+    // Dates keep their text from the time they were assigned
+    if (IsDate())
+    {
+        assert(m_psVal != nullptr);
+        return *m_psVal;
+    }
+
     CheckType('s');
+
+    // A shared buffer always holds exactly the string of this value
+    if (m_sliceVal.Buf)
+    {
+        assert(m_sliceVal.IsWhole());
+        return *m_sliceVal.Buf;
+    }
+
     assert(m_psVal != nullptr);
     return *m_psVal;
 }
 
+//---------------------------------------------------------------------------
+/** \brief Returns the string as a slice of a shared buffer.
+
+  The shared buffer of the value is returned without a copy. The text of a date
+  and a string stored in the value itself are copied into a new buffer, the 
+  value is not changed.
+*/
+str_slice_type Value::GetSlice() const
+{
+    if (m_sliceVal.Buf)
+        return m_sliceVal;
+
+    const string_type &sVal = GetString();
+    return str_slice_type(std::make_shared<const string_type>(sVal), 0, sVal.size());
+}
+
+//---------------------------------------------------------------------------
+/** \brief Returns true if the value is a string from the table of interned strings. */
+bool Value::IsInterned() const
+{
+    return m_sliceVal.Buf && m_sliceVal.Interned;
+}
+
+//---------------------------------------------------------------------------
+/** \brief Copy the characters of a shared buffer into the value itself before 
+           the string is changed.
+*/
+void Value::ResolveSlice()
+{
+    if (!m_sliceVal.Buf)
+        return;
+
+    if (!m_psVal)
+        m_psVal = new string_type(m_sliceVal.Data(), m_sliceVal.Len);
+    else
+        m_psVal->assign(m_sliceVal.Data(), m_sliceVal.Len);
+
+    m_sliceVal = str_slice_type();
+}
+
 //---------------------------------------------------------------------------
 bool Value::GetBool() const
 {
@@ -688,6 +871,18 @@ const matrix_type& Value::GetArray() const
     return *m_pvVal;
 }
 
+//---------------------------------------------------------------------------
+/** \brief Returns the date or date time represented by this value.
+    \throw ParserError if the value is neither a date nor a date time.
+*/
+date_type Value::GetDate() const
+{
+    if (!IsDate())
+        CheckType('d');
+
+    return date_type(m_val.real(), m_cType == 't');
+}
+
 //---------------------------------------------------------------------------
 int Value::GetRows() const
 {
@@ -747,9 +942,9 @@ string_type Value::AsciiDump() const
     case 'i': ss << (int_type)m_val.real(); break;
     case 'f': ss << m_val.real(); break;
     case 'm': ss << _T("(matrix)"); break;
-    case 's':
-        assert(m_psVal != nullptr);
-        ss << _T("\"") << m_psVal << _T("\""); break;
+    case 's': ss << _T("\"") << GetString() << _T("\""); break;
+    case 'd':
+    case 't': ss << FormatDate(GetDate()); break;
     }
 
     ss << ((IsFlagSet(IToken::flVOLATILE)) ? _T("; ") : _T("; not ")) << _T("vol");
@@ -761,27 +956,49 @@ string_type Value::AsciiDump() const
 //---------------------------------------------------------------------------
 string_type Value::AsString() const
 {
-    stringstream_type ss;
+    char_type buf[FORMAT_BUF_SIZE];
 
     switch (m_cType)
     {
-    case 'i': ss << (int_type)m_val.real(); break;
-    case 'f': ss << std::setprecision(std::numeric_limits<float_type>::digits10) << GetFloat(); break;
-    case 'm': ss << _T("(matrix)"); break;
-    case 's':
-        assert(m_psVal != nullptr);
-        ss << GetString(); break;
-    case 'b': ss << (GetBool() ? "true" : "false"); break;
+    case 'i': return string_type(buf, FormatInt((int_type)m_val.real(), buf));
+    case 'f': return string_type(buf, FormatFloat(GetFloat(), buf, s_eFormatMode));
+    case 'm': return _T("(matrix)");
+    case 's': return GetString();
+    case 'b': return (GetBool() ? _T("true") : _T("false"));
+    case 'd':
+    case 't': return GetString();
     }
 
-    return ss.str();
+    return string_type();
+}
+
+//-----------------------------------------------------------------------------------------------
+/** \brief Set the format of floating point values returned by AsString.
+
+  fmSHORTEST returns the shortest string reading back to the same value. fmCOMPAT
+  returns the output of former versions and is the default. The setting applies to
+  all values and should be made before any parser is used.
+*/
+void Value::SetFormatMode(EFormatMode eMode)
+{
+    s_eFormatMode = eMode;
+}
+
+//-----------------------------------------------------------------------------------------------
+EFormatMode Value::GetFormatMode()
+{
+    return s_eFormatMode;
 }
 
 //-----------------------------------------------------------------------------------------------
 void Value::Release()
 {
     if (m_pCache)
+    {
+        // Values kept in the cache hold no shared string buffer and no large buffers
+        Reset();
         m_pCache->ReleaseToCache(this);
+    }
     else
         delete this;
 }
@@ -42,6 +42,7 @@
 //--- Parser framework -------------------------------------------------------------
 #include "mpIValue.h"
 #include "mpTypes.h"
+#include "mpFormat.h"
 
 
 MUP_NAMESPACE_START
@@ -65,6 +66,7 @@ MUP_NAMESPACE_START
     Value(const char_type *val);
     Value(const cmplx_type &v);
     Value(const matrix_type &val);
+    Value(const date_type &val);
 
     // Array and Matrix constructors
     Value(int_type m, float_type v);
@@ -77,6 +79,7 @@ MUP_NAMESPACE_START
     virtual ~Value();
 
     virtual IValue& At(int nRow, int nCol = 0) override;
+    virtual const IValue& At(int nRow, int nCol = 0) const override;
     virtual IValue& At(const IValue &row, const IValue &col) override;
 
     virtual IValue& operator=(int_type a_iVal) override;
@@ -85,6 +88,8 @@ MUP_NAMESPACE_START
     virtual IValue& operator=(bool val) override;
     virtual IValue& operator=(const matrix_type &a_vVal) override;
     virtual IValue& operator=(const cmplx_type &val) override;
+    virtual IValue& operator=(const date_type &val) override;
+    virtual IValue& operator=(const str_slice_type &val) override;
     virtual IValue& operator=(const char_type *a_szVal);
     virtual IValue& operator+=(const IValue &val) override;
     virtual IValue& operator-=(const IValue &val) override;
@@ -97,7 +102,10 @@ MUP_NAMESPACE_START
     virtual bool GetBool() const override;
     virtual const cmplx_type& GetComplex() const override;
     virtual const string_type& GetString() const override;
+    virtual str_slice_type GetSlice() const override;
+    virtual bool IsInterned() const override;
     virtual const matrix_type& GetArray() const override;
+    virtual date_type GetDate() const override;
     virtual int GetRows() const override;
     virtual int GetCols() const override;
 
@@ -110,6 +118,9 @@ MUP_NAMESPACE_START
     virtual string_type AsString() const;
     void BindToCache(ValueCache *pCache);
 
+    static void SetFormatMode(EFormatMode eMode);
+    static EFormatMode GetFormatMode();
+
     // Conversion operators
     operator cmplx_type();
     operator int ();
@@ -119,15 +130,21 @@ MUP_NAMESPACE_START
 
   private:
 
-    cmplx_type   m_val;    ///< Member variable for storing the value of complex, float, int and boolean values
-    string_type *m_psVal;  ///< Variable for storing a string value
-    matrix_type *m_pvVal;  ///< A Vector for storing array variable content
+    cmplx_type   m_val;    ///< Member variable for storing the value of complex, float, int, boolean and date values
+    string_type *m_psVal;  ///< Variable for storing a string value or the text of a date, empty otherwise
+    str_slice_type m_sliceVal; ///< String value stored as a whole shared buffer, used instead of m_psVal if its buffer is set
+    matrix_type *m_pvVal;  ///< A Vector for storing array variable content, kept as room for later arrays
     char_type    m_cType;  ///< A byte indicating the type os the represented value
     EFlags       m_iFlags; ///< Additional flags
     ValueCache  *m_pCache; ///< Pointer to the Value Cache
 
+    static EFormatMode s_eFormatMode; ///< Format of floating point values returned by AsString
+
     void CheckType(char_type a_cType) const;
+    void ResolveSlice();
     void Assign(const Value &a_Val);
+    void ClearString();
+    void ClearMatrix();
     void Reset();
 
     virtual void Release() override;
@@ -34,15 +34,41 @@
 */
 #include "mpValueCache.h"
 
+#include <algorithm>
+
 #include "mpValue.h"
+#include "mpMemoryResource.h"
 
 
 MUP_NAMESPACE_START
 
   //------------------------------------------------------------------------------
-  ValueCache::ValueCache(int size)
+  ValueCacheStats::ValueCacheStats()
+    :Hits(0)
+    ,Misses(0)
+    ,Overflows(0)
+    ,Capacity(0)
+    ,HighWater(0)
+  {}
+
+  //------------------------------------------------------------------------------
+  ValueCache::ValueCache(int size, int maxSize)
     :m_nIdx(-1)
+    ,m_nMaxSize(std::max(size, maxSize))
+    ,m_nOut(0)
+    ,m_bThreadCache(false)
     ,m_vCache(size, (mup::Value*)0) // hint to myself: don't use nullptr gcc will go postal...
+    ,m_stats()
+  {}
+
+  //------------------------------------------------------------------------------
+  ValueCache::ValueCache(int size, int maxSize, bool bThreadCache)
+    :m_nIdx(-1)
+    ,m_nMaxSize(std::max(size, maxSize))
+    ,m_nOut(0)
+    ,m_bThreadCache(bThreadCache)
+    ,m_vCache(size, (mup::Value*)0)
+    ,m_stats()
   {}
 
   //------------------------------------------------------------------------------
@@ -51,6 +77,47 @@ MUP_NAMESPACE_START
     ReleaseAll();
   }
 
+  //------------------------------------------------------------------------------
+  /** \brief Returns the cache shared by the parsers of the calling thread.
+
+    Values of the thread cache must neither be released by another thread nor 
+    after the thread ended. Values allocated from a memory resource other than
+    the new/delete resource are deleted instead of being kept, they might 
+    outlive their resource otherwise.
+  */
+  ValueCache& ValueCache::GetThreadCache()
+  {
+    static thread_local ValueCache cache(10, MUP_VALUE_CACHE_MAX_SIZE, true);
+    return cache;
+  }
+
+  //------------------------------------------------------------------------------
+  /** \brief Grow the cache to hold at least size unused values. 
+  
+    Parsers reserve room for the values of their evaluation stack.
+  */
+  void ValueCache::Reserve(int size)
+  {
+    size = std::min(size, m_nMaxSize);
+    if (size > (int)m_vCache.size())
+      m_vCache.resize(size, (mup::Value*)0);
+  }
+
+  //------------------------------------------------------------------------------
+  ValueCacheStats ValueCache::GetStats() const
+  {
+    ValueCacheStats stats = m_stats;
+    stats.Capacity = (int)m_vCache.size();
+    return stats;
+  }
+
+  //------------------------------------------------------------------------------
+  void ValueCache::ResetStats()
+  {
+    m_stats = ValueCacheStats();
+    m_stats.HighWater = m_nOut;
+  }
+
   //------------------------------------------------------------------------------
   void ValueCache::ReleaseAll()
   {
@@ -71,16 +138,31 @@ MUP_NAMESPACE_START
       return;
 
     assert(pValue->GetRef()==0);
+    m_nOut--;
 
-    // Add the value to the cache if the cache has room for it 
-    // otherwise release the value item instantly
+    if (m_bThreadCache && pValue->GetMemoryResource()!=GetNewDeleteResource())
+    {
+      delete pValue;
+      return;
+    }
+
+    // Add the value to the cache if the cache has room for it or may 
+    // grow otherwise release the value item instantly
     if ( m_nIdx < ((int)m_vCache.size()-1) )
     {
       m_nIdx++;
       m_vCache[m_nIdx] = pValue;
     }
+    else if ((int)m_vCache.size() < m_nMaxSize)
+    {
+      m_nIdx++;
+      m_vCache.push_back(pValue);
+    }
     else
+    {
+      m_stats.Overflows++;
       delete pValue;
+    }
   }
 
   //------------------------------------------------------------------------------
@@ -92,13 +174,17 @@ MUP_NAMESPACE_START
       pValue = m_vCache[m_nIdx];
       m_vCache[m_nIdx] = nullptr;
       m_nIdx--;
+      m_stats.Hits++;
     }
     else
     {
       pValue = new Value();
       pValue->BindToCache(this);
+      m_stats.Misses++;
     }
 
+    m_nOut++;
+    m_stats.HighWater = std::max(m_stats.HighWater, m_nOut);
     return pValue;
   }
 
@@ -38,9 +38,22 @@
 #include <vector>
 
 #include "mpFwdDecl.h"
+#include "mpDefines.h"
 
 
 MUP_NAMESPACE_START
+
+  /** \brief Counters of a value cache. */
+  struct ValueCacheStats
+  {
+    ValueCacheStats();
+
+    unsigned long long Hits;      ///< Values handed out from the cache
+    unsigned long long Misses;    ///< Values created because the cache was empty
+    unsigned long long Overflows; ///< Values deleted because the cache was full
+    int Capacity;                 ///< Number of unused values the cache can hold
+    int HighWater;                ///< Largest number of values handed out at the same time
+  };
   
   /** \brief The ValueCache class provides a simple mechanism to recycle 
              unused value items.
@@ -49,23 +62,39 @@ MUP_NAMESPACE_START
     unnecessary and slow new/delete calls by storing unused value 
     objects in an internal buffer for later reuse. By eliminating new/delete
     calls the parser is sped up approximately by factor 3-4.
+
+    The cache grows up to its maximum size when values are returned to it 
+    while it is full, so that it holds as many values as were handed out at
+    the same time. Recycled values keep the buffers of their strings and 
+    matrices.
   */
   class ValueCache
   {
   public:
-    ValueCache(int size=10);
+    ValueCache(int size=10, int maxSize=MUP_VALUE_CACHE_MAX_SIZE);
    ~ValueCache();
 
+    void Reserve(int size);
     void ReleaseAll();
     void ReleaseToCache(Value *pValue);
     Value* CreateFromCache();
 
+    ValueCacheStats GetStats() const;
+    void ResetStats();
+
+    static ValueCache& GetThreadCache();
+
   private:
+    ValueCache(int size, int maxSize, bool bThreadCache);
     ValueCache(const ValueCache &ref);
     ValueCache& operator=(const ValueCache &ref);
 
     int m_nIdx;
+    int m_nMaxSize;
+    int m_nOut;          ///< Number of values handed out and not returned yet
+    bool m_bThreadCache; ///< True for the cache shared by the parsers of a thread
     std::vector<Value*> m_vCache;
+    ValueCacheStats m_stats;
   };
 
 MUP_NAMESPACE_END
@@ -51,6 +51,8 @@ MUP_NAMESPACE_START
   Variable::Variable(IValue *pVal)
     :IValue(cmVAL)
     ,m_pVal(pVal)
+    ,m_nRow(-1)
+    ,m_nCol(0)
   {
     AddFlags(IToken::flVOLATILE);
   }
@@ -77,7 +79,7 @@ MUP_NAMESPACE_START
   IValue& Variable::operator=(const Value &ref)
   {
     assert(m_pVal);
-    *m_pVal = ref;
+    *Target() = ref;
     return *this;
   }
 
@@ -85,69 +87,107 @@ MUP_NAMESPACE_START
   IValue& Variable::operator=(int_type val)
   {
     assert(m_pVal);
-    return m_pVal->operator=(val);
+    return Target()->operator=(val);
   }
 
   //-----------------------------------------------------------------------------------------------
   IValue& Variable::operator=(float_type val)
   {
     assert(m_pVal);
-    return m_pVal->operator=(val);
+    return Target()->operator=(val);
   }
 
   //-----------------------------------------------------------------------------------------------
   IValue& Variable::operator=(string_type val)
   {
     assert(m_pVal);
-    return m_pVal->operator=(val);
+    return Target()->operator=(std::move(val));
   }
 
   //-----------------------------------------------------------------------------------------------
   IValue& Variable::operator=(bool_type val)
   {
     assert(m_pVal);
-    return m_pVal->operator=(val);
+    return Target()->operator=(val);
   }
 
   //-----------------------------------------------------------------------------------------------
   IValue& Variable::operator=(const matrix_type &val)
   {
     assert(m_pVal);
-    return m_pVal->operator=(val);
+    return Target()->operator=(val);
   }
 
   //-----------------------------------------------------------------------------------------------
   IValue& Variable::operator=(const cmplx_type &val)
   {
     assert(m_pVal);
-    return m_pVal->operator=(val);
+    return Target()->operator=(val);
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  IValue& Variable::operator=(const date_type &val)
+  {
+    assert(m_pVal);
+    return Target()->operator=(val);
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  IValue& Variable::operator=(const str_slice_type &val)
+  {
+    assert(m_pVal);
+    return Target()->operator=(val);
   }
 
   //-----------------------------------------------------------------------------------------------
   IValue& Variable::operator+=(const IValue &val)
   {
     assert(m_pVal);
-    return m_pVal->operator+=(val);
+    return Target()->operator+=(val);
   }
 
   //-----------------------------------------------------------------------------------------------
   IValue& Variable::operator-=(const IValue &val)
   {
     assert(m_pVal);
-    return m_pVal->operator-=(val);
+    return Target()->operator-=(val);
   }
 
   //-----------------------------------------------------------------------------------------------
   IValue& Variable::operator*=(const IValue &val)
   {
     assert(m_pVal);
-    return m_pVal->operator*=(val);
+    return Target()->operator*=(val);
   }
 
   //-----------------------------------------------------------------------------------------------
   IValue& Variable::At(int nRow, int nCol)
   {
-    return m_pVal->At(nRow, nCol);
+    try
+    {
+      return Target()->At(nRow, nCol);
+    }
+    catch(ParserError &exc)
+    {
+      // add the identifier to the error context
+      exc.GetContext().Ident = GetIdent();
+      throw exc;
+    }
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  const IValue& Variable::At(int nRow, int nCol) const
+  {
+    try
+    {
+      return Target()->At(nRow, nCol);
+    }
+    catch(ParserError &exc)
+    {
+      // add the identifier to the error context
+      exc.GetContext().Ident = GetIdent();
+      throw exc;
+    }
   }
 
   //-----------------------------------------------------------------------------------------------
@@ -155,7 +195,7 @@ MUP_NAMESPACE_START
   {
     try
     {
-      return m_pVal->At(row, col);
+      return Target()->At(row, col);
     }
     catch(ParserError &exc)
     {
@@ -176,6 +216,8 @@ MUP_NAMESPACE_START
       return;
 
     m_pVal = ref.m_pVal;
+    m_nRow = ref.m_nRow;
+    m_nCol = ref.m_nCol;
   }
 
   //-----------------------------------------------------------------------------------------------
@@ -184,7 +226,7 @@ MUP_NAMESPACE_START
   */
   char_type Variable::GetType() const
   {
-    return (m_pVal) ? m_pVal->GetType() : 'v';
+    return (m_pVal) ? Target()->GetType() : 'v';
   }
 
     //-----------------------------------------------------------------------------------------------
@@ -201,7 +243,7 @@ MUP_NAMESPACE_START
     {
         try
         {
-            return m_pVal->GetInteger();
+            return Target()->GetInteger();
         }
         catch (ParserError &exc)
         {
@@ -215,7 +257,7 @@ MUP_NAMESPACE_START
     {
         try
         {
-            return m_pVal->GetFloat();
+            return Target()->GetFloat();
         }
         catch (ParserError &exc)
         {
@@ -229,7 +271,7 @@ MUP_NAMESPACE_START
     {
         try
         {
-            return m_pVal->GetImag();
+            return Target()->GetImag();
         }
         catch (ParserError &exc)
         {
@@ -243,7 +285,7 @@ MUP_NAMESPACE_START
     {
         try
         {
-            return m_pVal->GetComplex();
+            return Target()->GetComplex();
         }
         catch (ParserError &exc)
         {
@@ -257,7 +299,21 @@ MUP_NAMESPACE_START
     {
         try
         {
-            return m_pVal->GetString();
+            return Target()->GetString();
+        }
+        catch (ParserError &exc)
+        {
+            exc.GetContext().Ident = GetIdent();
+            throw;
+        }
+    }
+
+    //-----------------------------------------------------------------------------------------------
+    str_slice_type Variable::GetSlice() const
+    {
+        try
+        {
+            return Target()->GetSlice();
         }
         catch (ParserError &exc)
         {
@@ -266,12 +322,19 @@ MUP_NAMESPACE_START
         }
     }
 
+    //-----------------------------------------------------------------------------------------------
+    bool Variable::IsInterned() const
+    {
+        assert(m_pVal);
+        return Target()->IsInterned();
+    }
+
     //-----------------------------------------------------------------------------------------------
     bool Variable::GetBool() const
     {
         try
         {
-            return m_pVal->GetBool();
+            return Target()->GetBool();
         }
         catch (ParserError &exc)
         {
@@ -285,7 +348,21 @@ MUP_NAMESPACE_START
     {
         try
         {
-            return m_pVal->GetArray();
+            return Target()->GetArray();
+        }
+        catch (ParserError &exc)
+        {
+            exc.GetContext().Ident = GetIdent();
+            throw;
+        }
+    }
+
+    //-----------------------------------------------------------------------------------------------
+    date_type Variable::GetDate() const
+    {
+        try
+        {
+            return Target()->GetDate();
         }
         catch (ParserError &exc)
         {
@@ -299,7 +376,7 @@ MUP_NAMESPACE_START
     {
         try
         {
-            return m_pVal->GetRows();
+            return Target()->GetRows();
         }
         catch (ParserError &exc)
         {
@@ -313,7 +390,7 @@ MUP_NAMESPACE_START
     {
         try
         {
-            return m_pVal->GetCols();
+            return Target()->GetCols();
         }
         catch (ParserError &exc)
         {
@@ -326,27 +403,62 @@ MUP_NAMESPACE_START
   void Variable::SetFloat(float_type a_fVal)
   {
     assert(m_pVal);
-    *m_pVal = a_fVal;
+    *Target() = a_fVal;
   }
 
   //-----------------------------------------------------------------------------------------------
   void Variable::SetString(const string_type &a_sVal)
   {
     assert(m_pVal);
-    *m_pVal = a_sVal;
+    *Target() = a_sVal;
   }
 
   //-----------------------------------------------------------------------------------------------
   void Variable::SetBool(bool a_bVal)
   {
     assert(m_pVal);
-    *m_pVal = a_bVal;
+    *Target() = a_bVal;
   }
 
   //-----------------------------------------------------------------------------------------------
   void Variable::Bind(IValue *pValue)
   {
     m_pVal = pValue;
+    m_nRow = -1;
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  /** \brief Bind the variable to an element of an array.
+      \param pArray Pointer to the value holding the array.
+      \param nRow Row of the element.
+      \param nCol Column of the element.
+
+    The element is looked up on every access instead of being bound by its address.
+    Storing an element may switch a sparse array to dense storage, which moves all of
+    its elements.
+  */
+  void Variable::BindElement(IValue *pArray, int nRow, int nCol)
+  {
+    m_pVal = pArray;
+    m_nRow = nRow;
+    m_nCol = nCol;
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  /** \brief Returns the value this variable refers all operations to. */
+  IValue* Variable::Target()
+  {
+    return (m_nRow < 0) ? m_pVal : &m_pVal->At(m_nRow, m_nCol);
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  /** \brief Returns the value this variable refers all read operations to. 
+  
+    Reading an element of an array does not store it in a sparse array.
+  */
+  const IValue* Variable::Target() const
+  {
+    return (m_nRow < 0) ? m_pVal : &static_cast<const IValue*>(m_pVal)->At(m_nRow, m_nCol);
   }
 
   //---------------------------------------------------------------------------
@@ -384,6 +496,8 @@ MUP_NAMESPACE_START
     case 'i': ss << (int_type)GetFloat(); break;
     case 'f': ss << GetFloat(); break;
     case 'm': ss << _T("(array)"); break;
+    case 'd':
+    case 't':
     case 's': ss << _T("\"") << GetString() << _T("\""); break;
     }
 
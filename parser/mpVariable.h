@@ -58,11 +58,14 @@ MUP_NAMESPACE_START
     Variable& operator=(const Variable &a_Var);
 
     virtual IValue& At(int nRow, int nCol);
+    virtual const IValue& At(int nRow, int nCol) const;
     virtual IValue& At(const IValue &nRows, const IValue &nCols);
 
     virtual IValue& operator=(const Value &val);
     virtual IValue& operator=(const matrix_type &val);
     virtual IValue& operator=(const cmplx_type &val);
+    virtual IValue& operator=(const date_type &val);
+    virtual IValue& operator=(const str_slice_type &val);
     virtual IValue& operator=(int_type val);
     virtual IValue& operator=(float_type val);
     virtual IValue& operator=(string_type val);
@@ -81,7 +84,10 @@ MUP_NAMESPACE_START
     virtual bool GetBool() const;
     virtual const cmplx_type& GetComplex() const;
     virtual const string_type& GetString() const;
+    virtual str_slice_type GetSlice() const;
+    virtual bool IsInterned() const;
     virtual const matrix_type& GetArray() const;
+    virtual date_type GetDate() const;
     virtual int GetRows() const;
     virtual int GetCols() const;
 
@@ -94,6 +100,7 @@ MUP_NAMESPACE_START
     void SetBool(bool a_bVal);
 
     void Bind(IValue *pValue);
+    void BindElement(IValue *pArray, int nRow, int nCol);
 
     IValue* GetPtr() const;
     string_type AsciiDump() const;
@@ -101,9 +108,13 @@ MUP_NAMESPACE_START
   private:
 
     IValue *m_pVal;    ///< Pointer to the value object bound to this variable
+    int m_nRow;        ///< Row of the element of m_pVal bound to this variable, -1 if m_pVal itself is bound
+    int m_nCol;        ///< Column of the element of m_pVal bound to this variable
 
     void Assign(const Variable &a_Var);
     void CheckType(char_type a_cType) const;
+    IValue* Target();
+    const IValue* Target() const;
   }; // class Variable
 
 MUP_NAMESPACE_END
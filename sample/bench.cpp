@@ -0,0 +1,693 @@
+/** \example bench.cpp
+    Benchmark of the parser over a corpus of representative formulas.
+    Output: Throughput and latency percentiles of tokenizing, compiling and
+            evaluating each formula and category, and of calculating formulas
+            with EquationsParser::CalcJson, as JSON, or with -t the
+            throughput and scaling efficiency of concurrent evaluation at
+            1..N threads
+
+<pre>
+               __________                                 ____  ___
+    _____  __ _\______   \_____ _______  ______ __________\   \/  /
+   /     \|  |  \     ___/\__  \\_  __ \/  ___// __ \_  __ \     /
+  |  Y Y  \  |  /    |     / __ \|  | \/\___ \\  ___/|  | \/     \
+  |__|_|  /____/|____|    (____  /__|  /____  >\___  >__| /___/\  \
+        \/                     \/           \/     \/           \_/
+                                       Copyright (C) 2016, Ingo Berg
+                                       All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+  NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+</pre>
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#define MUP_BENCH_RUSAGE
+#endif
+
+//--- muparserx framework -------------------------------------------------------------------------
+#include "mpParser.h"
+#include "mpAllocCounter.h"
+#include "equationsParser.h"
+
+using namespace std;
+using namespace mup;
+
+typedef std::chrono::steady_clock clock_type;
+
+#if !defined(MUP_COUNT_ALLOCATIONS)
+
+//---------------------------------------------------------------------------
+/** \brief Replacement of the global operator new counting heap allocations.
+
+  The number of allocations indicates the allocator pressure of a workload.
+  The counters of the library are thread local, counting does not introduce
+  contention of its own. A library built with MUP_COUNT_ALLOCATIONS replaces
+  operator new itself.
+*/
+void* operator new(std::size_t nSize)
+{
+  mup::RecordAllocation(nSize);
+  void *p = std::malloc(nSize ? nSize : 1);
+  if (!p)
+    throw std::bad_alloc();
+
+  return p;
+}
+
+void operator delete(void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+#endif // MUP_COUNT_ALLOCATIONS
+
+//---------------------------------------------------------------------------
+/** \brief A formula of the benchmark corpus. */
+struct Formula
+{
+  const char_type *szCategory;
+  const char_type *szExpr;
+};
+
+//---------------------------------------------------------------------------
+/** \brief Formulas representative of each category of parser features. */
+static const Formula g_Corpus[] =
+{
+  { _T("arithmetic"),   _T("a + b * c - a / b") },
+  { _T("arithmetic"),   _T("(a + 1) * (b - 2) * (c + 3) / 4 + a^2") },
+  { _T("arithmetic"),   _T("a * 1.5 + b * 2.5 + c * 3.5 + fmod(100, 7)") },
+  { _T("trig"),         _T("sin(a) * cos(b) + tan(c / 10)") },
+  { _T("trig"),         _T("sqrt(sin(a)^2 + cos(a)^2) + atan2(b, c)") },
+  { _T("string"),       _T("left(\"hello world\", 5) // \" \" // right(\"hello world\", 5)") },
+  { _T("string"),       _T("length(\"equations\" // \"-\" // \"parser\") + 1") },
+  { _T("string"),       _T("contains(\"equations parser\", \"parser\")") },
+  { _T("date"),         _T("daysdiff(\"2024-01-01\", \"2024-03-15\")") },
+  { _T("date"),         _T("weekday(\"2024-09-17\") + weekyear(\"2024-09-17\")") },
+  { _T("date"),         _T("hoursdiff(\"2024-01-01T08:00\", \"2024-01-02T17:30\")") },
+  { _T("regex"),        _T("regex(\"order 12345 shipped\", \"order ([0-9]+)\")") },
+  { _T("matrix"),       _T("size(zeros(20, 30)')") },
+  { _T("matrix"),       _T("sum({1, 2, 3, 4, 5, 6, 7, 8}) + max({a, b, c})") },
+  { _T("matrix"),       _T("median({5, 1, 4, 2, 9, 7}) + percentile({1, 2, 3, 4, 5}, 0.9)") },
+  { _T("if-then-else"), _T("a > b ? a : (b > c ? b : c)") },
+  { _T("if-then-else"), _T("a < 0 ? \"negative\" : a < 10 ? \"small\" : a < 100 ? \"medium\" : \"large\"") },
+  { _T("calculate"),    _T("calculate(\"1 + 2 * 3\")") },
+  { _T("calculate"),    _T("calculate(\"sqrt(16) + 2^3\" // \" * \" // \"2\")") },
+};
+
+//---------------------------------------------------------------------------
+/** \brief The phases of processing a formula measured separately. */
+enum EPhase
+{
+  phTOKENIZE,
+  phCOMPILE,
+  phEVALUATE,
+  phCOUNT
+};
+
+static const char *g_szPhase[phCOUNT] = { "tokenize", "compile", "evaluate" };
+
+//---------------------------------------------------------------------------
+/** \brief Latencies of a phase in nanoseconds. */
+typedef std::vector<double> latency_vec_type;
+
+//---------------------------------------------------------------------------
+double ElapsedNs(clock_type::time_point tStart)
+{
+  return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - tStart).count();
+}
+
+//---------------------------------------------------------------------------
+/** \brief Returns a string as JSON string literal. */
+string JsonString(const string_type &s)
+{
+  string sRes = "\"";
+  for (std::size_t i = 0; i < s.length(); ++i)
+  {
+    char c = (char)s[i];
+    switch (c)
+    {
+    case '"':  sRes += "\\\""; break;
+    case '\\': sRes += "\\\\"; break;
+    case '\n': sRes += "\\n";  break;
+    case '\t': sRes += "\\t";  break;
+    default:   sRes += c;
+    }
+  }
+
+  return sRes + "\"";
+}
+
+//---------------------------------------------------------------------------
+/** \brief Returns the median of a non empty list of latencies. */
+double Median(latency_vec_type vLatency)
+{
+  std::size_t n = vLatency.size() / 2;
+  std::nth_element(vLatency.begin(), vLatency.begin() + n, vLatency.end());
+  return vLatency[n];
+}
+
+//---------------------------------------------------------------------------
+/** \brief Writes throughput and latency percentiles of a phase as JSON object.
+
+  The latencies are sorted by this function.
+  \param pRunP50 Median latency of each repeated run, written if given so that
+                 benchcmp can test differences of two results for significance.
+*/
+void WriteStats(ostream &os, latency_vec_type &vLatency, const latency_vec_type *pRunP50 = 0)
+{
+  std::sort(vLatency.begin(), vLatency.end());
+
+  double fTotal = 0;
+  for (std::size_t i = 0; i < vLatency.size(); ++i)
+    fTotal += vLatency[i];
+
+  std::size_t n = vLatency.size();
+  os << "{\"samples\": " << n
+     << ", \"ops_per_sec\": " << ((fTotal > 0) ? 1e9 * n / fTotal : 0)
+     << ", \"p50_ns\": " << vLatency[n * 50 / 100]
+     << ", \"p90_ns\": " << vLatency[n * 90 / 100]
+     << ", \"p99_ns\": " << vLatency[n * 99 / 100]
+     << ", \"max_ns\": " << vLatency[n - 1];
+
+  if (pRunP50)
+  {
+    os << ", \"runs_p50_ns\": [";
+    for (std::size_t i = 0; i < pRunP50->size(); ++i)
+      os << (i ? ", " : "") << (*pRunP50)[i];
+    os << "]";
+  }
+
+  os << "}";
+}
+
+//---------------------------------------------------------------------------
+/** \brief Measures the phases of a single formula.
+
+  Tokenizing is measured by scanning the expression for its variables, compiling
+  by translating the scanned tokens into reverse polish notation and evaluating
+  by calculating the compiled expression.
+*/
+void MeasureFormula(ParserX &parser, const Formula &f, int nIter, latency_vec_type vLatency[phCOUNT], string_type &sResult)
+{
+  for (int i = 0; i < nIter; ++i)
+  {
+    parser.SetExpr(f.szExpr);
+
+    clock_type::time_point t = clock_type::now();
+    parser.GetExprVar();
+    vLatency[phTOKENIZE].push_back(ElapsedNs(t));
+
+    t = clock_type::now();
+    parser.Compile();
+    vLatency[phCOMPILE].push_back(ElapsedNs(t));
+  }
+
+  for (int i = 0; i < nIter; ++i)
+  {
+    clock_type::time_point t = clock_type::now();
+    parser.Eval();
+    vLatency[phEVALUATE].push_back(ElapsedNs(t));
+  }
+
+  sResult = parser.Eval().ToString();
+}
+
+//---------------------------------------------------------------------------
+/** \brief Formulas of the scaling benchmark and of measuring CalcJson.
+
+  The formulas do not use variables, so that they can be passed to
+  EquationsParser::Calc as they are. They touch the shared state of the
+  library: the function packages, the error messages, the time functions of
+  the C library and the heap.
+*/
+static const char *g_CalcCorpus[] =
+{
+  "3.5 + -1.25 * 42 - 3.5 / -1.25 + fmod(100, 7)",
+  "sqrt(sin(0.5)^2 + cos(0.5)^2) + atan2(1, 2)",
+  "left(\"hello world\", 5) // \" \" // right(\"hello world\", 5)",
+  "daysdiff(\"2024-01-01\", \"2024-03-15\") + weekday(\"2024-09-17\")",
+  "timediff(\"08:00:00\", \"17:30:00\")",
+  "current_date()",
+  "regex(\"order 12345 shipped\", \"order ([0-9]+)\")",
+  "sum({1, 2, 3, 4, 5, 6, 7, 8}) + median({5, 1, 4, 2, 9, 7})",
+  "1 > 2 ? \"greater\" : \"less\"",
+  "undefined_function(1)",
+};
+
+static const std::size_t g_nCalcCorpus = sizeof(g_CalcCorpus) / sizeof(g_CalcCorpus[0]);
+
+//---------------------------------------------------------------------------
+/** \brief Measures EquationsParser::CalcJson end to end, including the parser construction. */
+void MeasureCalcJson(int nIter, latency_vec_type &vLatency)
+{
+  for (std::size_t k = 0; k < g_nCalcCorpus; ++k)
+  {
+    for (int i = 0; i < nIter; ++i)
+    {
+      clock_type::time_point t = clock_type::now();
+      EquationsParser::CalcJson(g_CalcCorpus[k]);
+      vLatency.push_back(ElapsedNs(t));
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+/** \brief The ways of using the parser from several threads. */
+enum EWorkload
+{
+  wlPARSER_REUSE,  ///< Each thread reuses its own parser for all formulas
+  wlCALC,          ///< Each formula is calculated by EquationsParser::Calc
+  wlCALC_ARRAY,    ///< All formulas are calculated by EquationsParser::CalcArray
+  wlCOUNT
+};
+
+static const char *g_szWorkload[wlCOUNT] = { "parser_reuse", "calc", "calc_array" };
+
+//---------------------------------------------------------------------------
+/** \brief Calculates the scaling corpus nRounds times with the given workload.
+    \return The number of allocations made.
+*/
+unsigned long long RunWorkload(EWorkload eWorkload, int nRounds)
+{
+  unsigned long long nAllocs = GetThreadAllocCount().Count;
+
+  switch (eWorkload)
+  {
+  case wlPARSER_REUSE:
+    {
+      ParserX parser(pckALL_NON_COMPLEX);
+      for (int i = 0; i < nRounds; ++i)
+      {
+        for (std::size_t k = 0; k < g_nCalcCorpus; ++k)
+        {
+          try
+          {
+            parser.SetExpr(g_CalcCorpus[k]);
+            parser.Eval();
+          }
+          catch (ParserError &)
+          {}
+        }
+      }
+    }
+    break;
+
+  case wlCALC:
+    for (int i = 0; i < nRounds; ++i)
+    {
+      for (std::size_t k = 0; k < g_nCalcCorpus; ++k)
+        EquationsParser::Calc(g_CalcCorpus[k]);
+    }
+    break;
+
+  case wlCALC_ARRAY:
+    {
+      vector<string> vEquations(g_CalcCorpus, g_CalcCorpus + g_nCalcCorpus);
+      for (int i = 0; i < nRounds; ++i)
+      {
+        vector<string> vOut;
+        EquationsParser::CalcArray(vEquations, vOut);
+      }
+    }
+    break;
+
+  default:
+    break;
+  }
+
+  return GetThreadAllocCount().Count - nAllocs;
+}
+
+//---------------------------------------------------------------------------
+/** \brief Resource usage of the process, used as contention indicator. */
+struct ResourceUsage
+{
+  double fUserSec;   ///< CPU time spent in user mode
+  double fSysSec;    ///< CPU time spent in the kernel, e.g. waiting on futexes or mapping memory
+  long nVolCtxSw;    ///< Voluntary context switches, mostly threads blocking on locks
+  long nInvolCtxSw;  ///< Involuntary context switches, threads preempted by the scheduler
+  long nMinFlt;      ///< Minor page faults, mostly the allocator growing its arenas
+
+  ResourceUsage()
+    :fUserSec(0), fSysSec(0), nVolCtxSw(0), nInvolCtxSw(0), nMinFlt(0)
+  {
+#if defined(MUP_BENCH_RUSAGE)
+    rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0)
+    {
+      fUserSec = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec * 1e-6;
+      fSysSec = ru.ru_stime.tv_sec + ru.ru_stime.tv_usec * 1e-6;
+      nVolCtxSw = ru.ru_nvcsw;
+      nInvolCtxSw = ru.ru_nivcsw;
+      nMinFlt = ru.ru_minflt;
+    }
+#endif
+  }
+};
+
+//---------------------------------------------------------------------------
+/** \brief Runs a workload on nThreads threads at once and writes the result as JSON object.
+
+  All threads are started before the clock and released together, so that
+  thread creation is not measured. Each thread does the same amount of work,
+  the ideal throughput thus grows linearly with the number of threads.
+  \param fBaseOpsPerSec Throughput of the single thread run, 0 while measuring it.
+  \return The throughput in formulas per second.
+*/
+double MeasureScaling(ostream &os, EWorkload eWorkload, int nThreads, int nRounds, double fBaseOpsPerSec)
+{
+  std::mutex mtx;
+  std::condition_variable cvStart;
+  bool bStart = false;
+  std::atomic<int> nReady(0);
+  std::atomic<unsigned long long> nAllocs(0);
+
+  vector<std::thread> vThreads;
+  for (int i = 0; i < nThreads; ++i)
+  {
+    vThreads.push_back(std::thread([&]()
+    {
+      {
+        std::unique_lock<std::mutex> lock(mtx);
+        ++nReady;
+        cvStart.notify_all();
+        cvStart.wait(lock, [&]() { return bStart; });
+      }
+
+      nAllocs += RunWorkload(eWorkload, nRounds);
+    }));
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    cvStart.wait(lock, [&]() { return nReady == nThreads; });
+  }
+
+  ResourceUsage usageStart;
+  clock_type::time_point t = clock_type::now();
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    bStart = true;
+  }
+  cvStart.notify_all();
+
+  for (std::size_t i = 0; i < vThreads.size(); ++i)
+    vThreads[i].join();
+
+  double fWallSec = ElapsedNs(t) * 1e-9;
+  ResourceUsage usageEnd;
+
+  double fOps = (double)nThreads * nRounds * g_nCalcCorpus,
+         fOpsPerSec = (fWallSec > 0) ? fOps / fWallSec : 0,
+         fCpuSec = (usageEnd.fUserSec - usageStart.fUserSec) + (usageEnd.fSysSec - usageStart.fSysSec);
+
+  os << "{\"threads\": " << nThreads
+     << ", \"ops\": " << (unsigned long long)fOps
+     << ", \"wall_ms\": " << fWallSec * 1e3
+     << ", \"ops_per_sec\": " << fOpsPerSec
+     << ", \"efficiency\": " << ((fBaseOpsPerSec > 0) ? fOpsPerSec / (nThreads * fBaseOpsPerSec) : 1)
+     << ", \"allocs_per_op\": " << nAllocs / fOps
+     << ", \"cpu_utilization\": " << ((fWallSec > 0) ? fCpuSec / (fWallSec * nThreads) : 0)
+     << ", \"sys_fraction\": " << ((fCpuSec > 0) ? (usageEnd.fSysSec - usageStart.fSysSec) / fCpuSec : 0)
+     << ", \"voluntary_ctx_switches\": " << usageEnd.nVolCtxSw - usageStart.nVolCtxSw
+     << ", \"involuntary_ctx_switches\": " << usageEnd.nInvolCtxSw - usageStart.nInvolCtxSw
+     << ", \"minor_faults\": " << usageEnd.nMinFlt - usageStart.nMinFlt << "}";
+
+  return fOpsPerSec;
+}
+
+//---------------------------------------------------------------------------
+/** \brief Runs every workload at 1..nMaxThreads threads and writes the scaling curves as JSON. */
+void RunScaling(ostream &os, int nMaxThreads, int nRounds)
+{
+  os << "{\n  \"version\": " << JsonString(ParserX::GetVersion())
+     << ",\n  \"hardware_threads\": " << std::thread::hardware_concurrency()
+     << ",\n  \"rounds\": " << nRounds
+     << ",\n  \"formulas\": " << g_nCalcCorpus
+     << ",\n  \"workloads\": [";
+
+  for (int w = 0; w < wlCOUNT; ++w)
+  {
+    os << (w ? ",\n" : "\n") << "    {\"workload\": \"" << g_szWorkload[w] << "\", \"runs\": [";
+
+    double fBaseOpsPerSec = 0;
+    for (int n = 1; n <= nMaxThreads; ++n)
+    {
+      os << (n > 1 ? ",\n" : "\n") << "      ";
+      double fOpsPerSec = MeasureScaling(os, (EWorkload)w, n, nRounds, fBaseOpsPerSec);
+      if (n == 1)
+        fBaseOpsPerSec = fOpsPerSec;
+    }
+
+    os << "\n    ]}";
+  }
+
+  os << "\n  ]\n}" << endl;
+}
+
+//---------------------------------------------------------------------------
+void Usage(const char *szName)
+{
+  cerr << "usage: " << szName << " [-n iterations] [-r runs] [-c category] [-l label]\n"
+       << "       " << szName << " -t max_threads [-n rounds]" << endl;
+}
+
+//---------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  int nIter = 0,
+      nRuns = 1,
+      nMaxThreads = 0;
+  string_type sCategory;
+  string_type sLabel;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+      nIter = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+    {
+      string sArg(argv[++i]);
+      sCategory = string_type(sArg.begin(), sArg.end());
+    }
+    else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+      nRuns = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+    {
+      string sArg(argv[++i]);
+      sLabel = string_type(sArg.begin(), sArg.end());
+    }
+    else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+    {
+      nMaxThreads = atoi(argv[++i]);
+      if (nMaxThreads < 1)
+      {
+        Usage(argv[0]);
+        return 1;
+      }
+    }
+    else
+    {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (nIter == 0)
+    nIter = (nMaxThreads) ? 200 : 2000;
+
+  if (nIter < 1 || nRuns < 1)
+  {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  if (nMaxThreads)
+  {
+    RunScaling(cout, nMaxThreads, nIter);
+    return 0;
+  }
+
+  ParserX parser(pckALL_NON_COMPLEX);
+
+  Value a(3.5), b(-1.25), c(42);
+  parser.DefineVar(_T("a"), Variable(&a));
+  parser.DefineVar(_T("b"), Variable(&b));
+  parser.DefineVar(_T("c"), Variable(&c));
+
+  // Formulas of the selected category and the index of their category, categories
+  // in order of first appearance
+  vector<const Formula*> vFormula;
+  vector<std::size_t> vFormulaCat;
+  vector<string_type> vCategory;
+  for (std::size_t k = 0; k < sizeof(g_Corpus) / sizeof(g_Corpus[0]); ++k)
+  {
+    const Formula &f = g_Corpus[k];
+    if (sCategory.length() && sCategory != f.szCategory)
+      continue;
+
+    std::size_t iCat = std::find(vCategory.begin(), vCategory.end(), f.szCategory) - vCategory.begin();
+    if (iCat == vCategory.size())
+      vCategory.push_back(f.szCategory);
+
+    vFormula.push_back(&f);
+    vFormulaCat.push_back(iCat);
+  }
+
+  // CalcJson is measured as category of its own
+  const string_type sCalcJson = _T("calc_json");
+  bool bCalcJson = sCategory.empty() || sCategory == sCalcJson;
+
+  vector<vector<latency_vec_type> > vFormulaLatency(vFormula.size(), vector<latency_vec_type>(phCOUNT)),
+                                    vCategoryLatency(vCategory.size(), vector<latency_vec_type>(phCOUNT)),
+                                    vCategoryRunP50(vCategory.size(), vector<latency_vec_type>(phCOUNT));
+  vector<string_type> vResult(vFormula.size()),
+                      vError(vFormula.size());
+  latency_vec_type vCalcJsonLatency,
+                   vCalcJsonRunP50;
+
+  int nErrors = 0;
+  for (int r = 0; r < nRuns; ++r)
+  {
+    vector<vector<latency_vec_type> > vRunLatency(vCategory.size(), vector<latency_vec_type>(phCOUNT));
+    for (std::size_t k = 0; k < vFormula.size(); ++k)
+    {
+      if (vError[k].length())
+        continue;
+
+      latency_vec_type vLatency[phCOUNT];
+      try
+      {
+        MeasureFormula(parser, *vFormula[k], nIter, vLatency, vResult[k]);
+      }
+      catch (ParserError &e)
+      {
+        vError[k] = e.GetMsg();
+        ++nErrors;
+        continue;
+      }
+
+      for (int p = 0; p < phCOUNT; ++p)
+      {
+        vFormulaLatency[k][p].insert(vFormulaLatency[k][p].end(), vLatency[p].begin(), vLatency[p].end());
+        vRunLatency[vFormulaCat[k]][p].insert(vRunLatency[vFormulaCat[k]][p].end(), vLatency[p].begin(), vLatency[p].end());
+      }
+    }
+
+    for (std::size_t i = 0; i < vCategory.size(); ++i)
+    {
+      for (int p = 0; p < phCOUNT; ++p)
+      {
+        latency_vec_type &vRun = vRunLatency[i][p];
+        if (vRun.empty())
+          continue;
+
+        vCategoryLatency[i][p].insert(vCategoryLatency[i][p].end(), vRun.begin(), vRun.end());
+        vCategoryRunP50[i][p].push_back(Median(vRun));
+      }
+    }
+
+    if (bCalcJson)
+    {
+      latency_vec_type vRun;
+      MeasureCalcJson(nIter, vRun);
+      vCalcJsonLatency.insert(vCalcJsonLatency.end(), vRun.begin(), vRun.end());
+      vCalcJsonRunP50.push_back(Median(vRun));
+    }
+  }
+
+  ostream &os = cout;
+  os << "{\n  \"version\": " << JsonString(ParserX::GetVersion())
+     << ",\n  \"label\": " << JsonString(sLabel)
+     << ",\n  \"iterations\": " << nIter
+     << ",\n  \"runs\": " << nRuns
+     << ",\n  \"formulas\": [";
+
+  for (std::size_t k = 0; k < vFormula.size(); ++k)
+  {
+    const Formula &f = *vFormula[k];
+    os << (k ? ",\n" : "\n") << "    {\"category\": " << JsonString(f.szCategory)
+       << ", \"expr\": " << JsonString(f.szExpr);
+
+    if (vError[k].length())
+    {
+      os << ", \"error\": " << JsonString(vError[k]) << "}";
+      continue;
+    }
+
+    os << ", \"result\": " << JsonString(vResult[k]);
+    for (int p = 0; p < phCOUNT; ++p)
+    {
+      os << ", \"" << g_szPhase[p] << "\": ";
+      WriteStats(os, vFormulaLatency[k][p]);
+    }
+
+    os << "}";
+  }
+
+  os << "\n  ],\n  \"categories\": [";
+  bool bFirst = true;
+  for (std::size_t i = 0; i < vCategory.size(); ++i)
+  {
+    // Categories whose formulas all failed have no latencies
+    if (vCategoryLatency[i][0].empty())
+      continue;
+
+    os << (bFirst ? "\n" : ",\n") << "    {\"category\": " << JsonString(vCategory[i]);
+    bFirst = false;
+
+    for (int p = 0; p < phCOUNT; ++p)
+    {
+      os << ", \"" << g_szPhase[p] << "\": ";
+      WriteStats(os, vCategoryLatency[i][p], &vCategoryRunP50[i][p]);
+    }
+    os << "}";
+  }
+
+  if (bCalcJson)
+  {
+    os << (bFirst ? "\n" : ",\n") << "    {\"category\": " << JsonString(sCalcJson) << ", \"end_to_end\": ";
+    WriteStats(os, vCalcJsonLatency, &vCalcJsonRunP50);
+    os << "}";
+  }
+  os << "\n  ]\n}" << endl;
+
+  return (nErrors) ? 2 : 0;
+}
@@ -0,0 +1,458 @@
+/** \example benchcmp.cpp
+    Comparison of two results of the bench application.
+    Output: Change of the median latency of each formula category and phase,
+            with its 95% confidence interval. The exit code is 1 if a category
+            got slower by more than the threshold.
+
+<pre>
+               __________                                 ____  ___
+    _____  __ _\______   \_____ _______  ______ __________\   \/  /
+   /     \|  |  \     ___/\__  \\_  __ \/  ___// __ \_  __ \     /
+  |  Y Y  \  |  /    |     / __ \|  | \/\___ \\  ___/|  | \/     \
+  |__|_|  /____/|____|    (____  /__|  /____  >\___  >__| /___/\  \
+        \/                     \/           \/     \/           \_/
+                                       Copyright (C) 2016, Ingo Berg
+                                       All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+  NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+</pre>
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//---------------------------------------------------------------------------
+/** \brief A value of a JSON document. */
+struct JsonValue
+{
+  enum EType { jtNULL, jtBOOL, jtNUMBER, jtSTRING, jtARRAY, jtOBJECT };
+
+  EType eType;
+  double fNum;
+  string sStr;
+  vector<JsonValue> vItems;   ///< Array items or object member values
+  vector<string> vKeys;       ///< Object member names
+
+  JsonValue()
+    :eType(jtNULL), fNum(0), sStr(), vItems(), vKeys()
+  {}
+
+  /** \brief Returns an object member or 0 if there is none. */
+  const JsonValue* Find(const string &sKey) const
+  {
+    for (std::size_t i = 0; i < vKeys.size(); ++i)
+    {
+      if (vKeys[i] == sKey)
+        return &vItems[i];
+    }
+
+    return 0;
+  }
+};
+
+//---------------------------------------------------------------------------
+/** \brief Reader for the JSON documents written by the bench application. */
+class JsonReader
+{
+public:
+
+  JsonReader(const string &sText)
+    :m_sText(sText), m_nPos(0)
+  {}
+
+  JsonValue Read()
+  {
+    JsonValue val = ReadValue();
+    SkipWhitespace();
+    if (m_nPos != m_sText.length())
+      Fail("unexpected trailing characters");
+
+    return val;
+  }
+
+private:
+
+  const string &m_sText;
+  std::size_t m_nPos;
+
+  void Fail(const char *szMsg) const
+  {
+    stringstream ss;
+    ss << szMsg << " at offset " << m_nPos;
+    throw std::runtime_error(ss.str());
+  }
+
+  void SkipWhitespace()
+  {
+    while (m_nPos < m_sText.length() && isspace((unsigned char)m_sText[m_nPos]))
+      ++m_nPos;
+  }
+
+  void Expect(char c)
+  {
+    SkipWhitespace();
+    if (m_nPos >= m_sText.length() || m_sText[m_nPos] != c)
+      Fail("unexpected character");
+
+    ++m_nPos;
+  }
+
+  bool Accept(const char *szTok)
+  {
+    std::size_t n = strlen(szTok);
+    if (m_sText.compare(m_nPos, n, szTok) != 0)
+      return false;
+
+    m_nPos += n;
+    return true;
+  }
+
+  string ReadString()
+  {
+    Expect('"');
+
+    string s;
+    while (m_nPos < m_sText.length() && m_sText[m_nPos] != '"')
+    {
+      char c = m_sText[m_nPos++];
+      if (c == '\\' && m_nPos < m_sText.length())
+      {
+        c = m_sText[m_nPos++];
+        switch (c)
+        {
+        case 'n': c = '\n'; break;
+        case 't': c = '\t'; break;
+        case 'r': c = '\r'; break;
+        default:  break;
+        }
+      }
+
+      s += c;
+    }
+
+    Expect('"');
+    return s;
+  }
+
+  JsonValue ReadValue()
+  {
+    SkipWhitespace();
+    if (m_nPos >= m_sText.length())
+      Fail("unexpected end of document");
+
+    JsonValue val;
+    char c = m_sText[m_nPos];
+    if (c == '{')
+    {
+      val.eType = JsonValue::jtOBJECT;
+      ++m_nPos;
+      SkipWhitespace();
+      if (Accept("}"))
+        return val;
+
+      do
+      {
+        val.vKeys.push_back(ReadString());
+        Expect(':');
+        val.vItems.push_back(ReadValue());
+        SkipWhitespace();
+      } while (Accept(","));
+
+      Expect('}');
+    }
+    else if (c == '[')
+    {
+      val.eType = JsonValue::jtARRAY;
+      ++m_nPos;
+      SkipWhitespace();
+      if (Accept("]"))
+        return val;
+
+      do
+      {
+        val.vItems.push_back(ReadValue());
+        SkipWhitespace();
+      } while (Accept(","));
+
+      Expect(']');
+    }
+    else if (c == '"')
+    {
+      val.eType = JsonValue::jtSTRING;
+      val.sStr = ReadString();
+    }
+    else if (Accept("true"))
+    {
+      val.eType = JsonValue::jtBOOL;
+      val.fNum = 1;
+    }
+    else if (Accept("false"))
+    {
+      val.eType = JsonValue::jtBOOL;
+    }
+    else if (Accept("null"))
+    {
+      val.eType = JsonValue::jtNULL;
+    }
+    else
+    {
+      const char *szStart = m_sText.c_str() + m_nPos;
+      char *szEnd = 0;
+      val.eType = JsonValue::jtNUMBER;
+      val.fNum = strtod(szStart, &szEnd);
+      if (szEnd == szStart)
+        Fail("invalid value");
+
+      m_nPos += szEnd - szStart;
+    }
+
+    return val;
+  }
+};
+
+//---------------------------------------------------------------------------
+/** \brief Median latencies of the repeated runs of each category and phase. */
+typedef std::map<string, vector<double> > metric_maptype;
+
+//---------------------------------------------------------------------------
+/** \brief Reads a result file of the bench application.
+
+  Every phase of a category holding the median latency of each run is
+  a metric, named category/phase.
+*/
+metric_maptype ReadResult(const string &sFile, string &sLabel)
+{
+  ifstream ifs(sFile.c_str());
+  if (!ifs)
+    throw std::runtime_error("can not open " + sFile);
+
+  stringstream ss;
+  ss << ifs.rdbuf();
+  string sText = ss.str();
+  JsonValue doc = JsonReader(sText).Read();
+
+  const JsonValue *pLabel = doc.Find("label");
+  sLabel = (pLabel && pLabel->sStr.length()) ? pLabel->sStr : sFile;
+
+  const JsonValue *pCategories = doc.Find("categories");
+  if (!pCategories || pCategories->eType != JsonValue::jtARRAY)
+    throw std::runtime_error(sFile + " is not a result of the bench application");
+
+  metric_maptype mapMetric;
+  for (std::size_t i = 0; i < pCategories->vItems.size(); ++i)
+  {
+    const JsonValue &cat = pCategories->vItems[i];
+    const JsonValue *pName = cat.Find("category");
+    if (!pName)
+      continue;
+
+    for (std::size_t k = 0; k < cat.vKeys.size(); ++k)
+    {
+      const JsonValue *pRuns = cat.vItems[k].Find("runs_p50_ns");
+      if (!pRuns)
+        continue;
+
+      vector<double> &vRuns = mapMetric[pName->sStr + "/" + cat.vKeys[k]];
+      for (std::size_t r = 0; r < pRuns->vItems.size(); ++r)
+        vRuns.push_back(pRuns->vItems[r].fNum);
+    }
+  }
+
+  return mapMetric;
+}
+
+//---------------------------------------------------------------------------
+double Median(vector<double> v)
+{
+  std::size_t n = v.size() / 2;
+  std::nth_element(v.begin(), v.begin() + n, v.end());
+  if (v.size() % 2)
+    return v[n];
+
+  return (v[n] + *std::max_element(v.begin(), v.begin() + n)) / 2;
+}
+
+//---------------------------------------------------------------------------
+/** \brief Bootstrap confidence interval of the ratio of the medians of two samples.
+
+  The generator is seeded with a constant, comparing the same files always
+  gives the same interval.
+*/
+void RatioConfidenceInterval(const vector<double> &vBase, const vector<double> &vCur, double fLevel, double &fLow, double &fHigh)
+{
+  const int nResamples = 5000;
+  std::mt19937 gen(12345);
+  std::uniform_int_distribution<std::size_t> pickBase(0, vBase.size() - 1),
+                                              pickCur(0, vCur.size() - 1);
+
+  vector<double> vRatio(nResamples),
+                 vB(vBase.size()),
+                 vC(vCur.size());
+  for (int i = 0; i < nResamples; ++i)
+  {
+    for (std::size_t k = 0; k < vB.size(); ++k)
+      vB[k] = vBase[pickBase(gen)];
+
+    for (std::size_t k = 0; k < vC.size(); ++k)
+      vC[k] = vCur[pickCur(gen)];
+
+    vRatio[i] = Median(vC) / Median(vB);
+  }
+
+  std::sort(vRatio.begin(), vRatio.end());
+  fLow = vRatio[(std::size_t)((1 - fLevel) / 2 * (nResamples - 1))];
+  fHigh = vRatio[(std::size_t)((1 + fLevel) / 2 * (nResamples - 1))];
+}
+
+//---------------------------------------------------------------------------
+void Usage(const char *szName)
+{
+  cerr << "usage: " << szName << " [-t threshold_percent] [-c category=threshold_percent]... baseline.json current.json" << endl;
+}
+
+//---------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  // Minimal number of runs in each file for testing the significance of a change
+  const std::size_t nMinRuns = 3;
+
+  double fThreshold = 10;
+  std::map<string, double> mapCategoryThreshold;
+  vector<string> vFile;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+      fThreshold = atof(argv[++i]);
+    else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+    {
+      string sArg(argv[++i]);
+      std::size_t nEq = sArg.find('=');
+      if (nEq == string::npos)
+      {
+        Usage(argv[0]);
+        return 2;
+      }
+
+      mapCategoryThreshold[sArg.substr(0, nEq)] = atof(sArg.c_str() + nEq + 1);
+    }
+    else if (argv[i][0] == '-')
+    {
+      Usage(argv[0]);
+      return 2;
+    }
+    else
+      vFile.push_back(argv[i]);
+  }
+
+  if (vFile.size() != 2)
+  {
+    Usage(argv[0]);
+    return 2;
+  }
+
+  metric_maptype mapBase, mapCur;
+  string sBaseLabel, sCurLabel;
+  try
+  {
+    mapBase = ReadResult(vFile[0], sBaseLabel);
+    mapCur = ReadResult(vFile[1], sCurLabel);
+  }
+  catch (std::exception &e)
+  {
+    cerr << "error: " << e.what() << endl;
+    return 2;
+  }
+
+  ostream &os = cout;
+  os << "baseline: " << sBaseLabel << "\ncurrent:  " << sCurLabel << "\n\n";
+  os << std::left << std::setw(28) << "metric" << std::right << std::setw(14) << "base p50 ns" << std::setw(14) << "cur p50 ns"
+     << std::setw(10) << "change" << std::setw(22) << "95% CI" << "  verdict\n";
+
+  int nRegressions = 0;
+  for (metric_maptype::const_iterator it = mapBase.begin(); it != mapBase.end(); ++it)
+  {
+    const string &sMetric = it->first;
+    os << std::left << std::setw(28) << sMetric << std::right;
+
+    metric_maptype::const_iterator itCur = mapCur.find(sMetric);
+    if (it->second.empty() || itCur == mapCur.end() || itCur->second.empty())
+    {
+      os << "  missing in one of the results\n";
+      continue;
+    }
+
+    const vector<double> &vBase = it->second,
+                         &vCur = itCur->second;
+    double fBase = Median(vBase),
+           fCur = Median(vCur),
+           fChange = (fCur / fBase - 1) * 100;
+
+    string sCategory = sMetric.substr(0, sMetric.find('/'));
+    std::map<string, double>::const_iterator itThreshold = mapCategoryThreshold.find(sCategory);
+    double fLimit = (itThreshold != mapCategoryThreshold.end()) ? itThreshold->second : fThreshold;
+
+    os << std::fixed << std::setprecision(0) << std::setw(14) << fBase << std::setw(14) << fCur
+       << std::setprecision(1) << std::setw(9) << std::showpos << fChange << "%" << std::noshowpos;
+
+    // Without enough runs a change is judged by the threshold alone
+    bool bSignificant = true;
+    if (vBase.size() >= nMinRuns && vCur.size() >= nMinRuns)
+    {
+      double fLow, fHigh;
+      RatioConfidenceInterval(vBase, vCur, 0.95, fLow, fHigh);
+
+      stringstream ss;
+      ss << std::fixed << std::setprecision(1) << std::showpos << "[" << (fLow - 1) * 100 << "%, " << (fHigh - 1) * 100 << "%]";
+      os << std::setw(22) << ss.str();
+
+      bSignificant = fLow > 1 || fHigh < 1;
+    }
+    else
+      os << std::setw(22) << "too few runs";
+
+    if (bSignificant && fChange > fLimit)
+    {
+      os << "  REGRESSION (limit " << std::setprecision(1) << fLimit << "%)\n";
+      ++nRegressions;
+    }
+    else if (bSignificant && fChange < 0)
+      os << "  faster\n";
+    else
+      os << "  unchanged\n";
+  }
+
+  os << "\n" << nRegressions << " regression(s)" << endl;
+  return (nRegressions) ? 1 : 0;
+}
@@ -0,0 +1,401 @@
+/** \example microbench.cpp
+    Microbenchmark of every function and operator defined by the parser packages.
+    Output: Table of the time per call of each callback, slowest first
+
+<pre>
+               __________                                 ____  ___
+    _____  __ _\______   \_____ _______  ______ __________\   \/  /
+   /     \|  |  \     ___/\__  \\_  __ \/  ___// __ \_  __ \     /
+  |  Y Y  \  |  /    |     / __ \|  | \/\___ \\  ___/|  | \/     \
+  |__|_|  /____/|____|    (____  /__|  /____  >\___  >__| /___/\  \
+        \/                     \/           \/     \/           \_/
+                                       Copyright (C) 2016, Ingo Berg
+                                       All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+   * Redistributions of source code must retain the above copyright notice,
+     this list of conditions and the following disclaimer.
+   * Redistributions in binary form must reproduce the above copyright notice,
+     this list of conditions and the following disclaimer in the documentation
+     and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+  NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+</pre>
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//--- muparserx framework -------------------------------------------------------------------------
+#include "mpParser.h"
+
+using namespace std;
+using namespace mup;
+
+typedef std::chrono::steady_clock clock_type;
+
+//---------------------------------------------------------------------------
+/** \brief Parser giving access to the callbacks registered by its packages. */
+class Registry : public ParserX
+{
+public:
+
+  Registry(unsigned ePackages)
+    :ParserX(ePackages)
+  {}
+
+  const oprt_bin_maptype& GetOprtBinDef() const { return m_OprtDef; }
+  const oprt_ifx_maptype& GetInfixOprtDef() const { return m_InfixOprtDef; }
+  const oprt_pfx_maptype& GetPostfixOprtDef() const { return m_PostOprtDef; }
+};
+
+//---------------------------------------------------------------------------
+/** \brief A package benchmarked on its own. */
+struct Package
+{
+  unsigned eFlag;
+  const char *szName;
+};
+
+static const Package g_Packages[] =
+{
+  { pckCOMMON,      "common" },
+  { pckUNIT,        "unit" },
+  { pckCOMPLEX,     "complex" },
+  { pckNON_COMPLEX, "non_complex" },
+  { pckSTRING,      "string" },
+  { pckMATRIX,      "matrix" },
+};
+
+//---------------------------------------------------------------------------
+/** \brief Kinds of argument values tried when looking for a valid argument set.
+
+  Callbacks do not declare the types of their arguments. The harness calls
+  each callback with combinations of these values until a call succeeds. The
+  order puts the most common argument types first.
+*/
+enum EArgKind
+{
+  akINT,
+  akFLOAT,
+  akSTR,
+  akDATE_STR,
+  akTIME_STR,
+  akBOOL,
+  akMATRIX,
+  akCMPLX,
+  akDATE,
+  akVAR,
+  akCOUNT
+};
+
+static const char *g_szArgKind[akCOUNT] = { "int", "float", "str", "date_str", "time_str", "bool", "matrix", "cmplx", "date", "var" };
+
+//---------------------------------------------------------------------------
+/** \brief Creates a new argument value of the given kind. */
+ptr_val_type CreateArg(EArgKind eKind)
+{
+  switch (eKind)
+  {
+  case akINT:      return ptr_val_type(new Value((int_type)3));
+  case akFLOAT:    return ptr_val_type(new Value((float_type)0.5));
+  case akSTR:      return ptr_val_type(new Value(_T("hello world")));
+  case akDATE_STR: return ptr_val_type(new Value(_T("2024-03-15")));
+  case akTIME_STR: return ptr_val_type(new Value(_T("08:30:00")));
+  case akBOOL:     return ptr_val_type(new Value(true));
+  case akMATRIX:
+    {
+      matrix_type m(1, 3, 0.0);
+      m.At(0, 0) = 1.0;
+      m.At(0, 1) = 2.0;
+      m.At(0, 2) = 3.0;
+      return ptr_val_type(new Value(m));
+    }
+  case akCMPLX:    return ptr_val_type(new Value(cmplx_type(1, 1)));
+  case akDATE:     return ptr_val_type(new Value(date_type(19797, false)));
+  case akVAR:      return ptr_val_type(new Variable(new Value((float_type)2)));
+  default:         throw std::logic_error("invalid argument kind");
+  }
+}
+
+//---------------------------------------------------------------------------
+/** \brief Argument set of a callback and the values created from it. */
+struct ArgSet
+{
+  vector<EArgKind> vKind;
+  vector<ptr_val_type> vArg;
+
+  void Create()
+  {
+    vArg.clear();
+    for (std::size_t i = 0; i < vKind.size(); ++i)
+      vArg.push_back(CreateArg(vKind[i]));
+  }
+
+  string Describe() const
+  {
+    string s;
+    for (std::size_t i = 0; i < vKind.size(); ++i)
+      s += (i ? ", " : "") + string(g_szArgKind[vKind[i]]);
+
+    return s;
+  }
+};
+
+//---------------------------------------------------------------------------
+/** \brief Calls a callback once, returns false if it rejects the arguments. */
+bool TryEval(ICallback *pCallback, ArgSet &args)
+{
+  args.Create();
+  ptr_val_type ret(new Value());
+  try
+  {
+    pCallback->SetNumArgsPresent((int)args.vArg.size());
+    pCallback->Eval(ret, args.vArg.empty() ? 0 : &args.vArg[0], (int)args.vArg.size());
+  }
+  catch (ParserError &)
+  {
+    return false;
+  }
+  catch (std::exception &)
+  {
+    return false;
+  }
+
+  return true;
+}
+
+//---------------------------------------------------------------------------
+/** \brief Searches a valid argument set for a callback taking argc arguments.
+
+  Argument sets made of a single kind are tried first since most callbacks
+  take arguments of the same type, then all combinations of kinds.
+*/
+bool FindArgs(ICallback *pCallback, int argc, ArgSet &args)
+{
+  args.vKind.assign(argc, akINT);
+  if (argc == 0)
+    return TryEval(pCallback, args);
+
+  for (int k = 0; k < akCOUNT; ++k)
+  {
+    args.vKind.assign(argc, (EArgKind)k);
+    if (TryEval(pCallback, args))
+      return true;
+  }
+
+  // Count through all combinations, the first argument changing fastest
+  args.vKind.assign(argc, akINT);
+  for (;;)
+  {
+    if (TryEval(pCallback, args))
+      return true;
+
+    int i = 0;
+    for (; i < argc; ++i)
+    {
+      args.vKind[i] = (EArgKind)(args.vKind[i] + 1);
+      if (args.vKind[i] < akCOUNT)
+        break;
+
+      args.vKind[i] = akINT;
+    }
+
+    if (i == argc)
+      return false;
+  }
+}
+
+//---------------------------------------------------------------------------
+/** \brief Returns the time of a single call in nanoseconds.
+
+  The number of calls per batch is doubled until a batch takes at least
+  fMinBatchNs. The result is the median of several batches.
+*/
+double MeasureCallback(ICallback *pCallback, ArgSet &args, double fMinBatchNs)
+{
+  const int nBatches = 5;
+  int argc = (int)args.vArg.size();
+  const ptr_val_type *pArg = argc ? &args.vArg[0] : 0;
+  ptr_val_type ret(new Value());
+
+  pCallback->SetNumArgsPresent(argc);
+
+  long nCalls = 1;
+  vector<double> vNsPerCall;
+  while ((int)vNsPerCall.size() < nBatches)
+  {
+    clock_type::time_point t = clock_type::now();
+    for (long i = 0; i < nCalls; ++i)
+      pCallback->Eval(ret, pArg, argc);
+
+    double fNs = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - t).count();
+    if (fNs < fMinBatchNs)
+    {
+      nCalls *= 2;
+      continue;
+    }
+
+    vNsPerCall.push_back(fNs / nCalls);
+  }
+
+  std::sort(vNsPerCall.begin(), vNsPerCall.end());
+  return vNsPerCall[nBatches / 2];
+}
+
+//---------------------------------------------------------------------------
+/** \brief Result of benchmarking a callback. */
+struct Result
+{
+  string sPackage;
+  string sKind;
+  string_type sIdent;
+  string sArgs;
+  double fNsPerCall;  ///< Negative if no valid argument set was found
+};
+
+//---------------------------------------------------------------------------
+/** \brief Benchmarks all callbacks of a map. */
+template<typename TMap>
+void MeasureMap(const TMap &map, const char *szPackage, const char *szKind, const string_type &sFilter, double fMinBatchNs, vector<Result> &vResult)
+{
+  for (typename TMap::const_iterator it = map.begin(); it != map.end(); ++it)
+  {
+    if (sFilter.length() && it->first.find(sFilter) == string_type::npos)
+      continue;
+
+    ICallback *pCallback = it->second->AsICallback();
+    if (!pCallback)
+      continue;
+
+    // Variadic callbacks are measured with up to three arguments, without
+    // arguments only if they take none
+    int argc = pCallback->GetArgc();
+    vector<int> vArgc;
+    if (argc < 0)
+    {
+      for (int n = 1; n <= 3; ++n)
+        vArgc.push_back(n);
+      vArgc.push_back(0);
+    }
+    else
+      vArgc.push_back(argc);
+
+    Result res;
+    res.sPackage = szPackage;
+    res.sKind = szKind;
+    res.sIdent = it->first;
+    res.fNsPerCall = -1;
+
+    ArgSet args;
+    for (std::size_t i = 0; i < vArgc.size(); ++i)
+    {
+      if (FindArgs(pCallback, vArgc[i], args))
+      {
+        res.sArgs = args.Describe();
+        res.fNsPerCall = MeasureCallback(pCallback, args, fMinBatchNs);
+        break;
+      }
+    }
+
+    vResult.push_back(res);
+  }
+}
+
+//---------------------------------------------------------------------------
+bool SortBySlowest(const Result &a, const Result &b)
+{
+  return a.fNsPerCall > b.fNsPerCall;
+}
+
+//---------------------------------------------------------------------------
+void Usage(const char *szName)
+{
+  cerr << "usage: " << szName << " [-f name_filter] [-m min_batch_ms]" << endl;
+}
+
+//---------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  string_type sFilter;
+  double fMinBatchMs = 2;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+    {
+      string sArg(argv[++i]);
+      sFilter = string_type(sArg.begin(), sArg.end());
+    }
+    else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+      fMinBatchMs = atof(argv[++i]);
+    else
+    {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (fMinBatchMs <= 0)
+  {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  vector<Result> vResult;
+  for (std::size_t k = 0; k < sizeof(g_Packages) / sizeof(g_Packages[0]); ++k)
+  {
+    const Package &pck = g_Packages[k];
+    Registry parser(pck.eFlag);
+
+    MeasureMap(parser.GetFunDef(), pck.szName, "function", sFilter, fMinBatchMs * 1e6, vResult);
+    MeasureMap(parser.GetOprtBinDef(), pck.szName, "binary", sFilter, fMinBatchMs * 1e6, vResult);
+    MeasureMap(parser.GetInfixOprtDef(), pck.szName, "infix", sFilter, fMinBatchMs * 1e6, vResult);
+    MeasureMap(parser.GetPostfixOprtDef(), pck.szName, "postfix", sFilter, fMinBatchMs * 1e6, vResult);
+  }
+
+  std::stable_sort(vResult.begin(), vResult.end(), SortBySlowest);
+
+  ostream &os = cout;
+  os << std::left << std::setw(12) << "package" << std::setw(10) << "kind" << std::setw(16) << "name"
+     << std::setw(34) << "arguments" << std::right << std::setw(12) << "ns/call" << "\n";
+
+  int nUnmeasured = 0;
+  for (std::size_t i = 0; i < vResult.size(); ++i)
+  {
+    const Result &res = vResult[i];
+    os << std::left << std::setw(12) << res.sPackage << std::setw(10) << res.sKind << std::setw(16) << res.sIdent
+       << std::setw(34) << ((res.fNsPerCall < 0) ? "no valid arguments found" : res.sArgs) << std::right << std::setw(12);
+
+    if (res.fNsPerCall < 0)
+    {
+      os << "-";
+      ++nUnmeasured;
+    }
+    else
+      os << std::fixed << std::setprecision(1) << res.fNsPerCall;
+
+    os << "\n";
+  }
+
+  os << vResult.size() << " callbacks, " << nUnmeasured << " without valid arguments" << endl;
+  return 0;
+}
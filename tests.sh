@@ -82,9 +82,15 @@ test_eval "2 == 2 ? true : false" "true"
 test_eval "2 != 2 ? true : false" "false"
 test_eval "\"this\" == \"this\" ? \"yes\" : \"no\"" '"yes"'
 test_eval "\"this\" != \"that\" ? \"yes\" : \"no\"" '"yes"'
+test_eval '"this" == "th" // "is" && "this" != left("this!", 4) // "!"' 'true'
 test_eval "true and false" "false"
 test_eval "true or false" "true"
 test_eval "(3==3) and (3!=3)" "false"
+test_eval 'false and length(5) > 1' "false"
+test_eval 'true or length(5) > 1' "true"
+test_eval 'false or (2 > 1)' "true"
+test_eval 'true && false || true' "true"
+test_eval '(2 + 3) * (2 + 3) + (2 + 3)' '30'
 test_eval "exp(1) == e" "true"
 test_eval '((0.09/1.0)+2.58)-1.67' '1'
 test_eval '10^log(3+2)' '40.6853365119738'
@@ -104,6 +110,7 @@ test_eval "right(\"Hello World\", 5)" '"World"'
 test_eval 'left("Hello World", 5)' '"Hello"'
 test_eval 'right("Hello World", 5)' '"World"'
 test_eval 'right("Hello World", 20)' '"Hello World"'
+test_eval 'right(left("Hello World", 8), 3) // right("Hello World", -1)' '" Wo"'
 test_eval 'contains("Hello World", "orld")' 'true'
 test_eval 'contains("One Flew Over The Cuckoo'"'"'s", "koo")' 'true'
 test_eval 'contains("Hello World", "Worlds")' 'false'
@@ -130,6 +137,10 @@ test_eval 'calculate("3 > 2 ? \"higher\" : \"lower\"")' '"higher"'
 test_eval 'calculate("3 < 2 ? \"higher\" : \"lower\"")' '"lower"'
 test_eval 'calculate("concat(\"One \", concat(\"Two\", \" Three\"))")' '"One Two Three"'
 test_eval 'calculate("\"One\" // \" \" // \"Two\" // \" \" // \"Three\"")' '"One Two Three"'
+test_eval '"One" // (" " // "Two") // " " // concat("Th", "ree")' '"One Two Three"'
+# The error marker points at the operator of a chain reading the operand
+match_regex '"a" // "b" // 1 // "c"' '^parsec> {20}[^ ]'
+match_regex '"a" // ("b" // 1) // 2' '^parsec> {21}[^ ]'
 test_eval 'calculate("number(calculate(\"1 + 1\")) + 1")' '"3"'
 
 # Array tests
@@ -145,6 +156,14 @@ test_eval 'sqrt(9)+cbrt(8)+abs(-4.9812)' '9.9812'
 test_eval '10! - 5! * -(-1)' '3628680'
 test_eval 'sum(1,2,3,4,5) == max(14.99, 15)' 'true'
 test_eval 'avg(1,2,3,4,5,6,7,8,9,10) / 10' '0.55'
+test_eval 'sum({1, 2, 3, 4, 5}) + max({1, 9, 3}, 4) + min(5, {7, -2, 3}) + avg({1, 2, 3}, 6)' '25'
+test_eval 'sum(1e16, 1, -1e16, 1)' '1'
+test_eval 'sum({1e16, 1, -1e16, 1})' '1'
+test_eval 'median({5, 1, 4, 2}) + percentile({1, 2, 3, 4, 5}, 0.9)' '7.6'
+test_eval 'sort({3, 1, 2})' '{1, 2, 3}'
+test_eval 'rank({30, 10, 20, 10})' '{4, 1, 3, 1}'
+test_eval 'distinct({3, 1, 3, 2, 1})' '{1, 2, 3}'
+test_eval 'count_if({1, 5, 7, 9}, ">5") + count_if({"a", "b", "a"}, "a")' '4'
 test_eval 'round(4.62)' '5'
 test_eval 'round_decimal(4.625, 2)' '4.63'
 
@@ -155,6 +174,11 @@ test_eval 'string(5)' '"5"'
 test_eval 'string(5.123)' '"5.123"'
 test_eval 'string(4)' '"4"'
 test_eval 'string(4.5)' '"4.5"'
+test_eval 'string(1/3)' '"0.333333"'
+test_eval 'string(0.1+0.2)' '"0.3"'
+test_eval 'string(2.5e-7)' '"0"'
+test_eval '3.3*3' '9.9'
+test_eval 'avg(1, 2, 4)' '2.33333333333333'
 test_eval 'string(true)' '"true"'
 test_eval 'string(false)' '"false"'
 test_eval 'string("4")' '"4"'
@@ -170,6 +194,7 @@ test_eval 'daysdiff("2018-01-01", "2018-12-31")' '364'
 test_eval 'daysdiff("2016-01-01", "2016-12-31")' '365'
 test_eval 'daysdiff("2000-01-01", "2000-12-31")' '365'
 test_eval 'daysdiff("2100-01-01", "2100-12-31")' '364'
+test_eval 'daysdiff("2024-01-01", "2024-03-01") > 30 ? daysdiff("2024-01-01", "2024-03-01") * 2 : daysdiff("2024-01-01", "2024-03-01") * 3' '120'
 test_eval 'daysdiff("2018-01-01", "2017-12-31")' '1'
 test_eval 'hoursdiff("2018-01-01", "2018-01-02")' '24'
 test_eval 'hoursdiff("2018-01-01", "2018-1-02")' '24'
@@ -195,6 +220,19 @@ test_eval 'add_days("2019-01-01T12:30", 31)' '"2019-02-01T12:30"'
 test_eval 'add_days("2019-01-01T15:30", 1)' '"2019-01-02T15:30"'
 test_eval 'add_days("2019-01-01T08:30", 1.5)' '"2019-01-02T20:30"'
 test_eval 'add_days("2019-01-01T08:30", -1)' '"2018-12-31T08:30"'
+test_eval 'add_days("0124-01-01", 1)' '"0124-01-02"'
+test_eval 'add_days("124-01-01", 1)' 'Invalid parameters. You should use a date "yyyy-mm-dd" or date_time "yyyy-mm-ddTHH:MM" on the first parameter and a number on the second parameter.'
+test_eval 'date("24-1-1")' 'Invalid date format on parameter(s). Please use the "yyyy-mm-dd" format.'
+test_eval 'daysdiff(d"2019-01-01", add_days(date("2019-01-31T10:00"), 1))' '31'
+test_eval 'hoursdiff("2019-02-01T08:00:00", "2019-02-01T12:30:00")' '4.5'
+test_eval 'hoursdiff("2019-02-01T08:00:30", "2019-02-01T12:00")' '3.99'
+test_eval 'daysdiff("2019-02-01T08:00:00", "2019-02-03")' '2'
+test_eval 'string(datetime("2019-02-01T08:00:30"))' '"2019-02-01T08:00:30"'
+test_eval 'default_value(d"2019-01-05", "x")' '"2019-01-05"'
+test_eval 'default_value(0, d"2019-01-05")' '"2019-01-05"'
+test_eval 'number(d"2019-01-05")' '2019'
+test_eval 'mask("00000", d"2019-01-05")' '"00000"'
+test_eval 'mask("0000-00-00", d"2019-01-05")' '"0000-00-00"'
 test_eval 'timediff("02:00:00", "03:30:00")' '1.5'
 test_eval 'timediff("03:30:00", "02:00:00")' '22.5'
 test_eval 'timediff("02:00:00", "02:00:30")' '0.01'
@@ -343,6 +381,21 @@ test_eval 'weekday("2019-03-21", "invalidlocale")' 'The chosen locale is not sup
 test_eval 'weekday("2024-32-21")' 'Invalid format on the parameter(s). Please use two "yyyy-mm-dd" for dates OR two "yyyy-mm-ddTHH:MM" for date_times.'
 test_eval 'weekday("2024-09-17", "en", "one too many params")' 'Too many parameters passed to function "weekday".'
 
+# date functions over arrays of dates
+test_eval 'weekday({"2021-03-21", d"2016-03-21"}, "en")' '{"Sunday", "Monday"}'
+
+# large matrices of mostly zeros use sparse storage
+test_eval "size(zeros(100, 50)')" '{50, 100}'
+test_eval "eye(2000)'[1999, 1999]" '1'
+test_eval '(eye(2000) + eye(2000) - 2 * eye(2000))[5]' '0'
+test_eval '(3 * zeros(3000, 3000))[1, 2]' '0'
+test_eval 'eye(3000) * eye(3000)' '1'
+test_eval "{1,2,3}' + {4,5,6}'" '{5; 7; 9} '
+test_eval "{1,2,3}' - {4,5.5,6}'" '{-3; -3.5; -3} '
+test_eval "2.5 * {1,2,3}'" '{2.5; 5; 7.5} '
+test_eval "{1,2,3}' * {4,5,6}'" '32'
+test_eval 'eye(4) * ones(4,1)' '1'
+
 # Regex match test
 match_regex 'current_time(5)' '\b([01]?[0-9]|2[0-3]):[0-5][0-9]:[0-5][0-9]\b'
 match_regex 'current_time()' '\b([01]?[0-9]|2[0-3]):[0-5][0-9]:[0-5][0-9]\b'